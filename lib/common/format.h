@@ -12,6 +12,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <array>
+#include <span>
 #include <tuple>
 #include <utility>
 #include <exception>
@@ -433,6 +434,11 @@ inline void FormatHandler(std::ostringstream& out, const std::vector<T, A>& cont
     detail::FormatSequenceContainer(out, container, options);
 }
 
+template <typename T, size_t Extent>
+inline void FormatHandler(std::ostringstream& out, const std::span<T, Extent>& container, const FormatOptions& options) {
+    detail::FormatSequenceContainer(out, container, options);
+}
+
 template <typename T, typename A>
 inline void FormatHandler(std::ostringstream& out, const std::list<T, A>& container, const FormatOptions& options) {
     detail::FormatSequenceContainer(out, container, options);
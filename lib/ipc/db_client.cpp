@@ -1,5 +1,10 @@
 #include <ipc/db_client.h>
 
+#include <common/format.h>
+#include <query_builder/builders/postgres.h>
+
+#include <algorithm>
+#include <atomic>
 #include <thread>
 
 namespace NIpc {
@@ -30,6 +35,11 @@ std::pair<std::vector<std::string>, std::vector<std::string>> SplitMap(const Con
     return result;
 }
 
+NOrm::NRelation::Builder::TParameterizedQuery BuildSelect(const NOrm::NRelation::TSelect& query) {
+    NOrm::NRelation::Builder::TPostgresBuilder builder;
+    return builder.BuildParameterized(NOrm::NRelation::TSqlQueryOrganizer().OrganizeSelect(query));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // namespace
@@ -52,33 +62,671 @@ void TDataBaseConfig::Load(const nlohmann::json& data) {
         }
     }
     ASSERT(!Password.empty(), "No password provided for user '{}'", UserName);
+
+    PreparedCacheSize = TConfigBase::Load<uint32_t>(data, "prepared_cache_size", 256);
+    ASSERT(PreparedCacheSize > 0, "Prepared statement cache size must be positive");
+
+    CopyChunkSize = TConfigBase::Load<uint32_t>(data, "copy_chunk_size", 10000);
+    ASSERT(CopyChunkSize > 0, "COPY chunk size must be positive");
+
+    StreamBatchSize = TConfigBase::Load<uint32_t>(data, "stream_batch_size", 1000);
+    ASSERT(StreamBatchSize > 0, "Stream batch size must be positive");
+
+    MinConnections = TConfigBase::Load<uint32_t>(data, "min_connections", 1);
+    MaxConnections = TConfigBase::Load<uint32_t>(data, "max_connections", 8);
+    ASSERT(MaxConnections > 0, "Connection pool must allow at least one connection");
+    ASSERT(MinConnections <= MaxConnections, "min_connections ({}) exceeds max_connections ({})", MinConnections, MaxConnections);
+
+    CheckoutTimeout = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "checkout_timeout_ms", 5000));
+    IdleTimeout = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "idle_timeout_ms", 60000));
+    HealthCheckPeriod = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "health_check_period_ms", 30000));
+
+    // Больше потоков, чем соединений, все равно будут ждать соединение
+    AsyncThreads = TConfigBase::Load<uint32_t>(data, "async_threads", MaxConnections);
+    ASSERT(AsyncThreads > 0, "Async thread count must be positive");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t CopyRows(
+    pqxx::transaction_base& txn,
+    const std::string& table,
+    const std::vector<std::string>& columns,
+    const TCopyRowSource& source,
+    size_t chunkSize)
+{
+    auto columnList = Format("{onlydelim}", columns);
+
+    size_t total = 0;
+    TCopyRow row;
+    bool hasRow = source(row);
+    while (hasRow) {
+        auto stream = pqxx::stream_to::raw_table(txn, table, columnList);
+        size_t written = 0;
+        for (; hasRow && written < chunkSize; ++written) {
+            stream << row;
+            hasRow = source(row);
+        }
+        stream.complete();
+        total += written;
+        LOG_DEBUG("Copied {} rows into {}", written, table);
+    }
+
+    return total;
+}
+
+size_t CopyRows(pqxx::transaction_base& txn, const NOrm::NRelation::TCopyInsert& insert, size_t chunkSize) {
+    NOrm::NRelation::Builder::TPostgresBuilder builder;
+
+    std::vector<std::string> columns;
+    columns.reserve(insert.Columns.size());
+    for (const auto& column : insert.Columns) {
+        columns.push_back(builder.BuildClause(column));
+    }
+    return CopyRows(txn, builder.BuildClause(insert.Table), columns, insert.NextRow, chunkSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TStatementResult> ExecutePipeline(pqxx::transaction_base& txn, const std::vector<std::string>& statements) {
+    std::vector<TStatementResult> results;
+    results.reserve(statements.size());
+    if (statements.empty()) {
+        return results;
+    }
+
+    pqxx::pipeline pipeline(txn);
+    // Копим все выражения и отправляем их разом
+    pipeline.retain(static_cast<int>(statements.size()));
+
+    std::vector<pqxx::pipeline::query_id> ids;
+    ids.reserve(statements.size());
+    for (const auto& statement : statements) {
+        ids.push_back(pipeline.insert(statement));
+    }
+    pipeline.resume();
+
+    std::optional<size_t> failed;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (failed) {
+            results.emplace_back(NCommon::TException("Statement {} was not executed: statement {} failed", i, *failed));
+            continue;
+        }
+
+        try {
+            results.emplace_back(pipeline.retrieve(ids[i]));
+        } catch (const pqxx::sql_error& ex) {
+            failed = i;
+            LOG_ERROR("Pipelined statement {} of {} failed (SQLSTATE {}): {}", i, ids.size(), ex.sqlstate(), ex.what());
+            results.emplace_back(NCommon::TException(ex, "Statement {} failed", i));
+        }
+    }
+
+    if (failed) {
+        // Остальные выражения не выполнялись, ждать их результатов не нужно
+        pipeline.cancel();
+    } else {
+        pipeline.complete();
+    }
+    return results;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TCursor::TCursor(pqxx::transaction_base& txn, const std::string& query, pqxx::params&& params, size_t batchSize)
+    : Txn_(txn)
+    , BatchSize_(batchSize)
+{
+    static std::atomic<uint64_t> counter = 0;
+    Name_ = txn.quote_name(Format("orm_cursor_{}", ++counter));
+
+    Txn_.exec(Format("DECLARE {} NO SCROLL CURSOR FOR {}", Name_, query), params);
+    Open_ = true;
+}
+
+TCursor::~TCursor() {
+    try {
+        Close();
+    } catch (const std::exception& ex) {
+        LOG_WARNING("Failed to close cursor {}: {}", Name_, ex.what());
+    }
+}
+
+pqxx::result TCursor::NextBatch() {
+    if (Exhausted_) {
+        return pqxx::result();
+    }
+
+    auto batch = Txn_.exec(Format("FETCH FORWARD {} FROM {}", BatchSize_, Name_));
+    // Неполная пачка означает, что строк больше нет, лишний FETCH не нужен
+    if (batch.size() < BatchSize_) {
+        Exhausted_ = true;
+    }
+    return batch;
+}
+
+void TCursor::Close() {
+    if (Open_) {
+        Open_ = false;
+        Exhausted_ = true;
+        Txn_.exec(Format("CLOSE {}", Name_));
+    }
+}
+
+size_t StreamQuery(
+    pqxx::transaction_base& txn,
+    const std::string& query,
+    pqxx::params&& params,
+    size_t batchSize,
+    const TRowBatchCallback& onBatch)
+{
+    TCursor cursor(txn, query, std::move(params), batchSize);
+
+    size_t total = 0;
+    while (true) {
+        auto batch = cursor.NextBatch();
+        if (batch.empty()) {
+            break;
+        }
+        total += batch.size();
+        if (!onBatch(batch)) {
+            break;
+        }
+    }
+
+    cursor.Close();
+    return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TDbConnection::TDbConnection(const TDataBaseConfig& config)
+    : Conn_(Format("hostaddr={} port={} dbname={} user={} password={} requiressl={}",
+        config.HostAddr, config.Port, config.DbName, config.UserName, config.Password, config.RequireSsl))
+    , LastUsed_(std::chrono::steady_clock::now())
+    , PreparedCacheSize_(config.PreparedCacheSize)
+{}
+
+pqxx::connection& TDbConnection::Get() {
+    return Conn_;
+}
+
+bool TDbConnection::IsOpen() const {
+    return Conn_.is_open();
+}
+
+void TDbConnection::Touch() {
+    LastUsed_ = std::chrono::steady_clock::now();
+}
+
+std::chrono::steady_clock::duration TDbConnection::IdleFor() const {
+    return std::chrono::steady_clock::now() - LastUsed_;
+}
+
+pqxx::result TDbConnection::ExecutePrepared(pqxx::transaction_base& txn, const std::string& query, pqxx::params&& params) {
+    const auto& name = GetPreparedStatement(query);
+    return txn.exec_prepared(name, params);
+}
+
+void TDbConnection::DeallocateEvicted() {
+    if (EvictedStatements_.empty()) {
+        return;
+    }
+
+    // Без транзакции каждое выражение выполняется само по себе, и ошибка
+    // на одном имени не мешает удалить остальные
+    pqxx::nontransaction txn(Conn_);
+    for (const auto& name : EvictedStatements_) {
+        try {
+            txn.exec(Format("DEALLOCATE {}", txn.quote_name(name)));
+        } catch (const std::exception& ex) {
+            LOG_WARNING("Failed to deallocate prepared statement {}: {}", name, ex.what());
+        }
+    }
+    EvictedStatements_.clear();
+}
+
+const std::string& TDbConnection::GetPreparedStatement(const std::string& query) {
+    auto it = PreparedStatements_.find(query);
+    if (it != PreparedStatements_.end()) {
+        PreparedLru_.splice(PreparedLru_.begin(), PreparedLru_, it->second.LruPosition);
+        return it->second.Name;
+    }
+
+    if (PreparedStatements_.size() >= PreparedCacheSize_) {
+        EvictPreparedStatement();
+    }
+
+    auto name = Format("orm_stmt_{}", ++PreparedCounter_);
+    Conn_.prepare(name, query);
+    LOG_DEBUG("Prepared statement {}: {}", name, query);
+
+    PreparedLru_.push_front(query);
+    auto [inserted, _] = PreparedStatements_.emplace(query, TPreparedStatement{std::move(name), PreparedLru_.begin()});
+    return inserted->second.Name;
+}
+
+void TDbConnection::EvictPreparedStatement() {
+    auto it = PreparedStatements_.find(PreparedLru_.back());
+    // Имена не переиспользуются, поэтому удалить выражение на сервере можно позже
+    EvictedStatements_.push_back(std::move(it->second.Name));
+    PreparedStatements_.erase(it);
+    PreparedLru_.pop_back();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+TDbConnectionLease::TDbConnectionLease(TDbConnectionPoolPtr pool, std::unique_ptr<TDbConnection> connection)
+    : Pool_(std::move(pool))
+    , Connection_(std::move(connection))
+{}
+
+TDbConnectionLease& TDbConnectionLease::operator=(TDbConnectionLease&& other) noexcept {
+    if (this != &other) {
+        Release();
+        Pool_ = std::move(other.Pool_);
+        Connection_ = std::move(other.Connection_);
+    }
+    return *this;
+}
+
+TDbConnectionLease::~TDbConnectionLease() {
+    Release();
+}
+
+TDbConnection& TDbConnectionLease::operator*() const {
+    ASSERT(Connection_, "Connection lease is empty");
+    return *Connection_;
+}
+
+TDbConnection* TDbConnectionLease::operator->() const {
+    ASSERT(Connection_, "Connection lease is empty");
+    return Connection_.get();
+}
+
+TDbConnectionLease::operator bool() const {
+    return static_cast<bool>(Connection_);
+}
+
+void TDbConnectionLease::Release() {
+    if (Pool_ && Connection_) {
+        Pool_->Release(std::move(Connection_));
+    }
+    Connection_.reset();
+    Pool_.reset();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-TDbClient::TDbClient(TDataBaseConfigPtr config)
-    : Config_(config) {}
+TDbConnectionPool::TDbConnectionPool(TDataBaseConfigPtr config, NCommon::TInvokerPtr invoker)
+    : Config_(std::move(config))
+    , Invoker_(std::move(invoker))
+{}
+
+void TDbConnectionPool::Start() {
+    Maintain();
+    LOG_INFO("Connection pool started: {} connections to {}", GetTotalCount(), Config_->DbName);
+
+    if (Invoker_) {
+        MaintenanceExecutor_ = NCommon::New<NCommon::TPeriodicExecutor>(
+            NCommon::Bind(&TDbConnectionPool::Maintain, MakeWeak(this)),
+            Invoker_,
+            Config_->HealthCheckPeriod
+        );
+        MaintenanceExecutor_->Start();
+    }
+}
+
+void TDbConnectionPool::Stop() {
+    if (MaintenanceExecutor_) {
+        MaintenanceExecutor_->Stop();
+        MaintenanceExecutor_.reset();
+    }
+
+    std::deque<std::unique_ptr<TDbConnection>> idle;
+    {
+        auto guard = std::lock_guard(Mutex_);
+        Stopped_ = true;
+        Total_ -= Idle_.size();
+        idle.swap(Idle_);
+    }
+    CondVar_.notify_all();
+}
+
+TDbConnectionLease TDbConnectionPool::Acquire() {
+    return Acquire(Config_->CheckoutTimeout);
+}
+
+TDbConnectionLease TDbConnectionPool::Acquire(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    std::unique_ptr<TDbConnection> connection;
+    {
+        auto lock = std::unique_lock(Mutex_);
+        if (Stopped_) {
+            THROW("Connection pool is stopped");
+        }
+
+        auto ticket = NextTicket_++;
+        Waiters_.push_back(ticket);
+
+        // Соединение получает только первый в очереди, поэтому ожидающие обслуживаются по порядку
+        bool ready = CondVar_.wait_until(lock, deadline, [&] {
+            return Stopped_ || (Waiters_.front() == ticket && (!Idle_.empty() || Total_ < Config_->MaxConnections));
+        });
+
+        if (!ready || Stopped_) {
+            Waiters_.erase(std::find(Waiters_.begin(), Waiters_.end(), ticket));
+            lock.unlock();
+            CondVar_.notify_all();
+            if (!ready) {
+                THROW("Timed out after {} ms waiting for database connection", timeout.count());
+            }
+            THROW("Connection pool is stopped");
+        }
+
+        Waiters_.pop_front();
+        if (!Idle_.empty()) {
+            connection = std::move(Idle_.back());
+            Idle_.pop_back();
+        } else {
+            // Место под новое соединение резервируется заранее, само подключение идет без блокировки
+            ++Total_;
+        }
+    }
+    CondVar_.notify_all();
+
+    if (connection && !CheckHealth(*connection)) {
+        LOG_WARNING("Dropping unhealthy connection to {}", Config_->DbName);
+        connection.reset();
+    }
+
+    if (!connection) {
+        try {
+            connection = std::make_unique<TDbConnection>(*Config_);
+        } catch (const std::exception& ex) {
+            {
+                auto guard = std::lock_guard(Mutex_);
+                --Total_;
+            }
+            CondVar_.notify_all();
+            RETHROW(ex, "Database connection failed");
+        }
+    }
+
+    return TDbConnectionLease(TDbConnectionPoolPtr(this), std::move(connection));
+}
+
+void TDbConnectionPool::Release(std::unique_ptr<TDbConnection> connection) {
+    bool keep = connection->IsOpen();
+    if (keep) {
+        // Транзакция на соединении уже завершена
+        try {
+            connection->DeallocateEvicted();
+        } catch (const std::exception& ex) {
+            LOG_WARNING("Failed to clean up prepared statements: {}", ex.what());
+        }
+        keep = connection->IsOpen();
+    }
+    if (keep) {
+        connection->Touch();
+    }
+
+    {
+        auto guard = std::lock_guard(Mutex_);
+        if (keep && !Stopped_) {
+            Idle_.push_back(std::move(connection));
+        } else {
+            --Total_;
+        }
+    }
+    CondVar_.notify_all();
+}
+
+bool TDbConnectionPool::CheckHealth(TDbConnection& connection) {
+    if (!connection.IsOpen()) {
+        return false;
+    }
+
+    // Недавно использованное соединение считаем живым, чтобы не делать лишний запрос на каждую выдачу
+    if (connection.IdleFor() < Config_->HealthCheckPeriod) {
+        return true;
+    }
+
+    try {
+        pqxx::nontransaction txn(connection.Get());
+        txn.exec("SELECT 1");
+        connection.Touch();
+        return true;
+    } catch (const std::exception& ex) {
+        LOG_WARNING("Health check failed: {}", ex.what());
+        return false;
+    }
+}
+
+void TDbConnectionPool::Maintain() {
+    std::vector<std::unique_ptr<TDbConnection>> expired;
+    {
+        auto guard = std::lock_guard(Mutex_);
+        // Самые старые из свободных соединений лежат в начале очереди
+        while (!Idle_.empty() && Total_ > Config_->MinConnections && Idle_.front()->IdleFor() >= Config_->IdleTimeout) {
+            expired.push_back(std::move(Idle_.front()));
+            Idle_.pop_front();
+            --Total_;
+        }
+    }
+
+    if (!expired.empty()) {
+        LOG_DEBUG("Closing {} idle connections", expired.size());
+        expired.clear();
+    }
+
+    while (true) {
+        {
+            auto guard = std::lock_guard(Mutex_);
+            if (Stopped_ || Total_ >= Config_->MinConnections) {
+                break;
+            }
+            ++Total_;
+        }
+
+        try {
+            Release(std::make_unique<TDbConnection>(*Config_));
+        } catch (const std::exception& ex) {
+            {
+                auto guard = std::lock_guard(Mutex_);
+                --Total_;
+            }
+            CondVar_.notify_all();
+            LOG_ERROR("Failed to open pooled connection: {}", ex.what());
+            break;
+        }
+    }
+}
+
+size_t TDbConnectionPool::GetTotalCount() const {
+    auto guard = std::lock_guard(Mutex_);
+    return Total_;
+}
+
+size_t TDbConnectionPool::GetIdleCount() const {
+    auto guard = std::lock_guard(Mutex_);
+    return Idle_.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TQueryCanceler::Cancel() {
+    auto guard = std::lock_guard(Mutex_);
+    if (Canceled_) {
+        return;
+    }
+    Canceled_ = true;
+
+    if (Connection_) {
+        try {
+            Connection_->cancel_query();
+        } catch (const std::exception& ex) {
+            LOG_WARNING("Failed to cancel query: {}", ex.what());
+        }
+    }
+}
+
+bool TQueryCanceler::IsCanceled() const {
+    auto guard = std::lock_guard(Mutex_);
+    return Canceled_;
+}
+
+bool TQueryCanceler::Attach(pqxx::connection* connection) {
+    auto guard = std::lock_guard(Mutex_);
+    if (Canceled_) {
+        return false;
+    }
+    Connection_ = connection;
+    return true;
+}
+
+void TQueryCanceler::Detach() {
+    auto guard = std::lock_guard(Mutex_);
+    Connection_ = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TDbClient::TDbClient(TDataBaseConfigPtr config, NCommon::TInvokerPtr invoker)
+    : Config_(std::move(config))
+    , Invoker_(std::move(invoker))
+{}
 
 void TDbClient::Connect() {
     try {
-        Conn_ = std::make_unique<pqxx::connection>(
-            NCommon::Format("hostaddr={} port={} dbname={} user={} password={} requiressl={}",
-                Config_->HostAddr, Config_->Port, Config_->DbName, Config_->UserName, Config_->Password, Config_->RequireSsl));
+        if (Pool_) {
+            Pool_->Stop();
+        }
+        Pool_ = NCommon::New<TDbConnectionPool>(Config_, Invoker_);
+        Pool_->Start();
+        if (!AsyncInvoker_) {
+            AsyncThreadPool_ = NCommon::New<NCommon::TThreadPool>(Config_->AsyncThreads);
+            AsyncInvoker_ = NCommon::New<NCommon::TInvoker>(AsyncThreadPool_);
+        }
         LOG_INFO("Connected to PostgreSQL database: {}", Config_->DbName);
     } catch (const std::exception& ex) {
         RETHROW(ex, "Database connection failed");
     }
 }
 
+pqxx::result TDbClient::ExecuteQuery(const std::string& query, pqxx::params&& params) {
+    ASSERT(Pool_, "Client is not connected");
+    try {
+        auto lease = Pool_->Acquire();
+        pqxx::work txn(lease->Get());
+        auto res = txn.exec(query, params);
+        txn.commit();
+        return res;
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Parameterized query failed: {}", ex.what());
+        throw;
+    }
+}
+
+std::future<TStatementResult> TDbClient::ExecuteQueryAsync(
+    const std::string& query,
+    const TQueryParams& params,
+    std::optional<std::chrono::milliseconds> timeout,
+    TQueryCancelerPtr canceler)
+{
+    ASSERT(Pool_ && AsyncInvoker_, "Client is not connected");
+
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (timeout) {
+        deadline = std::chrono::steady_clock::now() + *timeout;
+    }
+
+    // Задача не захватывает клиент: пул потоков принадлежит ему и не может
+    // быть уничтожен из собственного потока
+    return AsyncInvoker_->Run([pool = Pool_, query, params, deadline, canceler] () -> pqxx::result {
+        auto remaining = [&] {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+        };
+
+        if (canceler && canceler->IsCanceled()) {
+            THROW("Query was canceled before execution");
+        }
+        if (deadline && remaining().count() <= 0) {
+            THROW("Query deadline exceeded before execution");
+        }
+
+        auto lease = deadline ? pool->Acquire(remaining()) : pool->Acquire();
+        pqxx::work txn(lease->Get());
+
+        if (deadline) {
+            auto left = remaining().count();
+            if (left <= 0) {
+                THROW("Query deadline exceeded while waiting for connection");
+            }
+            txn.exec(Format("SET LOCAL statement_timeout = {}", left));
+        }
+
+        pqxx::params queryParams;
+        for (const auto& param : params) {
+            queryParams.append(param);
+        }
+
+        if (canceler && !canceler->Attach(&lease->Get())) {
+            THROW("Query was canceled before execution");
+        }
+
+        try {
+            auto res = txn.exec(query, queryParams);
+            if (canceler) {
+                canceler->Detach();
+            }
+            txn.commit();
+            return res;
+        } catch (const pqxx::query_canceled& ex) {
+            if (canceler) {
+                canceler->Detach();
+            }
+            if (canceler && canceler->IsCanceled()) {
+                RETHROW(ex, "Query was canceled");
+            }
+            RETHROW(ex, "Query deadline exceeded");
+        } catch (...) {
+            if (canceler) {
+                canceler->Detach();
+            }
+            throw;
+        }
+    });
+}
+
+pqxx::result TDbClient::ExecutePrepared(const std::string& query, const TQueryParams& params) {
+    ASSERT(Pool_, "Client is not connected");
+
+    pqxx::params queryParams;
+    for (const auto& param : params) {
+        queryParams.append(param);
+    }
+
+    try {
+        auto lease = Pool_->Acquire();
+        pqxx::work txn(lease->Get());
+        auto res = lease->ExecutePrepared(txn, query, std::move(queryParams));
+        txn.commit();
+        return res;
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Prepared query failed: {}", ex.what());
+        throw;
+    }
+}
+
 void TDbClient::InsertRow(const std::string& table, const TParamMap& columns) {
     auto splited = SplitMap(columns);
 
     ExecuteQueryR(
-        NCommon::Format(
-            "INSERT INTO {} ({}) VALUES ({})",
-            table, NCommon::Join(splited.first, ", "), CreatePlaceHolders(columns.size())),
+        Format(
+            "INSERT INTO {} ({onlydelim}) VALUES ({})",
+            table, splited.first, CreatePlaceHolders(columns.size())),
         splited.second
     );
 }
@@ -116,99 +764,245 @@ pqxx::result TDbClient::SelectRows(const std::string& table,
     return ExecuteQuery(query);
 }
 
-TTransaction TDbClient::BeginTransaction() {
-    std::lock_guard<std::mutex> lock(Mutex_);
-    if (Txn_) {
-        THROW("Another transaction is already active");
-    }
-    
+size_t TDbClient::CopyRows(const std::string& table, const std::vector<std::string>& columns, const TCopyRowSource& source) {
+    ASSERT(Pool_, "Client is not connected");
     try {
-        Txn_ = std::make_shared<pqxx::transaction<>>(*Conn_);
-        LOG_DEBUG("Transaction started");
-        return TTransaction(NCommon::TIntrusivePtr<TDbClient>(this), Txn_);
+        auto lease = Pool_->Acquire();
+        pqxx::work txn(lease->Get());
+        auto count = NIpc::CopyRows(txn, table, columns, source, Config_->CopyChunkSize);
+        txn.commit();
+        return count;
     } catch (const std::exception& ex) {
-        RETHROW(ex, "Failed to begin transaction");
+        LOG_ERROR("COPY into {} failed: {}", table, ex.what());
+        throw;
     }
 }
 
-TTransaction TDbClient::BeginTransactionWithTimeout(std::chrono::milliseconds timeout) {
-    auto endTime = std::chrono::steady_clock::now() + timeout;
-    
-    while (true) {
-        {
-            std::unique_lock<std::mutex> lock(Mutex_);
-            if (!Txn_) {
-                try {
-                    Txn_ = std::make_shared<pqxx::transaction<>>(*Conn_);
-                    LOG_DEBUG("Transaction started after waiting");
-                    return TTransaction(NCommon::TIntrusivePtr<TDbClient>(this), Txn_);
-                } catch (const std::exception& ex) {
-                    RETHROW(ex, "Failed to begin transaction");
-                }
-            }
-            
-            if (std::chrono::steady_clock::now() >= endTime) {
-                THROW("Timed out waiting for previous transaction to complete");
-            }
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+size_t TDbClient::CopyRows(const NOrm::NRelation::TCopyInsert& insert) {
+    ASSERT(Pool_, "Client is not connected");
+    try {
+        auto lease = Pool_->Acquire();
+        pqxx::work txn(lease->Get());
+        auto count = NIpc::CopyRows(txn, insert, Config_->CopyChunkSize);
+        txn.commit();
+        return count;
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Bulk COPY insert failed: {}", ex.what());
+        throw;
     }
 }
 
-void TDbClient::Commit() {
-    std::lock_guard<std::mutex> lock(Mutex_);
-    if (!Txn_) {
-        THROW("No active transaction to commit");
+size_t TDbClient::StreamQuery(const std::string& query, const TQueryParams& params, const TRowBatchCallback& onBatch) {
+    ASSERT(Pool_, "Client is not connected");
+
+    pqxx::params queryParams;
+    for (const auto& param : params) {
+        queryParams.append(param);
     }
-    
+
     try {
-        Txn_->commit();
-        LOG_DEBUG("Transaction committed");
-        Txn_.reset();
+        auto lease = Pool_->Acquire();
+        // Курсор без WITH HOLD живет только внутри транзакции
+        pqxx::work txn(lease->Get());
+        auto count = NIpc::StreamQuery(txn, query, std::move(queryParams), Config_->StreamBatchSize, onBatch);
+        txn.commit();
+        return count;
     } catch (const std::exception& ex) {
-        RETHROW(ex, "Failed to commit transaction");
+        LOG_ERROR("Streaming query failed: {}", ex.what());
+        throw;
     }
 }
 
-void TDbClient::Rollback() {
-    std::lock_guard<std::mutex> lock(Mutex_);
-    if (!Txn_) {
-        THROW("No active transaction to rollback");
+size_t TDbClient::StreamQuery(const NOrm::NRelation::TSelect& query, const TRowBatchCallback& onBatch) {
+    auto built = BuildSelect(query);
+    return StreamQuery(built.Query, built.Params, onBatch);
+}
+
+std::vector<TStatementResult> TDbClient::ExecutePipeline(const std::vector<std::string>& statements) {
+    ASSERT(Pool_, "Client is not connected");
+    try {
+        auto lease = Pool_->Acquire();
+        pqxx::work txn(lease->Get());
+        auto results = NIpc::ExecutePipeline(txn, statements);
+
+        bool succeeded = std::all_of(results.begin(), results.end(), [] (const auto& result) {
+            return static_cast<bool>(result);
+        });
+        if (succeeded) {
+            txn.commit();
+        } else {
+            txn.abort();
+        }
+        return results;
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Pipeline of {} statements failed: {}", statements.size(), ex.what());
+        throw;
     }
-    
+}
+
+TTransaction TDbClient::BeginTransaction() {
+    return BeginTransactionWithTimeout(Config_->CheckoutTimeout);
+}
+
+TTransaction TDbClient::BeginTransactionWithTimeout(std::chrono::milliseconds timeout) {
+    ASSERT(Pool_, "Client is not connected");
     try {
-        Txn_->abort();
-        LOG_DEBUG("Transaction rolled back");
-        Txn_.reset();
+        return TTransaction(Pool_->Acquire(timeout), Config_);
     } catch (const std::exception& ex) {
-        RETHROW(ex, "Failed to rollback transaction");
+        RETHROW(ex, "Failed to begin transaction");
     }
 }
 
+TDbConnectionPoolPtr TDbClient::GetPool() const {
+    return Pool_;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-TTransaction::TTransaction(TDbClientPtr client, std::shared_ptr<pqxx::transaction<>> Txn)
-    : Client_(std::move(client)),
-      Txn_(Txn)
-{}
+TTransaction::TTransaction(TDbConnectionLease lease, TDataBaseConfigPtr config)
+    : Lease_(std::move(lease))
+    , Txn_(std::make_unique<pqxx::work>(Lease_->Get()))
+    , Config_(std::move(config))
+{
+    LOG_DEBUG("Transaction started");
+}
 
 TTransaction::~TTransaction() {
     try {
-        if (Client_ && Client_->Txn_ && Client_->Txn_ == Txn_) {
+        if (Txn_) {
             LOG_WARNING("Transaction was not explicitly committed or rolled back, rolling back");
-            Client_->Rollback();
+            Rollback();
         }
     } catch (const std::exception& ex) {
         LOG_ERROR("Failed to rollback transaction in destructor: {}", ex.what());
     }
 }
 
+pqxx::result TTransaction::ExecuteQuery(const std::string& query, pqxx::params&& params) {
+    ASSERT(Txn_, "No active transaction");
+    try {
+        return Txn_->exec(query, params);
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Parameterized query failed: {}", ex.what());
+        throw;
+    }
+}
+
+pqxx::result TTransaction::ExecutePrepared(const std::string& query, const TQueryParams& params) {
+    ASSERT(Txn_, "No active transaction");
+
+    pqxx::params queryParams;
+    for (const auto& param : params) {
+        queryParams.append(param);
+    }
+
+    try {
+        return Lease_->ExecutePrepared(*Txn_, query, std::move(queryParams));
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Prepared query failed: {}", ex.what());
+        throw;
+    }
+}
+
+size_t TTransaction::CopyRows(const std::string& table, const std::vector<std::string>& columns, const TCopyRowSource& source) {
+    ASSERT(Txn_, "No active transaction");
+    try {
+        return NIpc::CopyRows(*Txn_, table, columns, source, Config_->CopyChunkSize);
+    } catch (const std::exception& ex) {
+        LOG_ERROR("COPY into {} failed: {}", table, ex.what());
+        throw;
+    }
+}
+
+size_t TTransaction::CopyRows(const NOrm::NRelation::TCopyInsert& insert) {
+    ASSERT(Txn_, "No active transaction");
+    try {
+        return NIpc::CopyRows(*Txn_, insert, Config_->CopyChunkSize);
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Bulk COPY insert failed: {}", ex.what());
+        throw;
+    }
+}
+
+size_t TTransaction::StreamQuery(const std::string& query, const TQueryParams& params, const TRowBatchCallback& onBatch) {
+    ASSERT(Txn_, "No active transaction");
+
+    pqxx::params queryParams;
+    for (const auto& param : params) {
+        queryParams.append(param);
+    }
+
+    try {
+        return NIpc::StreamQuery(*Txn_, query, std::move(queryParams), Config_->StreamBatchSize, onBatch);
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Streaming query failed: {}", ex.what());
+        throw;
+    }
+}
+
+size_t TTransaction::StreamQuery(const NOrm::NRelation::TSelect& query, const TRowBatchCallback& onBatch) {
+    auto built = BuildSelect(query);
+    return StreamQuery(built.Query, built.Params, onBatch);
+}
+
+std::unique_ptr<TCursor> TTransaction::OpenCursor(const std::string& query, const TQueryParams& params) {
+    ASSERT(Txn_, "No active transaction");
+
+    pqxx::params queryParams;
+    for (const auto& param : params) {
+        queryParams.append(param);
+    }
+
+    return std::make_unique<TCursor>(*Txn_, query, std::move(queryParams), Config_->StreamBatchSize);
+}
+
+std::unique_ptr<TCursor> TTransaction::OpenCursor(const NOrm::NRelation::TSelect& query) {
+    auto built = BuildSelect(query);
+    return OpenCursor(built.Query, built.Params);
+}
+
+std::vector<TStatementResult> TTransaction::ExecutePipeline(const std::vector<std::string>& statements) {
+    ASSERT(Txn_, "No active transaction");
+    try {
+        return NIpc::ExecutePipeline(*Txn_, statements);
+    } catch (const std::exception& ex) {
+        LOG_ERROR("Pipeline of {} statements failed: {}", statements.size(), ex.what());
+        throw;
+    }
+}
+
 void TTransaction::Commit() {
-    Client_->Commit();
+    if (!Txn_) {
+        THROW("No active transaction to commit");
+    }
+
+    try {
+        Txn_->commit();
+        LOG_DEBUG("Transaction committed");
+        Txn_.reset();
+        Lease_.Release();
+    } catch (const std::exception& ex) {
+        Txn_.reset();
+        Lease_.Release();
+        RETHROW(ex, "Failed to commit transaction");
+    }
 }
 
 void TTransaction::Rollback() {
-    Client_->Rollback();
+    if (!Txn_) {
+        THROW("No active transaction to rollback");
+    }
+
+    try {
+        Txn_->abort();
+        LOG_DEBUG("Transaction rolled back");
+        Txn_.reset();
+        Lease_.Release();
+    } catch (const std::exception& ex) {
+        Txn_.reset();
+        Lease_.Release();
+        RETHROW(ex, "Failed to rollback transaction");
+    }
 }
 
 
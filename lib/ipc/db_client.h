@@ -4,8 +4,20 @@
 #include <common/logging.h>
 #include <common/exception.h>
 #include <common/config.h>
+#include <common/periodic_executor.h>
+#include <common/threadpool.h>
+#include <common/weak_ptr.h>
+#include <query_builder/copy_row.h>
+#include <query_builder/organizers/sql_organizer.h>
 
 #include <pqxx/pqxx>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <optional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -26,6 +38,24 @@ struct TDataBaseConfig
     std::string UserName;
     std::string Password;
 
+    // Максимальное число подготовленных выражений на одно соединение
+    uint32_t PreparedCacheSize;
+
+    // Число строк в одном COPY при потоковой загрузке
+    uint32_t CopyChunkSize;
+    // Число строк в одной пачке при потоковом чтении
+    uint32_t StreamBatchSize;
+
+    // Параметры пула соединений
+    uint32_t MinConnections;
+    uint32_t MaxConnections;
+    std::chrono::milliseconds CheckoutTimeout;
+    std::chrono::milliseconds IdleTimeout;
+    std::chrono::milliseconds HealthCheckPeriod;
+
+    // Число потоков, выполняющих асинхронные запросы
+    uint32_t AsyncThreads;
+
     void Load(const nlohmann::json& data) override;
 };
 
@@ -33,6 +63,220 @@ DECLARE_REFCOUNTED(TDataBaseConfig);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Соединение с базой и кэш подготовленных на нем выражений
+class TDbConnection {
+public:
+    explicit TDbConnection(const TDataBaseConfig& config);
+
+    TDbConnection(const TDbConnection&) = delete;
+    TDbConnection& operator=(const TDbConnection&) = delete;
+
+    pqxx::connection& Get();
+    bool IsOpen() const;
+
+    void Touch();
+    std::chrono::steady_clock::duration IdleFor() const;
+
+    // Выполняет запрос с плейсхолдерами $1..$n через подготовленное выражение.
+    // Выражение подготавливается один раз на соединение и переиспользуется
+    // для всех запросов с тем же текстом.
+    pqxx::result ExecutePrepared(pqxx::transaction_base& txn, const std::string& query, pqxx::params&& params);
+
+    // Удаляет на сервере выражения, вытесненные из кэша. Вызывается, когда
+    // на соединении нет открытой транзакции
+    void DeallocateEvicted();
+
+private:
+    struct TPreparedStatement {
+        std::string Name;
+        std::list<std::string>::iterator LruPosition;
+    };
+
+    const std::string& GetPreparedStatement(const std::string& query);
+    void EvictPreparedStatement();
+
+    pqxx::connection Conn_;
+    std::chrono::steady_clock::time_point LastUsed_;
+
+    uint32_t PreparedCacheSize_;
+    std::unordered_map<std::string, TPreparedStatement> PreparedStatements_;
+    std::list<std::string> PreparedLru_;
+    uint64_t PreparedCounter_ = 0;
+    // DEALLOCATE внутри транзакции пользователя при ошибке оборвал бы ее,
+    // поэтому вытесненные выражения удаляются после ее завершения
+    std::vector<std::string> EvictedStatements_;
+
+    inline static const std::string LoggingSource = "Client";
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+using NOrm::NRelation::TCopyRow;
+using NOrm::NRelation::TCopyRowSource;
+
+// Потоковая загрузка строк через COPY ... FROM STDIN в рамках транзакции.
+// Строки запрашиваются у источника по одной, каждые chunkSize строк
+// завершают текущий COPY, чтобы ограничить объем буферизованных данных.
+size_t CopyRows(
+    pqxx::transaction_base& txn,
+    const std::string& table,
+    const std::vector<std::string>& columns,
+    const TCopyRowSource& source,
+    size_t chunkSize);
+
+// То же для вставки из TSqlQueryOrganizer::OrganizeCopyInsert,
+// имена таблицы и колонок строит TPostgresBuilder
+size_t CopyRows(pqxx::transaction_base& txn, const NOrm::NRelation::TCopyInsert& insert, size_t chunkSize);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Серверный курсор для чтения результата запроса пачками.
+// Живет в рамках транзакции и должен быть закрыт до ее завершения.
+class TCursor {
+public:
+    TCursor(pqxx::transaction_base& txn, const std::string& query, pqxx::params&& params, size_t batchSize);
+
+    TCursor(const TCursor&) = delete;
+    TCursor& operator=(const TCursor&) = delete;
+
+    ~TCursor();
+
+    // Возвращает очередную пачку строк, пустой результат означает конец выборки
+    pqxx::result NextBatch();
+    void Close();
+
+private:
+    pqxx::transaction_base& Txn_;
+    std::string Name_;
+    size_t BatchSize_;
+    bool Exhausted_ = false;
+    bool Open_ = false;
+
+    inline static const std::string LoggingSource = "Client";
+};
+
+// Вызывается для каждой пачки строк, false прекращает чтение
+using TRowBatchCallback = std::function<bool(const pqxx::result&)>;
+
+// Читает результат запроса через курсор, возвращает число прочитанных строк
+size_t StreamQuery(
+    pqxx::transaction_base& txn,
+    const std::string& query,
+    pqxx::params&& params,
+    size_t batchSize,
+    const TRowBatchCallback& onBatch);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Результат выражения из конвейера: строки или ошибка именно этого выражения
+using TStatementResult = NCommon::TErrorOr<pqxx::result>;
+
+// Отправляет выражения через pqxx::pipeline, не дожидаясь ответа на каждое,
+// и собирает результаты в исходном порядке. Ошибка приписывается выражению,
+// на котором она возникла. Следующие за ним выражения сервер не выполняет,
+// для них возвращается ошибка со ссылкой на упавшее выражение.
+// Выражения должны быть без плейсхолдеров, например из TBuilderBase::BuildStatements.
+std::vector<TStatementResult> ExecutePipeline(pqxx::transaction_base& txn, const std::vector<std::string>& statements);
+
+////////////////////////////////////////////////////////////////////////////////
+
+class TDbConnectionPool;
+DECLARE_REFCOUNTED(TDbConnectionPool);
+
+// Соединение, взятое из пула. Возвращается в пул при разрушении.
+class TDbConnectionLease {
+public:
+    TDbConnectionLease() = default;
+    TDbConnectionLease(TDbConnectionPoolPtr pool, std::unique_ptr<TDbConnection> connection);
+
+    TDbConnectionLease(TDbConnectionLease&& other) noexcept = default;
+    TDbConnectionLease& operator=(TDbConnectionLease&& other) noexcept;
+
+    ~TDbConnectionLease();
+
+    TDbConnection& operator*() const;
+    TDbConnection* operator->() const;
+    explicit operator bool() const;
+
+    void Release();
+
+private:
+    TDbConnectionPoolPtr Pool_;
+    std::unique_ptr<TDbConnection> Connection_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class TDbConnectionPool : public NRefCounted::TRefCountedBase {
+public:
+    // Если передан invoker, обслуживание пула (вытеснение простаивающих
+    // соединений и добор до минимума) выполняется периодически в фоне.
+    explicit TDbConnectionPool(TDataBaseConfigPtr config, NCommon::TInvokerPtr invoker = NCommon::TInvokerPtr());
+
+    void Start();
+    void Stop();
+
+    // Выдает соединение в порядке очереди запросивших.
+    // Бросает исключение, если соединение не освободилось за timeout.
+    TDbConnectionLease Acquire();
+    TDbConnectionLease Acquire(std::chrono::milliseconds timeout);
+
+    // Закрывает соединения, простаивающие дольше IdleTimeout, и добирает пул до MinConnections
+    void Maintain();
+
+    size_t GetTotalCount() const;
+    size_t GetIdleCount() const;
+
+private:
+    friend TDbConnectionLease;
+
+    void Release(std::unique_ptr<TDbConnection> connection);
+    bool CheckHealth(TDbConnection& connection);
+
+    TDataBaseConfigPtr Config_;
+    NCommon::TInvokerPtr Invoker_;
+    NCommon::TPeriodicExecutorPtr MaintenanceExecutor_;
+
+    mutable std::mutex Mutex_;
+    std::condition_variable CondVar_;
+    // Свободные соединения: в конце самые недавно использованные
+    std::deque<std::unique_ptr<TDbConnection>> Idle_;
+    // Очередь ожидающих соединения, для честной выдачи
+    std::deque<uint64_t> Waiters_;
+    uint64_t NextTicket_ = 0;
+    size_t Total_ = 0;
+    bool Stopped_ = false;
+
+    inline static const std::string LoggingSource = "ConnectionPool";
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Отмена асинхронного запроса. До начала выполнения запрос просто
+// не будет запущен, во время выполнения серверу отправляется PQcancel.
+class TQueryCanceler : public NRefCounted::TRefCountedBase {
+public:
+    void Cancel();
+    bool IsCanceled() const;
+
+private:
+    friend class TDbClient;
+
+    // Возвращает false, если отмена уже запрошена
+    bool Attach(pqxx::connection* connection);
+    void Detach();
+
+    mutable std::mutex Mutex_;
+    pqxx::connection* Connection_ = nullptr;
+    bool Canceled_ = false;
+
+    inline static const std::string LoggingSource = "Client";
+};
+
+DECLARE_REFCOUNTED(TQueryCanceler);
+
+////////////////////////////////////////////////////////////////////////////////
+
 class TTransaction;
 
 class TDbClient : public NRefCounted::TRefCountedBase {
@@ -41,8 +285,8 @@ public:
     using TParamMap = std::unordered_map<std::string, std::string>;
     using TQueryParams = std::vector<std::string>;
 
-    TDbClient(TDataBaseConfigPtr config);
-    
+    TDbClient(TDataBaseConfigPtr config, NCommon::TInvokerPtr invoker = NCommon::TInvokerPtr());
+
     void Connect();
 
     template <typename Container>
@@ -60,44 +304,55 @@ public:
         return ExecuteQuery(query, pqxx::params(std::forward<Args>(args)...));
     }
 
-    inline pqxx::result ExecuteQuery(const std::string& query, pqxx::params&& params) {
-        try {
-            auto guard = std::lock_guard(Mutex_);
-            if (Txn_) {
-                return Txn_->exec(query, params);
-            } else {
-                pqxx::work txn(*Conn_);
-                auto res = txn.exec(query, params);
-                txn.commit();
-                return res;
-            }
-        } catch (const std::exception& ex) {
-            LOG_ERROR("Parameterized query failed: {}", ex.what());
-            throw;
-        }
-    }
+    pqxx::result ExecuteQuery(const std::string& query, pqxx::params&& params);
+
+    pqxx::result ExecutePrepared(const std::string& query, const TQueryParams& params);
+
+    // Выполняет запрос в отдельном пуле потоков клиента и не блокирует вызывающий поток.
+    // Время ожидания соединения и выполнения ограничено timeout, отсчитываемым
+    // от момента вызова; на сервере он действует как statement_timeout.
+    std::future<TStatementResult> ExecuteQueryAsync(
+        const std::string& query,
+        const TQueryParams& params,
+        std::optional<std::chrono::milliseconds> timeout = std::nullopt,
+        TQueryCancelerPtr canceler = TQueryCancelerPtr());
+
+    // Загружает строки через COPY в одной транзакции, возвращает число записанных строк
+    size_t CopyRows(const std::string& table, const std::vector<std::string>& columns, const TCopyRowSource& source);
+    size_t CopyRows(const NOrm::NRelation::TCopyInsert& insert);
+
+    // Читает результат запроса пачками по StreamBatchSize строк, не материализуя его целиком
+    size_t StreamQuery(const std::string& query, const TQueryParams& params, const TRowBatchCallback& onBatch);
+    // Запрос и его параметры строит TPostgresBuilder::BuildParameterized
+    size_t StreamQuery(const NOrm::NRelation::TSelect& query, const TRowBatchCallback& onBatch);
+
+    // Выполняет выражения конвейером в одной транзакции, вместо круга до сервера на каждое.
+    // Транзакция фиксируется, только если все выражения выполнены успешно.
+    std::vector<TStatementResult> ExecutePipeline(const std::vector<std::string>& statements);
 
     void InsertRow(const std::string& table, const TParamMap& columns);
     void DeleteRow(const std::string& table, const std::string& conditions = "");
 
-    pqxx::result SelectRows(const std::string& table, 
+    pqxx::result SelectRows(const std::string& table,
                            const std::string& conditions = "",
                            const TQueryParams& orderBy = {},
                            int limit = -1);
 
+    // Транзакция получает собственное соединение из пула на все время жизни
     TTransaction BeginTransaction();
     TTransaction BeginTransactionWithTimeout(std::chrono::milliseconds timeout);
 
-    void Commit();
-    void Rollback();
+    TDbConnectionPoolPtr GetPool() const;
 
 private:
-    std::unique_ptr<pqxx::connection> Conn_;
-    std::shared_ptr<pqxx::transaction<>> Txn_;
-    std::mutex Mutex_;
     TDataBaseConfigPtr Config_;
+    NCommon::TInvokerPtr Invoker_;
+    TDbConnectionPoolPtr Pool_;
 
-    friend TTransaction;
+    // Потоки асинхронных запросов, отдельные от общего invoker,
+    // чтобы долгие запросы не занимали его рабочие потоки
+    NCommon::TThreadPoolPtr AsyncThreadPool_;
+    NCommon::TInvokerPtr AsyncInvoker_;
 
     inline static const std::string LoggingSource = "Client";
 };
@@ -111,15 +366,51 @@ public:
     using TParamMap = std::unordered_map<std::string, std::string>;
     using TQueryParams = std::vector<std::string>;
 
-    TTransaction(TDbClientPtr client, std::shared_ptr<pqxx::transaction<>> Txn);
+    TTransaction(TDbConnectionLease lease, TDataBaseConfigPtr config);
+
+    TTransaction(TTransaction&& other) noexcept = default;
+    TTransaction& operator=(TTransaction&& other) noexcept = delete;
+
     ~TTransaction();
 
+    template <typename Container>
+    requires (std::is_same_v<typename Container::value_type, std::string>)
+    inline pqxx::result ExecuteQueryR(const std::string& query, const Container& params) {
+        pqxx::params queryParams;
+        for (auto&& param : params) {
+            queryParams.append(std::forward<decltype(param)>(param));
+        }
+        return ExecuteQuery(query, std::move(queryParams));
+    }
+
+    template <typename... Args>
+    inline pqxx::result ExecuteQuery(const std::string& query, Args&&... args) {
+        return ExecuteQuery(query, pqxx::params(std::forward<Args>(args)...));
+    }
+
+    pqxx::result ExecuteQuery(const std::string& query, pqxx::params&& params);
+
+    pqxx::result ExecutePrepared(const std::string& query, const TQueryParams& params);
+
+    size_t CopyRows(const std::string& table, const std::vector<std::string>& columns, const TCopyRowSource& source);
+    size_t CopyRows(const NOrm::NRelation::TCopyInsert& insert);
+
+    size_t StreamQuery(const std::string& query, const TQueryParams& params, const TRowBatchCallback& onBatch);
+    size_t StreamQuery(const NOrm::NRelation::TSelect& query, const TRowBatchCallback& onBatch);
+    std::unique_ptr<TCursor> OpenCursor(const std::string& query, const TQueryParams& params);
+    std::unique_ptr<TCursor> OpenCursor(const NOrm::NRelation::TSelect& query);
+
+    // После ошибки в любом из выражений транзакцию можно только откатить
+    std::vector<TStatementResult> ExecutePipeline(const std::vector<std::string>& statements);
+
     void Commit();
     void Rollback();
 
 private:
-    TDbClientPtr Client_;
-    std::shared_ptr<pqxx::transaction<>> Txn_;
+    // Порядок важен: транзакция должна быть уничтожена раньше соединения
+    TDbConnectionLease Lease_;
+    std::unique_ptr<pqxx::work> Txn_;
+    TDataBaseConfigPtr Config_;
 
     inline static const std::string LoggingSource = "Client";
 };
@@ -186,88 +186,104 @@ void TAlterTable::AddOperation(TClausePtr operation) {
 ////////////////////////////////////////////////////////////////////////////////
 
 std::string TBuilderBase::BuildClause(TClausePtr clause) {
+    std::string result;
+    BuildClause(std::move(clause), result);
+    return result;
+}
+
+std::vector<std::string> TBuilderBase::BuildStatements(const TQueryPtr& query) {
+    std::vector<std::string> result;
+    result.reserve(query->GetClauses().size());
+    for (const auto& clause : query->GetClauses()) {
+        auto statement = BuildClause(clause);
+        if (!statement.empty()) {
+            result.push_back(std::move(statement));
+        }
+    }
+    return result;
+}
+
+void TBuilderBase::BuildClause(TClausePtr clause, std::string& out) {
     if (!clause) {
-        return "";
+        return;
     }
 
     switch (clause->Type()) {
         case EClauseType::String:
-            return this->BuildString(std::static_pointer_cast<TString>(clause));
+            return this->BuildString(std::static_pointer_cast<TString>(clause), out);
             
         case EClauseType::Int:
-            return this->BuildInt(std::static_pointer_cast<TInt>(clause));
+            return this->BuildInt(std::static_pointer_cast<TInt>(clause), out);
             
         case EClauseType::Float:
-            return this->BuildFloat(std::static_pointer_cast<TFloat>(clause));
+            return this->BuildFloat(std::static_pointer_cast<TFloat>(clause), out);
             
         case EClauseType::Bool:
-            return this->BuildBool(std::static_pointer_cast<TBool>(clause));
+            return this->BuildBool(std::static_pointer_cast<TBool>(clause), out);
             
         case EClauseType::Expression:
-            return this->BuildExpression(std::static_pointer_cast<TExpression>(clause));
+            return this->BuildExpression(std::static_pointer_cast<TExpression>(clause), out);
             
         case EClauseType::All:
-            return this->BuildAll(std::static_pointer_cast<TAll>(clause));
+            return this->BuildAll(std::static_pointer_cast<TAll>(clause), out);
             
         case EClauseType::Column:
-            return this->BuildColumn(std::static_pointer_cast<TColumn>(clause));
+            return this->BuildColumn(std::static_pointer_cast<TColumn>(clause), out);
             
         case EClauseType::Table:
-            return this->BuildTable(std::static_pointer_cast<TTable>(clause));
+            return this->BuildTable(std::static_pointer_cast<TTable>(clause), out);
             
         case EClauseType::Default:
-            return this->BuildDefault(std::static_pointer_cast<TDefault>(clause));
+            return this->BuildDefault(std::static_pointer_cast<TDefault>(clause), out);
             
         case EClauseType::Join:
-            return this->BuildJoin(std::static_pointer_cast<TJoin>(clause));
+            return this->BuildJoin(std::static_pointer_cast<TJoin>(clause), out);
             
         case EClauseType::Select:
-            return this->BuildSelect(std::static_pointer_cast<TSelect>(clause));
+            return this->BuildSelect(std::static_pointer_cast<TSelect>(clause), out);
             
         case EClauseType::Insert:
-            return this->BuildInsert(std::static_pointer_cast<TInsert>(clause));
+            return this->BuildInsert(std::static_pointer_cast<TInsert>(clause), out);
             
         case EClauseType::Update:
-            return this->BuildUpdate(std::static_pointer_cast<TUpdate>(clause));
+            return this->BuildUpdate(std::static_pointer_cast<TUpdate>(clause), out);
             
         case EClauseType::Delete:
-            return this->BuildDelete(std::static_pointer_cast<TDelete>(clause));
+            return this->BuildDelete(std::static_pointer_cast<TDelete>(clause), out);
             
         case EClauseType::Truncate:
-            return this->BuildTruncate(std::static_pointer_cast<TTruncate>(clause));
+            return this->BuildTruncate(std::static_pointer_cast<TTruncate>(clause), out);
             
         case EClauseType::StartTransaction:
-            return this->BuildStartTransaction(std::static_pointer_cast<TStartTransaction>(clause));
+            return this->BuildStartTransaction(std::static_pointer_cast<TStartTransaction>(clause), out);
             
         case EClauseType::CommitTransaction:
-            return this->BuildCommitTransaction(std::static_pointer_cast<TCommitTransaction>(clause));
+            return this->BuildCommitTransaction(std::static_pointer_cast<TCommitTransaction>(clause), out);
             
         case EClauseType::RollbackTransaction:
-            return this->BuildRollbackTransaction(std::static_pointer_cast<TRollbackTransaction>(clause));
+            return this->BuildRollbackTransaction(std::static_pointer_cast<TRollbackTransaction>(clause), out);
             
         case EClauseType::CreateTable:
-            return this->BuildCreateTable(std::static_pointer_cast<TCreateTable>(clause));
+            return this->BuildCreateTable(std::static_pointer_cast<TCreateTable>(clause), out);
             
         case EClauseType::DropTable:
-            return this->BuildDropTable(std::static_pointer_cast<TDropTable>(clause));
+            return this->BuildDropTable(std::static_pointer_cast<TDropTable>(clause), out);
             
         case EClauseType::AlterTable:
-            return this->BuildAlterTable(std::static_pointer_cast<TAlterTable>(clause));
+            return this->BuildAlterTable(std::static_pointer_cast<TAlterTable>(clause), out);
             
         case EClauseType::CreateColumn:
-            return this->BuildAddColumn(std::static_pointer_cast<TAddColumn>(clause));
+            return this->BuildAddColumn(std::static_pointer_cast<TAddColumn>(clause), out);
             
         case EClauseType::DropColumn:
-            return this->BuildDropColumn(std::static_pointer_cast<TDropColumn>(clause));
+            return this->BuildDropColumn(std::static_pointer_cast<TDropColumn>(clause), out);
             
         case EClauseType::AlterColumn:
-            return this->BuildAlterColumn(std::static_pointer_cast<TAlterColumn>(clause));
+            return this->BuildAlterColumn(std::static_pointer_cast<TAlterColumn>(clause), out);
             
         default:
             THROW("Uknown type of clause: {}", static_cast<int>(clause->Type()));
     }
-    
-    return "";
 }
 
 
@@ -2,6 +2,7 @@
 
 #include <lib/relation/proto/query.pb.h>
 #include <memory>
+#include <span>
 #include <relation/field.h>
 #include <relation/message.h>
 #include <relation/relation_manager.h>
@@ -199,14 +200,14 @@ enum EKeyType {
 
 class TColumn : public TClause {
   public:
-    TColumn(const std::vector<uint32_t>& tablePath, const std::vector<uint32_t> fieldPath)
-        : TablePath_(tablePath), FieldPath_(fieldPath) {}
+    TColumn(std::span<const uint32_t> tablePath, std::span<const uint32_t> fieldPath)
+        : TablePath_(tablePath.begin(), tablePath.end()), FieldPath_(fieldPath.begin(), fieldPath.end()) {}
 
     EClauseType Type() const override;
 
-    void SetPath(const std::vector<uint32_t>& table, const std::vector<uint32_t>& path) {
-        TablePath_ = table;
-        FieldPath_ = path;
+    void SetPath(std::span<const uint32_t> table, std::span<const uint32_t> path) {
+        TablePath_.assign(table.begin(), table.end());
+        FieldPath_.assign(path.begin(), path.end());
     }
     const std::vector<uint32_t>& GetFieldPath() const {
         return FieldPath_;
@@ -244,9 +245,9 @@ class TColumnDefinition : public TClause {
 
     EClauseType Type() const override;
 
-    void SetPath(const std::vector<uint32_t>& table, const std::vector<uint32_t>& path) {
-        TablePath_ = table;
-        FieldPath_ = path;
+    void SetPath(std::span<const uint32_t> table, std::span<const uint32_t> path) {
+        TablePath_.assign(table.begin(), table.end());
+        FieldPath_.assign(path.begin(), path.end());
     }
 
     const std::vector<uint32_t>& GetFieldPath() const {
@@ -839,46 +840,52 @@ class TBuilderBase {
     virtual ~TBuilderBase() = default;
 
     std::string BuildClause(TClausePtr clause);
+    // Дописывает SQL в конец out, буфер можно переиспользовать между запросами
+    void BuildClause(TClausePtr clause, std::string& out);
+    // Собирает каждую клаузу запроса отдельным выражением, пустые пропускаются.
+    // В отличие от JoinQueries позволяет отправить выражения конвейером и
+    // сопоставить ошибку с конкретным выражением.
+    std::vector<std::string> BuildStatements(const TQueryPtr& query);
 
   protected:
-    virtual std::string BuildString(TStringPtr value) = 0;
-    virtual std::string BuildInt(TIntPtr value) = 0;
-    virtual std::string BuildFloat(TFloatPtr value) = 0;
-    virtual std::string BuildBool(TBoolPtr value) = 0;
+    virtual void BuildString(TStringPtr value, std::string& out) = 0;
+    virtual void BuildInt(TIntPtr value, std::string& out) = 0;
+    virtual void BuildFloat(TFloatPtr value, std::string& out) = 0;
+    virtual void BuildBool(TBoolPtr value, std::string& out) = 0;
 
-    virtual std::string BuildExpression(TExpressionPtr expression) = 0;
+    virtual void BuildExpression(TExpressionPtr expression, std::string& out) = 0;
 
-    virtual std::string BuildAll(TAllPtr all) = 0;
+    virtual void BuildAll(TAllPtr all, std::string& out) = 0;
 
-    virtual std::string BuildColumn(TColumnPtr column) = 0;
-    virtual std::string BuildTable(TTablePtr table) = 0;
+    virtual void BuildColumn(TColumnPtr column, std::string& out) = 0;
+    virtual void BuildTable(TTablePtr table, std::string& out) = 0;
 
-    virtual std::string BuildDefault(TDefaultPtr defaultVal) = 0;
+    virtual void BuildDefault(TDefaultPtr defaultVal, std::string& out) = 0;
 
-    virtual std::string BuildSelect(TSelectPtr select) = 0;
+    virtual void BuildSelect(TSelectPtr select, std::string& out) = 0;
 
-    virtual std::string BuildJoin(TJoinPtr join) = 0;
+    virtual void BuildJoin(TJoinPtr join, std::string& out) = 0;
 
-    virtual std::string BuildInsert(TInsertPtr insert) = 0;
+    virtual void BuildInsert(TInsertPtr insert, std::string& out) = 0;
 
-    virtual std::string BuildUpdate(TUpdatePtr update) = 0;
+    virtual void BuildUpdate(TUpdatePtr update, std::string& out) = 0;
 
-    virtual std::string BuildDelete(TDeletePtr deleteClause) = 0;
-    virtual std::string BuildTruncate(TTruncatePtr truncate) = 0;
+    virtual void BuildDelete(TDeletePtr deleteClause, std::string& out) = 0;
+    virtual void BuildTruncate(TTruncatePtr truncate, std::string& out) = 0;
 
-    virtual std::string BuildStartTransaction(TStartTransactionPtr startTransaction) = 0;
-    virtual std::string BuildCommitTransaction(TCommitTransactionPtr commitTransaction) = 0;
-    virtual std::string BuildRollbackTransaction(TRollbackTransactionPtr rollbackTransaction) = 0;
+    virtual void BuildStartTransaction(TStartTransactionPtr startTransaction, std::string& out) = 0;
+    virtual void BuildCommitTransaction(TCommitTransactionPtr commitTransaction, std::string& out) = 0;
+    virtual void BuildRollbackTransaction(TRollbackTransactionPtr rollbackTransaction, std::string& out) = 0;
 
-    virtual std::string BuildColumnDefinition(TColumnDefinitionPtr columnDefinition) = 0;
+    virtual void BuildColumnDefinition(TColumnDefinitionPtr columnDefinition, std::string& out) = 0;
 
-    virtual std::string BuildCreateTable(TCreateTablePtr createTable) = 0;
-    virtual std::string BuildDropTable(TDropTablePtr dropTable) = 0;
-    virtual std::string BuildAlterTable(TAlterTablePtr alterTable) = 0;
+    virtual void BuildCreateTable(TCreateTablePtr createTable, std::string& out) = 0;
+    virtual void BuildDropTable(TDropTablePtr dropTable, std::string& out) = 0;
+    virtual void BuildAlterTable(TAlterTablePtr alterTable, std::string& out) = 0;
 
-    virtual std::string BuildAddColumn(TAddColumnPtr addColumn) = 0;
-    virtual std::string BuildDropColumn(TDropColumnPtr dropColumn) = 0;
-    virtual std::string BuildAlterColumn(TAlterColumnPtr alterColumn) = 0;
+    virtual void BuildAddColumn(TAddColumnPtr addColumn, std::string& out) = 0;
+    virtual void BuildDropColumn(TDropColumnPtr dropColumn, std::string& out) = 0;
+    virtual void BuildAlterColumn(TAlterColumnPtr alterColumn, std::string& out) = 0;
 
     virtual std::string JoinQueries(const std::vector<std::string>& queries) = 0;
 };
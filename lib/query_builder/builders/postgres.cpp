@@ -2,6 +2,9 @@
 #include <relation/message.h>
 #include <relation/field.h>
 #include <common/format.h>
+#include <charconv>
+#include <cstdio>
+#include <limits>
 #include <sstream>
 
 namespace NOrm::NRelation::Builder {
@@ -10,17 +13,80 @@ namespace {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-std::string FieldToString(const std::vector<uint32_t>& fieldPath, EKeyType type) {
+// Запись в буфер без промежуточных строк: SQL собирается в один std::string
+
+template <typename T>
+void AppendNumber(std::string& out, T value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    ASSERT(ec == std::errc(), "Failed to format number");
+    out.append(buffer, end);
+}
+
+void AppendFloat(std::string& out, double value) {
+    // Тот же формат, что и у std::to_string
+    char buffer[std::numeric_limits<double>::max_exponent10 + 32];
+    int size = std::snprintf(buffer, sizeof(buffer), "%f", value);
+    ASSERT(size > 0 && static_cast<size_t>(size) < sizeof(buffer), "Failed to format float");
+    out.append(buffer, size);
+}
+
+void AppendPath(std::string& out, std::span<const uint32_t> path) {
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) {
+            out += '_';
+        }
+        AppendNumber(out, path[i]);
+    }
+}
+
+void AppendTableName(std::string& out, std::span<const uint32_t> tablePath) {
+    out += "t_";
+    AppendPath(out, tablePath);
+}
+
+void AppendFieldName(std::string& out, std::span<const uint32_t> fieldPath, EKeyType type) {
     switch (type) {
         case EKeyType::Simple:
-            return Format("f_{onlydelim,delimiter='_'}", fieldPath);
+            out += "f_";
+            break;
         case EKeyType::Primary:
-            return Format("p_{onlydelim,delimiter='_'}", fieldPath);
+            out += "p_";
+            break;
         case EKeyType::Index:
-            return Format("i_{onlydelim,delimiter='_'}", fieldPath);
+            out += "i_";
+            break;
         default:
             THROW("Invalid field type");
     }
+    AppendPath(out, fieldPath);
+}
+
+void AppendEscapedString(std::string& out, std::string_view str) {
+    // В PostgreSQL строки экранируются одинарными кавычками
+    out += '\'';
+    for (char c : str) {
+        if (c == '\'') {
+            out += "''";
+        } else if (c == '\\') {
+            out += "\\\\";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else {
+            out += c;
+        }
+    }
+    out += '\'';
+}
+
+std::string FieldToString(std::span<const uint32_t> fieldPath, EKeyType type) {
+    std::string result;
+    AppendFieldName(result, fieldPath, type);
+    return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -36,28 +102,31 @@ TPostgresBuilder::TPostgresBuilder() {
 TPostgresBuilder::~TPostgresBuilder() {
 }
 
+TParameterizedQuery TPostgresBuilder::BuildParameterized(TClausePtr clause) {
+    Parameterized_ = true;
+    Params_.clear();
+
+    TParameterizedQuery result;
+    try {
+        BuildClause(clause, result.Query);
+    } catch (...) {
+        Parameterized_ = false;
+        Params_.clear();
+        throw;
+    }
+
+    Parameterized_ = false;
+    result.Params = std::move(Params_);
+    Params_.clear();
+    return result;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Вспомогательные методы
 
 std::string TPostgresBuilder::EscapeStringLiteral(const std::string& str) {
-    // В PostgreSQL строки экранируются одинарными кавычками
-    std::string result = "'";
-    for (char c : str) {
-        if (c == '\'') {
-            result += "''";
-        } else if (c == '\\') {
-            result += "\\\\";
-        } else if (c == '\n') {
-            result += "\\n";
-        } else if (c == '\r') {
-            result += "\\r";
-        } else if (c == '\t') {
-            result += "\\t";
-        } else {
-            result += c;
-        }
-    }
-    result += "'";
+    std::string result;
+    AppendEscapedString(result, str);
     return result;
 }
 
@@ -75,12 +144,34 @@ std::string TPostgresBuilder::EscapeIdentifier(const std::string& identifier) {
     return result;
 }
 
-std::vector<std::string> TPostgresBuilder::BuildVector(const std::vector<TClausePtr>& clauses) {
-    std::vector<std::string> result;
-    for (const auto& clause : clauses) {
-        result.emplace_back(BuildClause(clause));
+void TPostgresBuilder::AddParam(std::string value, std::string_view type, std::string& out) {
+    // Явное приведение типа нужно, чтобы PostgreSQL мог вывести тип
+    // параметра в выражениях вида ($1 + $2)
+    Params_.emplace_back(std::move(value));
+    out += '$';
+    AppendNumber(out, Params_.size());
+    out += "::";
+    out += type;
+}
+
+void TPostgresBuilder::AppendList(const std::vector<TClausePtr>& clauses, std::string& out) {
+    for (size_t i = 0; i < clauses.size(); ++i) {
+        if (i > 0) {
+            out += ", ";
+        }
+        BuildClause(clauses[i], out);
+    }
+}
+
+void TPostgresBuilder::AppendAssignments(const std::vector<std::pair<TClausePtr, TClausePtr>>& assignments, std::string& out) {
+    for (size_t i = 0; i < assignments.size(); ++i) {
+        if (i > 0) {
+            out += ", ";
+        }
+        BuildClause(assignments[i].first, out);
+        out += " = ";
+        BuildClause(assignments[i].second, out);
     }
-    return result;
 }
 
 std::string TPostgresBuilder::GetPostgresType(const TValueInfo& typeInfo) {
@@ -156,457 +247,325 @@ std::string TPostgresBuilder::GetPostgresDefault(const TValueInfo& typeInfo) {
 ////////////////////////////////////////////////////////////////////////////////
 // Реализация методов интерфейса TBuilderBase
 
-std::string TPostgresBuilder::BuildString(TStringPtr value) {
+void TPostgresBuilder::BuildString(TStringPtr value, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::String);
-    const std::string& str = value->GetValue();
-    std::string result = "'";
-    for (char c : str) {
-        if (c == '\'') {
-            result += "''";
-        } else if (c == '\\') {
-            result += "\\\\";
-        } else if (c == '\n') {
-            result += "\\n";
-        } else if (c == '\r') {
-            result += "\\r";
-        } else if (c == '\t') {
-            result += "\\t";
-        } else {
-            result += c;
-        }
+    if (Parameterized_) {
+        AddParam(value->GetValue(), "text", out);
+        return;
     }
-    result += "'";
-    return result;
+    AppendEscapedString(out, value->GetValue());
 }
 
-std::string TPostgresBuilder::BuildInt(TIntPtr value) {
+void TPostgresBuilder::BuildInt(TIntPtr value, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Int);
-    return std::to_string(value->GetValue());
+    if (Parameterized_) {
+        AddParam(std::to_string(value->GetValue()), "integer", out);
+        return;
+    }
+    AppendNumber(out, value->GetValue());
 }
 
-std::string TPostgresBuilder::BuildFloat(TFloatPtr value) {
+void TPostgresBuilder::BuildFloat(TFloatPtr value, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Float);
-    return std::to_string(value->GetValue());
+    if (Parameterized_) {
+        // Параметр передается без потери точности, в отличие от std::to_string
+        std::ostringstream oss;
+        oss.precision(std::numeric_limits<double>::max_digits10);
+        oss << value->GetValue();
+        AddParam(oss.str(), "double precision", out);
+        return;
+    }
+    AppendFloat(out, value->GetValue());
 }
 
-std::string TPostgresBuilder::BuildBool(TBoolPtr value) {
+void TPostgresBuilder::BuildBool(TBoolPtr value, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Bool);
-    return value->GetValue() ? "TRUE" : "FALSE";
+    if (Parameterized_) {
+        AddParam(value->GetValue() ? "true" : "false", "boolean", out);
+        return;
+    }
+    out += value->GetValue() ? "TRUE" : "FALSE";
 }
 
-std::string TPostgresBuilder::BuildExpression(TExpressionPtr expression) {
+void TPostgresBuilder::BuildExpression(TExpressionPtr expression, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Expression);
     
     const auto& operands = expression->GetOperands();
     NQuery::EExpressionType type = expression->GetExpressionType();
+
+    auto operand = [&](size_t idx) {
+        BuildClause(operands[idx], out);
+    };
+    auto operandsFrom = [&](size_t first) {
+        for (size_t i = first; i < operands.size(); ++i) {
+            if (i > first) {
+                out += ", ";
+            }
+            operand(i);
+        }
+    };
+    auto expectCount = [&](size_t count) {
+        ASSERT(operands.size() == count, "Invalid count of operands for {} operation, must: {}, actual: {}", type, count, operands.size());
+    };
+    auto expectAtLeast = [&](size_t count) {
+        ASSERT(operands.size() >= count, "Invalid count of operands for {} operation, must be >= {}, actual: {}", type, count, operands.size());
+    };
+    // (a OP b)
+    auto infix = [&](std::string_view op) {
+        expectCount(2);
+        out += '(';
+        operand(0);
+        out += op;
+        operand(1);
+        out += ')';
+    };
+    // NAME(a, b, ...)
+    auto call = [&](std::string_view name) {
+        out += name;
+        out += '(';
+        operandsFrom(0);
+        out += ')';
+    };
+    auto fixedCall = [&](std::string_view name, size_t count) {
+        expectCount(count);
+        call(name);
+    };
+    auto variadicCall = [&](std::string_view name, size_t minCount) {
+        expectAtLeast(minCount);
+        call(name);
+    };
     
     switch (type) {
         // Арифметические выражения
         case NQuery::EExpressionType::add:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} + {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" + ");
         case NQuery::EExpressionType::subtract:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} - {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" - ");
         case NQuery::EExpressionType::multiply:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} * {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" * ");
         case NQuery::EExpressionType::divide:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} / {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" / ");
         case NQuery::EExpressionType::modulo:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} % {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" % ");
         case NQuery::EExpressionType::exponent:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("POWER({}, {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
         case NQuery::EExpressionType::power:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("POWER({}, {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return fixedCall("POWER", 2);
             
         // Сравнения
         case NQuery::EExpressionType::equals:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} = {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" = ");
         case NQuery::EExpressionType::not_equals:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} <> {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" <> ");
         case NQuery::EExpressionType::greater_than:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} > {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" > ");
         case NQuery::EExpressionType::less_than:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} < {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" < ");
         case NQuery::EExpressionType::greater_than_or_equals:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} >= {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" >= ");
         case NQuery::EExpressionType::less_than_or_equals:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} <= {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" <= ");
             
         // Логические выражения
         case NQuery::EExpressionType::and_:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} AND {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" AND ");
         case NQuery::EExpressionType::or_:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} OR {})",
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" OR ");
         case NQuery::EExpressionType::not_:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("NOT {}", BuildClause(operands[0]));
+            expectCount(1);
+            out += "NOT ";
+            return operand(0);
             
         // Строковые выражения
         case NQuery::EExpressionType::like:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} LIKE {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" LIKE ");
         case NQuery::EExpressionType::ilike:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} ILIKE {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" ILIKE ");
         case NQuery::EExpressionType::similar_to:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} SIMILAR TO {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" SIMILAR TO ");
         case NQuery::EExpressionType::regexp_match:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("({} ~ {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return infix(" ~ ");
             
         // Проверка и типы
         case NQuery::EExpressionType::is_null:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("{} IS NULL", BuildClause(operands[0]));
+            expectCount(1);
+            operand(0);
+            out += " IS NULL";
+            return;
         case NQuery::EExpressionType::is_not_null:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("{} IS NOT NULL", BuildClause(operands[0]));
+            expectCount(1);
+            operand(0);
+            out += " IS NOT NULL";
+            return;
         case NQuery::EExpressionType::between:
-            ASSERT(operands.size() == 3, "Invalid count of operands for {} operation, must: 3, actual: {}", type, operands.size());
-            return Format("({} BETWEEN {} AND {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1]),
-                BuildClause(operands[2])
-            );
+            expectCount(3);
+            out += '(';
+            operand(0);
+            out += " BETWEEN ";
+            operand(1);
+            out += " AND ";
+            operand(2);
+            out += ')';
+            return;
         case NQuery::EExpressionType::in:
-            ASSERT(operands.size() >= 2, "Invalid count of operands for {} operation, must be >= 2, actual: {}", type, operands.size());
-            {
-                std::string result = Format("{} IN (", BuildClause(operands[0]));
-                for (size_t i = 1; i < operands.size(); ++i) {
-                    if (i > 1) {
-                        result += ", ";
-                    }
-                    result += BuildClause(operands[i]);
-                }
-                result += ")";
-                return result;
-            }
+        case NQuery::EExpressionType::not_in:
+            expectAtLeast(2);
+            operand(0);
+            out += type == NQuery::EExpressionType::in ? " IN (" : " NOT IN (";
+            operandsFrom(1);
+            out += ')';
+            return;
             
         // Агрегатные функции
         case NQuery::EExpressionType::count:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("COUNT({})", BuildClause(operands[0]));
+            return fixedCall("COUNT", 1);
         case NQuery::EExpressionType::sum:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("SUM({})", BuildClause(operands[0]));
+            return fixedCall("SUM", 1);
         case NQuery::EExpressionType::avg:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("AVG({})", BuildClause(operands[0]));
+            return fixedCall("AVG", 1);
         case NQuery::EExpressionType::min:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("MIN({})", BuildClause(operands[0]));
+            return fixedCall("MIN", 1);
         case NQuery::EExpressionType::max:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("MAX({})", BuildClause(operands[0]));
+            return fixedCall("MAX", 1);
+        case NQuery::EExpressionType::array_agg:
+            return fixedCall("ARRAY_AGG", 1);
+        case NQuery::EExpressionType::string_agg:
+            return fixedCall("STRING_AGG", 2);
+        case NQuery::EExpressionType::json_agg:
+            return fixedCall("JSON_AGG", 1);
             
         // Строковые функции
         case NQuery::EExpressionType::concat:
-            ASSERT(operands.size() >= 2, "Invalid count of operands for {} operation, must be >= 2, actual: {}", type, operands.size());
-            {
-                std::string result = "CONCAT(";
-                for (size_t i = 0; i < operands.size(); ++i) {
-                    if (i > 0) {
-                        result += ", ";
-                    }
-                    result += BuildClause(operands[i]);
-                }
-                result += ")";
-                return result;
-            }
+            return variadicCall("CONCAT", 2);
         case NQuery::EExpressionType::substring:
+            if (operands.size() != 2 && operands.size() != 3) {
+                THROW("Invalid count of operands for {} operation, must: 2 or 3, actual: {}", type, operands.size());
+            }
+            out += "SUBSTRING(";
+            operand(0);
+            out += " FROM ";
+            operand(1);
             if (operands.size() == 3) {
-                return Format("SUBSTRING({} FROM {} FOR {})", 
-                    BuildClause(operands[0]),
-                    BuildClause(operands[1]),
-                    BuildClause(operands[2])
-                );
-            } else if (operands.size() == 2) {
-                return Format("SUBSTRING({} FROM {})", 
-                    BuildClause(operands[0]),
-                    BuildClause(operands[1])
-                );
+                out += " FOR ";
+                operand(2);
             }
-            THROW("Invalid count of operands for {} operation, must: 2 or 3, actual: {}", type, operands.size());
+            out += ')';
+            return;
         case NQuery::EExpressionType::upper:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("UPPER({})", BuildClause(operands[0]));
+            return fixedCall("UPPER", 1);
         case NQuery::EExpressionType::lower:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("LOWER({})", BuildClause(operands[0]));
+            return fixedCall("LOWER", 1);
         case NQuery::EExpressionType::length:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("LENGTH({})", BuildClause(operands[0]));
-            
-        // Математические функции
-        case NQuery::EExpressionType::abs:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("ABS({})", BuildClause(operands[0]));
-        case NQuery::EExpressionType::round:
-            if (operands.size() == 2) {
-                return Format("ROUND({}, {})", 
-                    BuildClause(operands[0]),
-                    BuildClause(operands[1])
-                );
-            } else if (operands.size() == 1) {
-                return Format("ROUND({})", BuildClause(operands[0]));
-            }
-            THROW("Invalid count of operands for {} operation, must: 1 or 2, actual: {}", type, operands.size());
-            
-        // Условные выражения
-        case NQuery::EExpressionType::coalesce:
-            ASSERT(operands.size() >= 1, "Invalid count of operands for {} operation, must be >= 1, actual: {}", type, operands.size());
-            {
-                std::string result = "COALESCE(";
-                for (size_t i = 0; i < operands.size(); ++i) {
-                    if (i > 0) {
-                        result += ", ";
-                    }
-                    result += BuildClause(operands[i]);
-                }
-                result += ")";
-                return result;
-            }
-            
-        // Подзапросы
-        case NQuery::EExpressionType::exists:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("EXISTS ({})", BuildClause(operands[0]));
-
-        // Строковые функции
+            return fixedCall("LENGTH", 1);
         case NQuery::EExpressionType::replace:
-            ASSERT(operands.size() == 3, "Invalid count of operands for {} operation, must: 3, actual: {}", type, operands.size());
-            return Format("REPLACE({}, {}, {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1]),
-                BuildClause(operands[2])
-            );
+            return fixedCall("REPLACE", 3);
         case NQuery::EExpressionType::trim:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("TRIM({})", BuildClause(operands[0]));
+            return fixedCall("TRIM", 1);
         case NQuery::EExpressionType::left:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("LEFT({}, {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return fixedCall("LEFT", 2);
         case NQuery::EExpressionType::right:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("RIGHT({}, {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            return fixedCall("RIGHT", 2);
         case NQuery::EExpressionType::position:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("POSITION({} IN {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
+            expectCount(2);
+            out += "POSITION(";
+            operand(0);
+            out += " IN ";
+            operand(1);
+            out += ')';
+            return;
         case NQuery::EExpressionType::split_part:
-            ASSERT(operands.size() == 3, "Invalid count of operands for {} operation, must: 3, actual: {}", type, operands.size());
-            return Format("SPLIT_PART({}, {}, {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1]),
-                BuildClause(operands[2])
-            );
-
+            return fixedCall("SPLIT_PART", 3);
+            
         // Математические функции
+        case NQuery::EExpressionType::abs:
+            return fixedCall("ABS", 1);
+        case NQuery::EExpressionType::round:
+            if (operands.size() != 1 && operands.size() != 2) {
+                THROW("Invalid count of operands for {} operation, must: 1 or 2, actual: {}", type, operands.size());
+            }
+            return call("ROUND");
         case NQuery::EExpressionType::ceil:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("CEIL({})", BuildClause(operands[0]));
+            return fixedCall("CEIL", 1);
         case NQuery::EExpressionType::floor:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("FLOOR({})", BuildClause(operands[0]));
+            return fixedCall("FLOOR", 1);
         case NQuery::EExpressionType::sqrt:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("SQRT({})", BuildClause(operands[0]));
+            return fixedCall("SQRT", 1);
         case NQuery::EExpressionType::log:
             if (operands.size() == 1) {
-                return Format("LN({})", BuildClause(operands[0]));
+                return call("LN");
             } else if (operands.size() == 2) {
-                return Format("LOG({}, {})", BuildClause(operands[1]), BuildClause(operands[0]));
+                // LOG(base, value) в PostgreSQL
+                out += "LOG(";
+                operand(1);
+                out += ", ";
+                operand(0);
+                out += ')';
+                return;
             }
             THROW("Invalid count of operands for {} operation, must: 1 or 2, actual: {}", type, operands.size());
         case NQuery::EExpressionType::random:
-            ASSERT(operands.size() == 0, "Invalid count of operands for {} operation, must: 0, actual: {}", type, operands.size());
-            return "RANDOM()";
+            return fixedCall("RANDOM", 0);
         case NQuery::EExpressionType::sin:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("SIN({})", BuildClause(operands[0]));
+            return fixedCall("SIN", 1);
         case NQuery::EExpressionType::cos:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("COS({})", BuildClause(operands[0]));
+            return fixedCall("COS", 1);
         case NQuery::EExpressionType::tan:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("TAN({})", BuildClause(operands[0]));
-
-        // Агрегатные функции
-        case NQuery::EExpressionType::array_agg:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("ARRAY_AGG({})", BuildClause(operands[0]));
-        case NQuery::EExpressionType::string_agg:
-            ASSERT(operands.size() == 2, "Invalid count of operands for {} operation, must: 2, actual: {}", type, operands.size());
-            return Format("STRING_AGG({}, {})", 
-                BuildClause(operands[0]),
-                BuildClause(operands[1])
-            );
-        case NQuery::EExpressionType::json_agg:
-            ASSERT(operands.size() == 1, "Invalid count of operands for {} operation, must: 1, actual: {}", type, operands.size());
-            return Format("JSON_AGG({})", BuildClause(operands[0]));
+            return fixedCall("TAN", 1);
 
         // Условные выражения
-        case NQuery::EExpressionType::case_:
-            ASSERT(operands.size() >= 3 && operands.size() % 2 == 1, "Invalid count of operands for {} operation, must be odd and >= 3, actual: {}", type, operands.size());
-            {
-                std::string result = "CASE";
-                for (size_t i = 0; i < operands.size() - 1; i += 2) {
-                    result += Format(" WHEN {} THEN {}", 
-                        BuildClause(operands[i]),
-                        BuildClause(operands[i + 1])
-                    );
-                }
-                // Last operand is the ELSE part
-                result += Format(" ELSE {} END", BuildClause(operands[operands.size() - 1]));
-                return result;
-            }
+        case NQuery::EExpressionType::coalesce:
+            return variadicCall("COALESCE", 1);
         case NQuery::EExpressionType::greatest:
-            ASSERT(operands.size() >= 1, "Invalid count of operands for {} operation, must be >= 1, actual: {}", type, operands.size());
-            {
-                std::string result = "GREATEST(";
-                for (size_t i = 0; i < operands.size(); ++i) {
-                    if (i > 0) {
-                        result += ", ";
-                    }
-                    result += BuildClause(operands[i]);
-                }
-                result += ")";
-                return result;
-            }
+            return variadicCall("GREATEST", 1);
         case NQuery::EExpressionType::least:
-            ASSERT(operands.size() >= 1, "Invalid count of operands for {} operation, must be >= 1, actual: {}", type, operands.size());
-            {
-                std::string result = "LEAST(";
-                for (size_t i = 0; i < operands.size(); ++i) {
-                    if (i > 0) {
-                        result += ", ";
-                    }
-                    result += BuildClause(operands[i]);
-                }
-                result += ")";
-                return result;
-            }
-
-        // Прочие операции
-        case NQuery::EExpressionType::not_in:
-            ASSERT(operands.size() >= 2, "Invalid count of operands for {} operation, must be >= 2, actual: {}", type, operands.size());
-            {
-                std::string result = Format("{} NOT IN (", BuildClause(operands[0]));
-                for (size_t i = 1; i < operands.size(); ++i) {
-                    if (i > 1) {
-                        result += ", ";
-                    }
-                    result += BuildClause(operands[i]);
-                }
-                result += ")";
-                return result;
+            return variadicCall("LEAST", 1);
+        case NQuery::EExpressionType::case_:
+            ASSERT(operands.size() >= 3 && operands.size() % 2 == 1, "Invalid count of operands for {} operation, must be odd and >= 3, actual: {}", type, operands.size());
+            out += "CASE";
+            for (size_t i = 0; i < operands.size() - 1; i += 2) {
+                out += " WHEN ";
+                operand(i);
+                out += " THEN ";
+                operand(i + 1);
             }
+            // Последний операнд — ветка ELSE
+            out += " ELSE ";
+            operand(operands.size() - 1);
+            out += " END";
+            return;
+            
+        // Подзапросы
+        case NQuery::EExpressionType::exists:
+            expectCount(1);
+            out += "EXISTS (";
+            operand(0);
+            out += ')';
+            return;
 
         default:
             THROW("Unknown expression type: {}", type);
     }
-    
-    return "";
 }
 
-std::string TPostgresBuilder::BuildAll(TAllPtr all) {
+void TPostgresBuilder::BuildAll(TAllPtr all, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::All);
-    return "*";
+    out += '*';
 }
 
-std::string TPostgresBuilder::BuildColumn(TColumnPtr column) {
+void TPostgresBuilder::BuildColumn(TColumnPtr column, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Column);
     
     switch (column->GetColumnType()) {
         case NQuery::EExcluded:
-            return Format("EXCLUDED.{}", FieldToString(column->GetFieldPath(), column->GetKeyType()));
+            out += "EXCLUDED.";
+            break;
         default:
-            if (column->GetTablePath().empty()) {
-                return Format("{}", FieldToString(column->GetFieldPath(), column->GetKeyType()));
-            } else {
-                return Format("t_{onlydelim,delimiter='_'}.{}", column->GetTablePath(), FieldToString(column->GetFieldPath(), column->GetKeyType()));
+            if (!column->GetTablePath().empty()) {
+                AppendTableName(out, column->GetTablePath());
+                out += '.';
             }
+            break;
     }
+    AppendFieldName(out, column->GetFieldPath(), column->GetKeyType());
 }
 
 std::string TPostgresBuilder::ColumnDefinition(NOrm::NRelation::TPrimitiveFieldInfoPtr field) {
@@ -668,235 +627,220 @@ std::string TPostgresBuilder::ColumnDefinition(NOrm::NRelation::TPrimitiveFieldI
     return oss.str();
 }
 
-std::string TPostgresBuilder::BuildTable(TTablePtr table) {
+void TPostgresBuilder::BuildTable(TTablePtr table, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Table);
-    return Format("t_{onlydelim,delimiter='_'}", table->GetPath().GetTable());
+    AppendTableName(out, table->GetPath().GetTable());
 }
 
-std::string TPostgresBuilder::BuildDefault(TDefaultPtr defaultVal) {
+void TPostgresBuilder::BuildDefault(TDefaultPtr defaultVal, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Default);
-    return "DEFAULT";
+    out += "DEFAULT";
 }
 
-std::string TPostgresBuilder::BuildJoin(TJoinPtr join) {
+void TPostgresBuilder::BuildJoin(TJoinPtr join, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Join);
     
-    std::ostringstream oss;
-    
     switch (join->GetJoinType()) {
         case TJoin::EJoinType::Left:
-            oss << "LEFT JOIN ";
+            out += "LEFT JOIN ";
             break;
         case TJoin::EJoinType::Inner:
-            oss << "INNER JOIN ";
+            out += "INNER JOIN ";
             break;
         case TJoin::EJoinType::ExclusiveLeft:
-            oss << "LEFT OUTER JOIN ";
+            out += "LEFT OUTER JOIN ";
             break;
     }
     
-    oss << Format("t_{onlydelim,delimiter='_'} ", join->GetTable().GetTable());
+    AppendTableName(out, join->GetTable().GetTable());
+    out += ' ';
     
     if (join->GetCondition()) {
-        oss << "ON " << BuildClause(join->GetCondition());
+        out += "ON ";
+        BuildClause(join->GetCondition(), out);
     }
-    
-    return oss.str();
 }
 
-std::string TPostgresBuilder::BuildSelect(TSelectPtr select) {
+void TPostgresBuilder::BuildSelect(TSelectPtr select, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Select);
     
-    std::ostringstream oss;
-    oss << "SELECT ";
+    static const std::unordered_set<NOrm::NRelation::Builder::EClauseType> withBraces = {
+        NOrm::NRelation::Builder::EClauseType::Expression,
+        NOrm::NRelation::Builder::EClauseType::Select,
+        NOrm::NRelation::Builder::EClauseType::Update,
+        NOrm::NRelation::Builder::EClauseType::Insert,
+        NOrm::NRelation::Builder::EClauseType::Delete
+    };
+    
+    // Подзапрос берется в скобки, решение принимается до записи в буфер
+    const bool braces = Stack_.size() > 1 && withBraces.contains(Stack_.at(1));
+    if (braces) {
+        out += '(';
+    }
+    
+    out += "SELECT ";
     
     // Формируем список столбцов
     const auto& selectors = select->GetSelectors();
     if (selectors.empty()) {
-        oss << "*";
+        out += '*';
     } else {
-        for (size_t i = 0; i < selectors.size(); ++i) {
-            if (i > 0) oss << ", ";
-            oss << BuildClause(selectors[i]);
-        }
+        AppendList(selectors, out);
     }
     
     // FROM
     const auto& from = select->GetFrom();
     if (from) {
-        oss << Format(" FROM {}", BuildClause(from));
+        out += " FROM ";
+        BuildClause(from, out);
     }
     
     // JOIN
     const auto& join = select->GetJoin();
     for (const auto& joinClause : join) {
-        oss << " " << BuildClause(joinClause);
+        out += ' ';
+        BuildClause(joinClause, out);
     }
     
     // WHERE
     auto where = select->GetWhere();
     if (where) {
-        oss << " WHERE " << BuildClause(where);
+        out += " WHERE ";
+        BuildClause(where, out);
     }
     
     // GROUP BY
     auto groupBy = select->GetGroupBy();
     if (groupBy) {
-        oss << " GROUP BY " << BuildClause(groupBy);
+        out += " GROUP BY ";
+        BuildClause(groupBy, out);
     }
     
     // HAVING
     auto having = select->GetHaving();
     if (having) {
-        oss << " HAVING " << BuildClause(having);
+        out += " HAVING ";
+        BuildClause(having, out);
     }
     
     // ORDER BY
     auto orderBy = select->GetOrderBy();
     if (orderBy) {
-        oss << " ORDER BY " << BuildClause(orderBy);
+        out += " ORDER BY ";
+        BuildClause(orderBy, out);
     }
     
     // LIMIT
     auto limit = select->GetLimit();
     if (limit) {
-        oss << " LIMIT " << BuildClause(limit);
+        out += " LIMIT ";
+        BuildClause(limit, out);
     }
     
-    static std::unordered_set<NOrm::NRelation::Builder::EClauseType> withBraces = {
-        NOrm::NRelation::Builder::EClauseType::Expression,
-        NOrm::NRelation::Builder::EClauseType::Select,
-        NOrm::NRelation::Builder::EClauseType::Update,
-        NOrm::NRelation::Builder::EClauseType::Insert,
-        NOrm::NRelation::Builder::EClauseType::Delete
-    };
-    
-    if (Stack_.size() > 1 && withBraces.contains(Stack_.at(1))) {
-        return Format("({})", oss.str());
+    if (braces) {
+        out += ')';
     }
-    
-    return oss.str();
 }
 
-std::string TPostgresBuilder::BuildInsert(TInsertPtr insert) {
+void TPostgresBuilder::BuildInsert(TInsertPtr insert, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Insert);
     
-    std::ostringstream oss;
-    oss << Format("INSERT INTO t_{onlydelim,delimiter='_'} ", insert->GetTable().data());
+    out += "INSERT INTO ";
+    AppendTableName(out, insert->GetTable().data());
+    out += ' ';
     
     // Список колонок
     const auto& selectors = insert->GetSelectors();
     if (!selectors.empty()) {
-        oss << "(";
-        for (size_t i = 0; i < selectors.size(); ++i) {
-            if (i > 0) oss << ", ";
-            oss << BuildClause(selectors[i]);
-        }
-        oss << ") ";
+        out += '(';
+        AppendList(selectors, out);
+        out += ") ";
     }
     
     // Значения
     if (insert->GetIsValues()) {
         const auto& values = insert->GetValues();
         if (values.empty()) {
-            oss << "DEFAULT VALUES";
+            out += "DEFAULT VALUES";
         } else {
-            oss << "VALUES ";
+            out += "VALUES ";
             for (size_t i = 0; i < values.size(); ++i) {
-                if (i > 0) oss << ", ";
-                oss << "(";
-                
-                const auto& row = values[i];
-                for (size_t j = 0; j < row.size(); ++j) {
-                    if (j > 0) oss << ", ";
-                    oss << BuildClause(row[j]);
+                if (i > 0) {
+                    out += ", ";
                 }
-                
-                oss << ")";
+                out += '(';
+                AppendList(values[i], out);
+                out += ')';
             }
         }
     }
     
     // ON CONFLICT
     if (insert->GetIsDoUpdate()) {
-        const auto& updates = insert->GetDoUpdate();
-        oss << " ON CONFLICT DO UPDATE SET ";
-        
-        for (size_t i = 0; i < updates.size(); ++i) {
-            if (i > 0) oss << ", ";
-            oss << BuildClause(updates[i].first) << " = " << BuildClause(updates[i].second);
-        }
+        out += " ON CONFLICT DO UPDATE SET ";
+        AppendAssignments(insert->GetDoUpdate(), out);
     }
-    
-    return oss.str();
 }
 
-std::string TPostgresBuilder::BuildUpdate(TUpdatePtr update) {
+void TPostgresBuilder::BuildUpdate(TUpdatePtr update, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Update);
     
-    std::ostringstream oss;
-    oss << Format("UPDATE t_{onlydelim,delimiter='_'} SET ", update->GetTable().GetTable());
+    out += "UPDATE ";
+    AppendTableName(out, update->GetTable().GetTable());
+    out += " SET ";
     
     // Список обновлений
-    const auto& updates = update->GetUpdates();
-    for (size_t i = 0; i < updates.size(); ++i) {
-        if (i > 0) oss << ", ";
-        oss << BuildClause(updates[i].first) << " = " << BuildClause(updates[i].second);
-    }
+    AppendAssignments(update->GetUpdates(), out);
     
     // WHERE
     auto where = update->GetWhere();
     if (where) {
-        oss << " WHERE " << BuildClause(where);
+        out += " WHERE ";
+        BuildClause(where, out);
     }
-    
-    return oss.str();
 }
 
-std::string TPostgresBuilder::BuildDelete(TDeletePtr deleteClause) {
+void TPostgresBuilder::BuildDelete(TDeletePtr deleteClause, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Delete);
     
-    std::ostringstream oss;
-    oss << Format("DELETE FROM t_{onlydelim,delimiter='_'}", deleteClause->GetTable().GetTable());
+    out += "DELETE FROM ";
+    AppendTableName(out, deleteClause->GetTable().GetTable());
     
     // WHERE
     auto where = deleteClause->GetWhere();
     if (where) {
-        oss << " WHERE " << BuildClause(where);
+        out += " WHERE ";
+        BuildClause(where, out);
     }
-    
-    return oss.str();
 }
 
-std::string TPostgresBuilder::BuildTruncate(TTruncatePtr truncate) {
+void TPostgresBuilder::BuildTruncate(TTruncatePtr truncate, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::Truncate);
-    return Format("TRUNCATE TABLE t_{onlydelim,delimiter='_'}", truncate->GetPath().GetTable());
+    out += "TRUNCATE TABLE ";
+    AppendTableName(out, truncate->GetPath().GetTable());
 }
 
-std::string TPostgresBuilder::BuildStartTransaction(TStartTransactionPtr startTransaction) {
+void TPostgresBuilder::BuildStartTransaction(TStartTransactionPtr startTransaction, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::StartTransaction);
     
-    std::ostringstream oss;
-    oss << "BEGIN";
+    out += "BEGIN";
     
     if (startTransaction->GetReadOnly()) {
-        oss << " READ ONLY";
+        out += " READ ONLY";
     }
-    
-    return oss.str();
 }
 
-std::string TPostgresBuilder::BuildCommitTransaction(TCommitTransactionPtr commitTransaction) {
+void TPostgresBuilder::BuildCommitTransaction(TCommitTransactionPtr commitTransaction, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::CommitTransaction);
-    return "COMMIT";
+    out += "COMMIT";
 }
 
-std::string TPostgresBuilder::BuildRollbackTransaction(TRollbackTransactionPtr rollbackTransaction) {
+void TPostgresBuilder::BuildRollbackTransaction(TRollbackTransactionPtr rollbackTransaction, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::RollbackTransaction);
-    return "ROLLBACK";
+    out += "ROLLBACK";
 }
 
-std::string TPostgresBuilder::BuildColumnDefinition(TColumnDefinitionPtr columnDefinition) {
+void TPostgresBuilder::BuildColumnDefinition(TColumnDefinitionPtr columnDefinition, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::CreateColumn);
     
     std::ostringstream oss;
@@ -950,16 +894,17 @@ std::string TPostgresBuilder::BuildColumnDefinition(TColumnDefinitionPtr columnD
         oss << " PRIMARY KEY";
     }
     
-    return oss.str();
+    out += oss.str();
 }
 
-std::string TPostgresBuilder::BuildCreateTable(TCreateTablePtr createTable) {
+void TPostgresBuilder::BuildCreateTable(TCreateTablePtr createTable, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::CreateTable);
     
     auto table = createTable->GetTable();
     
-    std::ostringstream oss;
-    oss << Format("CREATE TABLE t_{onlydelim,delimiter='_'} (", table->GetPath().GetTable());
+    out += "CREATE TABLE ";
+    AppendTableName(out, table->GetPath().GetTable());
+    out += " (";
     
     // Список колонок
     bool first = true;
@@ -967,109 +912,112 @@ std::string TPostgresBuilder::BuildCreateTable(TCreateTablePtr createTable) {
     
     for (const auto& fieldIdx : table->GetRelatedFields()) {
         if (!first) {
-            oss << ", ";
+            out += ", ";
         }
         first = false;
         
         auto field = relationManager.GetPrimitiveField(fieldIdx);
         if (field) {
-            oss << ColumnDefinition(field);
+            out += ColumnDefinition(field);
         }
     }
     
-    oss << ")";
-    
-    return oss.str();
+    out += ')';
 }
 
-std::string TPostgresBuilder::BuildDropTable(TDropTablePtr dropTable) {
+void TPostgresBuilder::BuildDropTable(TDropTablePtr dropTable, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::DropTable);
     
-    return Format("DROP TABLE t_{onlydelim,delimiter='_'}", dropTable->GetTable()->GetPath().GetTable());
+    out += "DROP TABLE ";
+    AppendTableName(out, dropTable->GetTable()->GetPath().GetTable());
 }
 
-std::string TPostgresBuilder::BuildAlterTable(TAlterTablePtr alterTable) {
+void TPostgresBuilder::BuildAlterTable(TAlterTablePtr alterTable, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::AlterTable);
     
-    std::ostringstream oss;
-    oss << "ALTER TABLE ";
+    out += "ALTER TABLE ";
     
     // Предполагаем, что первая операция содержит информацию о таблице
     const auto& operations = alterTable->GetOperations();
     if (!operations.empty()) {
         auto firstOp = operations[0];
         if (auto addOp = std::dynamic_pointer_cast<TAddColumn>(firstOp)) {
-            oss << Format("t_{onlydelim,delimiter='_'}", addOp->GetField()->GetPath().GetTable());
+            AppendTableName(out, addOp->GetField()->GetPath().GetTable());
         } else if (auto dropOp = std::dynamic_pointer_cast<TDropColumn>(firstOp)) {
-            oss << Format("t_{onlydelim,delimiter='_'}", dropOp->GetField()->GetPath().GetTable());
+            AppendTableName(out, dropOp->GetField()->GetPath().GetTable());
         } else if (auto alterOp = std::dynamic_pointer_cast<TAlterColumn>(firstOp)) {
-            oss << Format("t_{onlydelim,delimiter='_'}", alterOp->GetColumn()->GetTablePath());
+            AppendTableName(out, alterOp->GetColumn()->GetTablePath());
         }
     }
     
-    for (size_t i = 0; i < operations.size(); ++i) {
-        if (i > 0) oss << ", ";
-        oss << BuildClause(operations[i]);
-    }
-    
-    return oss.str();
+    AppendList(operations, out);
 }
 
-std::string TPostgresBuilder::BuildAddColumn(TAddColumnPtr addColumn) {
+void TPostgresBuilder::BuildAddColumn(TAddColumnPtr addColumn, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::CreateColumn);
     auto field = addColumn->GetField();
     if (!field) {
-        return "";
+        return;
     }
     
-    return "ADD COLUMN " + ColumnDefinition(field);
+    out += "ADD COLUMN ";
+    out += ColumnDefinition(field);
 }
 
-std::string TPostgresBuilder::BuildDropColumn(TDropColumnPtr dropColumn) {
+void TPostgresBuilder::BuildDropColumn(TDropColumnPtr dropColumn, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::DropColumn);
     auto field = dropColumn->GetField();
     if (!field) {
-        return "";
+        return;
     }
     
-    return Format("DROP COLUMN {}", FieldToString(field->GetPath().GetField(), EKeyType::Simple));
+    out += "DROP COLUMN ";
+    AppendFieldName(out, field->GetPath().GetField(), EKeyType::Simple);
 }
 
-std::string TPostgresBuilder::BuildAlterColumn(TAlterColumnPtr alterColumn) {
+void TPostgresBuilder::BuildAlterColumn(TAlterColumnPtr alterColumn, std::string& out) {
     auto guard = Stack_.push(NOrm::NRelation::Builder::EClauseType::AlterColumn);
     
+    out += "ALTER COLUMN ";
+    AppendFieldName(out, alterColumn->GetColumn()->GetFieldPath(), EKeyType::Simple);
+    
     // Изменение типа
     switch (alterColumn->GetAlterType()) {
         case TAlterColumn::kSetType:
-            return Format("ALTER COLUMN {} TYPE {}",
-                FieldToString(alterColumn->GetColumn()->GetFieldPath(), EKeyType::Simple),
-                GetPostgresType(*alterColumn->GetValueType()));
+            out += " TYPE ";
+            out += GetPostgresType(*alterColumn->GetValueType());
+            break;
         case TAlterColumn::kSetDefault:
-            return Format("ALTER COLUMN {} SET DEFAULT {}",
-                FieldToString(alterColumn->GetColumn()->GetFieldPath(), EKeyType::Simple),
-                GetPostgresDefault(*alterColumn->GetValueType()));
+            out += " SET DEFAULT ";
+            out += GetPostgresDefault(*alterColumn->GetValueType());
+            break;
         case TAlterColumn::kDropDefault:
-            return Format("ALTER COLUMN {} DROP NOT NULL", FieldToString(alterColumn->GetColumn()->GetFieldPath(), EKeyType::Simple));
+            out += " DROP NOT NULL";
+            break;
         case TAlterColumn::kSetRequired:
-            return Format("ALTER COLUMN {} SET NOT NULL", FieldToString(alterColumn->GetColumn()->GetFieldPath(), EKeyType::Simple));
+            out += " SET NOT NULL";
+            break;
         case TAlterColumn::kDropRequired:
-            return Format("ALTER COLUMN {} DROP NOT NULL", FieldToString(alterColumn->GetColumn()->GetFieldPath(), EKeyType::Simple));
+            out += " DROP NOT NULL";
+            break;
         default:
             THROW("Uknonw type of alteration");
     }
 }
 
 std::string TPostgresBuilder::JoinQueries(const std::vector<std::string>& queries) {
-    std::ostringstream oss;
+    std::string result;
     
     for (size_t i = 0; i < queries.size(); ++i) {
         if (!queries[i].empty()) {
-            if (i > 0) oss << "; ";
-            oss << queries[i];
+            if (i > 0) {
+                result += "; ";
+            }
+            result += queries[i];
         }
     }
     
-    return oss.str();
+    return result;
 }
 
 } // namespace NOrm::NRelation::Builder
@@ -4,6 +4,7 @@
 #include <relation/relation_manager.h>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace NOrm::NRelation::Builder {
@@ -81,55 +82,66 @@ public:
 
 } // namespace
 
+// Результат параметризованной сборки: текст запроса с плейсхолдерами $1..$n
+// и значения параметров в текстовом представлении PostgreSQL.
+// Текст запроса не содержит литералов и может служить ключом кэша подготовленных выражений.
+struct TParameterizedQuery {
+    std::string Query;
+    std::vector<std::string> Params;
+};
+
 class TPostgresBuilder : public TBuilderBase, public std::enable_shared_from_this<TPostgresBuilder> {
 public:
     TPostgresBuilder();
     ~TPostgresBuilder() override;
 
+    // Сборка запроса, в которой литералы заменяются на $1..$n
+    TParameterizedQuery BuildParameterized(TClausePtr clause);
+
 protected:
     // Базовые типы данных (protected)
-    std::string BuildString(TStringPtr value) override;
-    std::string BuildInt(TIntPtr value) override;
-    std::string BuildFloat(TFloatPtr value) override;
-    std::string BuildBool(TBoolPtr value) override;
+    void BuildString(TStringPtr value, std::string& out) override;
+    void BuildInt(TIntPtr value, std::string& out) override;
+    void BuildFloat(TFloatPtr value, std::string& out) override;
+    void BuildBool(TBoolPtr value, std::string& out) override;
 
     // Выражения и колонки
-    std::string BuildExpression(TExpressionPtr expression) override;
-    std::string BuildAll(TAllPtr all) override;
-    std::string BuildColumn(TColumnPtr column) override;
-    std::string BuildTable(TTablePtr table) override;
-    std::string BuildDefault(TDefaultPtr defaultVal) override;
+    void BuildExpression(TExpressionPtr expression, std::string& out) override;
+    void BuildAll(TAllPtr all, std::string& out) override;
+    void BuildColumn(TColumnPtr column, std::string& out) override;
+    void BuildTable(TTablePtr table, std::string& out) override;
+    void BuildDefault(TDefaultPtr defaultVal, std::string& out) override;
     
-    std::string BuildJoin(TJoinPtr join) override;
+    void BuildJoin(TJoinPtr join, std::string& out) override;
 
     // Запросы SELECT
-    std::string BuildSelect(TSelectPtr select) override;
+    void BuildSelect(TSelectPtr select, std::string& out) override;
     
     // Запросы INSERT
-    std::string BuildInsert(TInsertPtr insert) override;
+    void BuildInsert(TInsertPtr insert, std::string& out) override;
     
     // Запросы UPDATE
-    std::string BuildUpdate(TUpdatePtr update) override;
+    void BuildUpdate(TUpdatePtr update, std::string& out) override;
     
     // Запросы DELETE
-    std::string BuildDelete(TDeletePtr deleteClause) override;
-    std::string BuildTruncate(TTruncatePtr truncate) override;
+    void BuildDelete(TDeletePtr deleteClause, std::string& out) override;
+    void BuildTruncate(TTruncatePtr truncate, std::string& out) override;
 
     // Транзакции
-    std::string BuildStartTransaction(TStartTransactionPtr startTransaction) override;
-    std::string BuildCommitTransaction(TCommitTransactionPtr commitTransaction) override;
-    std::string BuildRollbackTransaction(TRollbackTransactionPtr rollbackTransaction) override;
+    void BuildStartTransaction(TStartTransactionPtr startTransaction, std::string& out) override;
+    void BuildCommitTransaction(TCommitTransactionPtr commitTransaction, std::string& out) override;
+    void BuildRollbackTransaction(TRollbackTransactionPtr rollbackTransaction, std::string& out) override;
 
     // Операции с таблицами
-    std::string BuildColumnDefinition(TColumnDefinitionPtr columnDefinition) override;
-    std::string BuildCreateTable(TCreateTablePtr createTable) override;
-    std::string BuildDropTable(TDropTablePtr dropTable) override;
-    std::string BuildAlterTable(TAlterTablePtr alterTable) override;
+    void BuildColumnDefinition(TColumnDefinitionPtr columnDefinition, std::string& out) override;
+    void BuildCreateTable(TCreateTablePtr createTable, std::string& out) override;
+    void BuildDropTable(TDropTablePtr dropTable, std::string& out) override;
+    void BuildAlterTable(TAlterTablePtr alterTable, std::string& out) override;
     
     // Операции с колонками
-    std::string BuildAddColumn(TAddColumnPtr addColumn) override;
-    std::string BuildDropColumn(TDropColumnPtr dropColumn) override;
-    std::string BuildAlterColumn(TAlterColumnPtr alterColumn) override;
+    void BuildAddColumn(TAddColumnPtr addColumn, std::string& out) override;
+    void BuildDropColumn(TDropColumnPtr dropColumn, std::string& out) override;
+    void BuildAlterColumn(TAlterColumnPtr alterColumn, std::string& out) override;
     
     // Объединение запросов
     std::string JoinQueries(const std::vector<std::string>& queries) override;
@@ -143,9 +155,14 @@ private:
     std::string ColumnDefinition(NOrm::NRelation::TPrimitiveFieldInfoPtr field);
     
     // Вспомогательные методы
-    std::vector<std::string> BuildVector(const std::vector<TClausePtr>& clauses);
+    void AppendList(const std::vector<TClausePtr>& clauses, std::string& out);
+    void AppendAssignments(const std::vector<std::pair<TClausePtr, TClausePtr>>& assignments, std::string& out);
+    void AddParam(std::string value, std::string_view type, std::string& out);
 
     StackWrapper<NOrm::NRelation::Builder::EClauseType> Stack_;
+
+    bool Parameterized_ = false;
+    std::vector<std::string> Params_;
 };
 
 using TPostgresBuilderPtr = std::shared_ptr<TPostgresBuilder>;
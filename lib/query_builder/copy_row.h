@@ -0,0 +1,19 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace NOrm::NRelation {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Строка для COPY: значения в текстовом представлении PostgreSQL, nullopt — NULL
+using TCopyRow = std::vector<std::optional<std::string>>;
+// Заполняет очередную строку, возвращает false, когда строки закончились
+using TCopyRowSource = std::function<bool(TCopyRow&)>;
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
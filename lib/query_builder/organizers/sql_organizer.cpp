@@ -2,8 +2,56 @@
 
 #include <relation/relation_manager.h>
 
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
 namespace NOrm::NRelation {
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+std::string FloatToString(T value) {
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<T>::max_digits10);
+    oss << value;
+    return oss.str();
+}
+
+// uint32 хранится в колонке INTEGER, значения от 2^31 ложатся в отрицательные.
+// Все пути записи должны кодировать его одинаково
+int32_t ToIntegerColumn(uint32_t value) {
+    return static_cast<int32_t>(value);
+}
+
+// Текстовое представление значения атрибута для COPY
+std::optional<std::string> AttributeToCopyValue(const TAttribute& attribute) {
+    if (std::holds_alternative<bool>(attribute.Data)) {
+        return std::get<bool>(attribute.Data) ? "t" : "f";
+    } else if (std::holds_alternative<uint32_t>(attribute.Data)) {
+        return std::to_string(ToIntegerColumn(std::get<uint32_t>(attribute.Data)));
+    } else if (std::holds_alternative<int32_t>(attribute.Data)) {
+        return std::to_string(std::get<int32_t>(attribute.Data));
+    } else if (std::holds_alternative<uint64_t>(attribute.Data)) {
+        return std::to_string(std::get<uint64_t>(attribute.Data));
+    } else if (std::holds_alternative<int64_t>(attribute.Data)) {
+        return std::to_string(std::get<int64_t>(attribute.Data));
+    } else if (std::holds_alternative<float>(attribute.Data)) {
+        return FloatToString(std::get<float>(attribute.Data));
+    } else if (std::holds_alternative<double>(attribute.Data)) {
+        return FloatToString(std::get<double>(attribute.Data));
+    } else if (std::holds_alternative<std::string>(attribute.Data)) {
+        return std::get<std::string>(attribute.Data);
+    }
+    return std::nullopt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 
 Builder::TClausePtr TSqlQueryOrganizer::TransformClause(TClause clause) const {
@@ -52,27 +100,7 @@ Builder::TClausePtr TSqlQueryOrganizer::TransformClause(TClause clause) const {
         }
         case NOrm::NApi::TClause::ValueCase::kColumn: {
             TColumn columnClause = clause;
-            const auto& path = columnClause.GetPath();
-            auto hash = GetHash(path.GetTable());
-            auto& relationManager = TRelationManager::GetInstance();
-            auto table = relationManager.GetParentTable(path);
-            
-            if (!table) {
-                THROW("Unable to get parent table for path: {}", path.String());
-            }
-            
-            auto field = relationManager.GetPrimitiveField(path);
-            
-            if (!field) {
-                // Если field равен nullptr, используем путь напрямую
-                auto result = std::make_shared<Builder::TColumn>(table->GetPath().data(), path.GetField());
-                result->SetKeyType(Builder::EKeyType::Simple);
-                return result;
-            }
-            
-            auto result = std::make_shared<Builder::TColumn>(table->GetPath().data(), field->GetPath().GetField());
-            result->SetKeyType(Builder::EKeyType::Simple);
-            return result;
+            return TransformColumn(columnClause.GetPath());
         }
         case NOrm::NApi::TClause::ValueCase::kAll: {
             return std::make_shared<Builder::TAll>();
@@ -89,29 +117,54 @@ Builder::TClausePtr TSqlQueryOrganizer::TransformClause(TClause clause) const {
 }
 
 std::vector<Builder::TClausePtr> TSqlQueryOrganizer::ExpandSelector(TClause clause) const {
-    auto& relationManager = TRelationManager::GetInstance();
-
     if (clause.Type() == NOrm::NApi::TClause::ValueCase::kColumn) {
         auto column = TColumn(clause);
-        std::vector<Builder::TClausePtr> result;
-
-        if (relationManager.GetObjectType(column.GetPath()) & EObjectType::Message) {
-            for (const auto& [_, message] : relationManager.GetMessagesFromSubtree(column.GetPath())) {
-                for (const auto& field : message->PrimitiveFields()) {
-                    auto builderColumn = std::make_shared<Builder::TColumn>(field->GetPath().GetTable(), field->GetPath().GetField());
-                    builderColumn->SetKeyType(Builder::EKeyType::Simple);
-                    result.push_back(builderColumn);
-                }
+        return ExpandColumn(column.GetPath());
+    } else {
+        return {TransformClause(clause)};
+    }
+}
+
+Builder::TClausePtr TSqlQueryOrganizer::TransformColumn(const TMessagePath& path) const {
+    auto& relationManager = TRelationManager::GetInstance();
+    auto table = relationManager.GetParentTable(path);
+    
+    if (!table) {
+        THROW("Unable to get parent table for path: {}", path.String());
+    }
+    
+    auto field = relationManager.GetPrimitiveField(path);
+    
+    if (!field) {
+        // Если field равен nullptr, используем путь напрямую
+        auto result = std::make_shared<Builder::TColumn>(table->GetPath().data(), path.GetField());
+        result->SetKeyType(Builder::EKeyType::Simple);
+        return result;
+    }
+    
+    auto result = std::make_shared<Builder::TColumn>(table->GetPath().data(), field->GetPath().GetField());
+    result->SetKeyType(Builder::EKeyType::Simple);
+    return result;
+}
+
+std::vector<Builder::TClausePtr> TSqlQueryOrganizer::ExpandColumn(const TMessagePath& path) const {
+    auto& relationManager = TRelationManager::GetInstance();
+    std::vector<Builder::TClausePtr> result;
+
+    if (relationManager.GetObjectType(path) & EObjectType::Message) {
+        for (const auto& [_, message] : relationManager.GetMessagesFromSubtree(path)) {
+            for (const auto& field : message->PrimitiveFields()) {
+                auto builderColumn = std::make_shared<Builder::TColumn>(field->GetPath().GetTable(), field->GetPath().GetField());
+                builderColumn->SetKeyType(Builder::EKeyType::Simple);
+                result.push_back(builderColumn);
             }
-        } else {
-            auto builderColumn = std::make_shared<Builder::TColumn>(column.GetPath().GetTable(), column.GetPath().GetField());
-            builderColumn->SetKeyType(Builder::EKeyType::Simple);
-            result.push_back(builderColumn);
         }
-        return result;
     } else {
-        return {TransformClause(clause)};
+        auto builderColumn = std::make_shared<Builder::TColumn>(path.GetTable(), path.GetField());
+        builderColumn->SetKeyType(Builder::EKeyType::Simple);
+        result.push_back(builderColumn);
     }
+    return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -146,6 +199,103 @@ Builder::TSelectPtr TSqlQueryOrganizer::OrganizeSelect(const TSelect& query) con
 
 ////////////////////////////////////////////////////////////////////////////////
 
+Builder::TClausePtr TSqlQueryOrganizer::TransformClause(const TClauseView& clause) const {
+    if (!clause) {
+        return nullptr;
+    }
+
+    const auto& value = clause.Get();
+    switch (clause.Type()) {
+        case NOrm::NApi::TClause::ValueCase::kString: {
+            auto result = std::make_shared<Builder::TString>();
+            result->SetValue(value.string().value());
+            return result;
+        }
+        case NOrm::NApi::TClause::ValueCase::kInteger: {
+            auto result = std::make_shared<Builder::TInt>();
+            result->SetValue(value.integer().value());
+            return result;
+        }
+        case NOrm::NApi::TClause::ValueCase::kFloat: {
+            auto result = std::make_shared<Builder::TFloat>();
+            result->SetValue(value.float_().value());
+            return result;
+        }
+        case NOrm::NApi::TClause::ValueCase::kBool: {
+            auto result = std::make_shared<Builder::TBool>();
+            result->SetValue(value.bool_().value());
+            return result;
+        }
+        case NOrm::NApi::TClause::ValueCase::kExpression: {
+            const auto& expression = value.expression();
+            auto result = std::make_shared<Builder::TExpression>();
+            
+            std::vector<Builder::TClausePtr> operands;
+            operands.reserve(expression.operands_size());
+            for (auto operand : expression.operands()) {
+                operands.push_back(TransformClause(clause.Child(operand)));
+            }
+            
+            result->SetOperands(operands);
+            result->SetExpressionType(expression.expression_type());
+            return result;
+        }
+        case NOrm::NApi::TClause::ValueCase::kColumn: {
+            const auto& path = value.column().field_path();
+            return TransformColumn(TMessagePath(path.begin(), path.end()));
+        }
+        case NOrm::NApi::TClause::ValueCase::kAll: {
+            return std::make_shared<Builder::TAll>();
+        }
+        case NOrm::NApi::TClause::ValueCase::kDefault: {
+            return std::make_shared<Builder::TDefault>();
+        }
+        case NOrm::NApi::TClause::ValueCase::kSelect: {
+            return OrganizeSelect(clause);
+        }
+        default:
+            return nullptr;
+    }
+}
+
+std::vector<Builder::TClausePtr> TSqlQueryOrganizer::ExpandSelector(const TClauseView& clause) const {
+    if (clause.Type() == NOrm::NApi::TClause::ValueCase::kColumn) {
+        const auto& path = clause.Get().column().field_path();
+        return ExpandColumn(TMessagePath(path.begin(), path.end()));
+    } else {
+        return {TransformClause(clause)};
+    }
+}
+
+Builder::TSelectPtr TSqlQueryOrganizer::OrganizeSelect(const TClauseView& query) const {
+    ASSERT(query.Type() == NOrm::NApi::TClause::ValueCase::kSelect, "Clause {} is not a select", query.GetIndex());
+    const auto& select = query.Get().select();
+    Builder::TSelectPtr result = std::make_shared<Builder::TSelect>();
+
+    std::vector<Builder::TClausePtr> selectorArray;
+    for (auto selector : select.selectors()) {
+        auto subResult = ExpandSelector(query.Child(selector));
+        selectorArray.insert(selectorArray.end(), subResult.begin(), subResult.end());
+    }
+    result->SetSelectors(selectorArray);
+
+    result->SetFrom(std::make_shared<Builder::TTable>(TMessagePath{select.table_num()}));
+
+    result->SetWhere(TransformClause(query.OptionalChild(select.has_where(), select.where())));
+
+    result->SetHaving(TransformClause(query.OptionalChild(select.has_having(), select.having())));
+
+    result->SetGroupBy(TransformClause(query.OptionalChild(select.has_group_by(), select.group_by())));
+
+    result->SetOrderBy(TransformClause(query.OptionalChild(select.has_order_by(), select.order_by())));
+
+    result->SetLimit(TransformClause(query.OptionalChild(select.has_limit(), select.limit())));
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Builder::TInsertPtr TSqlQueryOrganizer::OrganizeInsert(const TInsert& query) const {
     Builder::TInsertPtr result = std::make_shared<Builder::TInsert>(TMessagePath(query.GetTableNum()));
     
@@ -201,7 +351,7 @@ Builder::TInsertPtr TSqlQueryOrganizer::OrganizeInsert(const TInsert& query) con
                 value = boolValue;
             } else if (std::holds_alternative<uint32_t>(attribute.Data)) {
                 auto intValue = std::make_shared<Builder::TInt>();
-                intValue->SetValue(static_cast<int32_t>(std::get<uint32_t>(attribute.Data)));
+                intValue->SetValue(ToIntegerColumn(std::get<uint32_t>(attribute.Data)));
                 value = intValue;
             } else if (std::holds_alternative<int32_t>(attribute.Data)) {
                 auto intValue = std::make_shared<Builder::TInt>();
@@ -273,6 +423,61 @@ Builder::TInsertPtr TSqlQueryOrganizer::OrganizeInsert(const TInsert& query) con
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::optional<TCopyInsert> TSqlQueryOrganizer::OrganizeCopyInsert(const TInsert& query) const {
+    // COPY не умеет ON CONFLICT
+    if (query.GetUpdateIfExists() || query.GetSubrequests().empty()) {
+        return std::nullopt;
+    }
+
+    const auto& subrequests = query.GetSubrequests();
+
+    TCopyInsert result;
+    result.Table = std::make_shared<Builder::TTable>(TMessagePath(query.GetTableNum()));
+
+    std::map<TMessagePath, size_t> pathToIndex;
+    for (const auto& attribute : subrequests[0]) {
+        if (std::holds_alternative<std::shared_ptr<google::protobuf::Message>>(attribute.Data)) {
+            return std::nullopt;
+        }
+        auto column = std::make_shared<Builder::TColumn>(std::vector<uint32_t>{}, attribute.Path.GetField());
+        column->SetKeyType(Builder::EKeyType::Simple);
+        result.Columns.push_back(column);
+        pathToIndex[attribute.Path] = result.Columns.size() - 1;
+    }
+
+    // Пропущенное значение в COPY превращается в NULL, а не в DEFAULT,
+    // поэтому все строки должны содержать одинаковый набор колонок
+    for (const auto& subrequest : subrequests) {
+        if (subrequest.size() != pathToIndex.size()) {
+            return std::nullopt;
+        }
+        for (const auto& attribute : subrequest) {
+            if (!pathToIndex.contains(attribute.Path)
+                || std::holds_alternative<std::shared_ptr<google::protobuf::Message>>(attribute.Data)) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    // Строк может быть сотни тысяч, поэтому запрос не копируется
+    result.NextRow = [&subrequests, pathToIndex = std::move(pathToIndex), row = size_t(0)](TCopyRow& output) mutable {
+        if (row == subrequests.size()) {
+            return false;
+        }
+
+        output.assign(pathToIndex.size(), std::nullopt);
+        for (const auto& attribute : subrequests[row]) {
+            output[pathToIndex.at(attribute.Path)] = AttributeToCopyValue(attribute);
+        }
+        ++row;
+        return true;
+    };
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Builder::TQueryPtr TSqlQueryOrganizer::OrganizeUpdate(const TUpdate& query) const {
     // Создаем общий объект Builder::TQuery для хранения запросов UPDATE
     auto queryPtr = std::make_shared<Builder::TQuery>();
@@ -300,11 +505,11 @@ Builder::TQueryPtr TSqlQueryOrganizer::OrganizeUpdate(const TUpdate& query) cons
         const auto& primaryKeys = tableInfo->GetPrimaryFields();
         
         // Проверяем, что все первичные ключи присутствуют в атрибутах
-        std::set<size_t> foundPrimaryKeys;
+        std::set<TObjectId> foundPrimaryKeys;
         for (const auto& attribute : attributeSet) {
-            auto attributeHash = GetHash(attribute.Path);
-            if (primaryKeys.find(attributeHash) != primaryKeys.end()) {
-                foundPrimaryKeys.insert(attributeHash);
+            auto attributeId = relationManager.Resolve(attribute.Path);
+            if (std::find(primaryKeys.begin(), primaryKeys.end(), attributeId) != primaryKeys.end()) {
+                foundPrimaryKeys.insert(attributeId);
             }
         }
         
@@ -331,7 +536,7 @@ Builder::TQueryPtr TSqlQueryOrganizer::OrganizeUpdate(const TUpdate& query) cons
         std::vector<Builder::TClausePtr> whereConditions;
         
         for (const auto& attribute : attributeSet) {
-            auto attributeHash = GetHash(attribute.Path);
+            auto attributeId = relationManager.Resolve(attribute.Path);
             
             // Создаем объект колонки для атрибута
             auto column = std::make_shared<Builder::TColumn>(attribute.Path.GetTable(), attribute.Path.GetField());
@@ -346,7 +551,7 @@ Builder::TQueryPtr TSqlQueryOrganizer::OrganizeUpdate(const TUpdate& query) cons
                 value = boolValue;
             } else if (std::holds_alternative<uint32_t>(attribute.Data)) {
                 auto intValue = std::make_shared<Builder::TInt>();
-                intValue->SetValue(static_cast<int32_t>(std::get<uint32_t>(attribute.Data)));
+                intValue->SetValue(ToIntegerColumn(std::get<uint32_t>(attribute.Data)));
                 value = intValue;
             } else if (std::holds_alternative<int32_t>(attribute.Data)) {
                 auto intValue = std::make_shared<Builder::TInt>();
@@ -378,7 +583,7 @@ Builder::TQueryPtr TSqlQueryOrganizer::OrganizeUpdate(const TUpdate& query) cons
             }
             
             // Проверяем, является ли атрибут первичным ключом
-            if (primaryKeys.find(attributeHash) != primaryKeys.end()) {
+            if (std::find(primaryKeys.begin(), primaryKeys.end(), attributeId) != primaryKeys.end()) {
                 // Если это первичный ключ, добавляем условие для WHERE
                 auto equalsExpr = std::make_shared<Builder::TExpression>();
                 equalsExpr->SetExpressionType(NOrm::NQuery::EExpressionType::equals);
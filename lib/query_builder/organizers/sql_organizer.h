@@ -1,18 +1,41 @@
 #pragma once
 
 #include <query_builder/builder_base.h>
+#include <query_builder/copy_row.h>
 #include <query_builder/query_organizer_base.h>
+#include <requests/query_view.h>
+
+#include <optional>
 
 namespace NOrm::NRelation {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Вставка для потоковой загрузки через COPY ... FROM STDIN.
+// Строки кодируются по одной прямо из атрибутов TInsert, без построения клауз
+// и без копирования запроса: TInsert должен жить, пока вызывается NextRow.
+struct TCopyInsert {
+    Builder::TTablePtr Table;
+    // Колонки без пути таблицы, как того требует список колонок COPY
+    std::vector<Builder::TClausePtr> Columns;
+    TCopyRowSource NextRow;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class TSqlQueryOrganizer : public TQueryOrganizerBase {
 public:
     TSqlQueryOrganizer();
 
     Builder::TSelectPtr OrganizeSelect(const TSelect& query) const override;
+    // То же, что OrganizeSelect, но читает запрос прямо из разобранного
+    // NApi::TQuery, без восстановления дерева TClause через FromProto
+    Builder::TSelectPtr OrganizeSelect(const TClauseView& query) const;
     Builder::TInsertPtr OrganizeInsert(const TInsert& query) const override;
+    // Возвращает nullopt, если вставку нельзя выразить через COPY
+    // (upsert, разный набор колонок в строках, вложенные сообщения),
+    // в этом случае нужно использовать OrganizeInsert. Результат ссылается на query
+    std::optional<TCopyInsert> OrganizeCopyInsert(const TInsert& query) const;
     Builder::TQueryPtr OrganizeUpdate(const TUpdate& query) const override;
     Builder::TQueryPtr OrganizeDelete(const TDelete& query) const override;
     
@@ -27,6 +50,12 @@ private:
     Builder::TClausePtr TransformClause(TClause clause) const;
 
     std::vector<Builder::TClausePtr> ExpandSelector(TClause clause) const;
+
+    Builder::TClausePtr TransformClause(const TClauseView& clause) const;
+    std::vector<Builder::TClausePtr> ExpandSelector(const TClauseView& clause) const;
+
+    Builder::TClausePtr TransformColumn(const TMessagePath& path) const;
+    std::vector<Builder::TClausePtr> ExpandColumn(const TMessagePath& path) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,252 @@
+#include <query_builder/query_plan_cache.h>
+
+#include <common/logging.h>
+#include <relation/relation_manager.h>
+
+#include <limits>
+#include <sstream>
+
+namespace NOrm::NRelation {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Обходит дерево клауз в том же порядке, в котором TPostgresBuilder
+// расставляет плейсхолдеры, и записывает структуру в сигнатуру
+class TShapeWriter {
+public:
+    explicit TShapeWriter(TQueryShape& shape)
+        : Shape_(shape) {}
+
+    bool WriteSelect(TSelect select) {
+        WriteTag('Q');
+        WriteNumber(select.GetTableNum());
+
+        const auto& selectors = select.GetSelectors();
+        WriteNumber(selectors.size());
+        for (const auto& selector : selectors) {
+            if (!WriteClause(selector)) {
+                return false;
+            }
+        }
+
+        // Порядок совпадает с порядком секций в SELECT
+        return WriteOptional(select.GetWhere())
+            && WriteOptional(select.GetGroupBy())
+            && WriteOptional(select.GetHaving())
+            && WriteOptional(select.GetOrderBy())
+            && WriteOptional(select.GetLimit());
+    }
+
+private:
+    bool WriteOptional(TClause clause) {
+        if (!bool(clause)) {
+            WriteTag('-');
+            return true;
+        }
+        return WriteClause(clause);
+    }
+
+    bool WriteClause(TClause clause) {
+        switch (clause.Type()) {
+            case NOrm::NApi::TClause::ValueCase::kString: {
+                TString stringClause = clause;
+                WriteTag('s');
+                Shape_.Params.push_back(stringClause.GetValue());
+                return true;
+            }
+            case NOrm::NApi::TClause::ValueCase::kInteger: {
+                TInt intClause = clause;
+                WriteTag('i');
+                Shape_.Params.push_back(std::to_string(intClause.GetValue()));
+                return true;
+            }
+            case NOrm::NApi::TClause::ValueCase::kFloat: {
+                TFloat floatClause = clause;
+                WriteTag('f');
+                // Так же, как TPostgresBuilder передает параметры с плавающей точкой
+                std::ostringstream oss;
+                oss.precision(std::numeric_limits<double>::max_digits10);
+                oss << floatClause.GetValue();
+                Shape_.Params.push_back(oss.str());
+                return true;
+            }
+            case NOrm::NApi::TClause::ValueCase::kBool: {
+                TBool boolClause = clause;
+                WriteTag('b');
+                Shape_.Params.push_back(boolClause.GetValue() ? "true" : "false");
+                return true;
+            }
+            case NOrm::NApi::TClause::ValueCase::kExpression: {
+                TExpression expression = clause;
+                const auto& operands = expression.GetOperands();
+                WriteTag('E');
+                WriteNumber(static_cast<uint32_t>(expression.GetExpressionType()));
+                WriteNumber(operands.size());
+
+                // LOG(base, value): операнды записываются в обратном порядке
+                if (expression.GetExpressionType() == NOrm::NQuery::EExpressionType::log && operands.size() == 2) {
+                    return WriteClause(operands[1]) && WriteClause(operands[0]);
+                }
+                for (const auto& operand : operands) {
+                    if (!WriteClause(operand)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case NOrm::NApi::TClause::ValueCase::kColumn: {
+                TColumn column = clause;
+                const auto& path = column.GetPath().data();
+                WriteTag('C');
+                WriteNumber(static_cast<uint32_t>(column.GetType()));
+                WriteNumber(path.size());
+                for (auto entry : path) {
+                    WriteNumber(entry);
+                }
+                return true;
+            }
+            case NOrm::NApi::TClause::ValueCase::kAll:
+                WriteTag('*');
+                return true;
+            case NOrm::NApi::TClause::ValueCase::kDefault:
+                WriteTag('D');
+                return true;
+            case NOrm::NApi::TClause::ValueCase::kSelect:
+                return WriteSelect(clause);
+            default:
+                return false;
+        }
+    }
+
+    void WriteTag(char tag) {
+        Shape_.Signature += tag;
+    }
+
+    void WriteNumber(uint64_t value) {
+        Shape_.Signature.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    TQueryShape& Shape_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::optional<TQueryShape> GetQueryShape(const TSelect& query) {
+    TQueryShape shape;
+    if (!TShapeWriter(shape).WriteSelect(query)) {
+        return std::nullopt;
+    }
+    return shape;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TQueryPlanCache::TQueryPlanCache(size_t capacity)
+    : Capacity_(capacity) {
+    ASSERT(Capacity_ > 0, "Query plan cache capacity must be positive");
+}
+
+Builder::TParameterizedQuery TQueryPlanCache::BuildSelect(const TSelect& query) {
+    // Версия читается до сборки: если схема сменится во время сборки, запись
+    // попадет под старую версию и будет сброшена при следующем обращении
+    auto schemaVersion = TRelationManager::GetInstance().GetSchemaVersion();
+    auto shape = GetQueryShape(query);
+    if (shape) {
+        if (auto cached = Find(shape->Signature, schemaVersion)) {
+            Hits_.fetch_add(1, std::memory_order_relaxed);
+            return {std::move(*cached), std::move(shape->Params)};
+        }
+    }
+    Misses_.fetch_add(1, std::memory_order_relaxed);
+
+    // Сборка вне блокировки: билдер хранит состояние, поэтому свой на каждый промах
+    Builder::TPostgresBuilder builder;
+    auto result = builder.BuildParameterized(Organizer_.OrganizeSelect(query));
+
+    if (!shape) {
+        return result;
+    }
+    // Шаблон кэшируется, только если литералы из дерева запроса в точности
+    // соответствуют плейсхолдерам, которые расставил билдер
+    if (shape->Params != result.Params) {
+        LOG_WARNING("Query shape does not match its parameters, query is not cached: {}", result.Query);
+        return result;
+    }
+
+    Insert(shape->Signature, result.Query, schemaVersion);
+    return result;
+}
+
+void TQueryPlanCache::Clear() {
+    std::lock_guard lock(Mutex_);
+    Entries_.clear();
+    Lru_.clear();
+}
+
+uint64_t TQueryPlanCache::GetHitCount() const {
+    return Hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t TQueryPlanCache::GetMissCount() const {
+    return Misses_.load(std::memory_order_relaxed);
+}
+
+size_t TQueryPlanCache::GetSize() const {
+    std::lock_guard lock(Mutex_);
+    return Entries_.size();
+}
+
+std::optional<std::string> TQueryPlanCache::Find(const std::string& signature, uint64_t schemaVersion) {
+    std::lock_guard lock(Mutex_);
+    if (!SyncSchemaVersion(schemaVersion)) {
+        return std::nullopt;
+    }
+    auto it = Entries_.find(signature);
+    if (it == Entries_.end()) {
+        return std::nullopt;
+    }
+    Lru_.splice(Lru_.begin(), Lru_, it->second.LruPosition);
+    return it->second.Query;
+}
+
+void TQueryPlanCache::Insert(const std::string& signature, const std::string& query, uint64_t schemaVersion) {
+    std::lock_guard lock(Mutex_);
+    if (!SyncSchemaVersion(schemaVersion)) {
+        // Запрос собран по схеме, которую уже сменили
+        return;
+    }
+    if (Entries_.contains(signature)) {
+        // Шаблон уже добавил другой поток
+        return;
+    }
+
+    while (Entries_.size() >= Capacity_) {
+        Entries_.erase(Lru_.back());
+        Lru_.pop_back();
+    }
+
+    Lru_.push_front(signature);
+    Entries_.emplace(signature, TEntry{query, Lru_.begin()});
+}
+
+bool TQueryPlanCache::SyncSchemaVersion(uint64_t schemaVersion) {
+    if (schemaVersion < SchemaVersion_) {
+        return false;
+    }
+    if (schemaVersion > SchemaVersion_) {
+        Entries_.clear();
+        Lru_.clear();
+        SchemaVersion_ = schemaVersion;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <query_builder/builders/postgres.h>
+#include <query_builder/organizers/sql_organizer.h>
+#include <requests/query.h>
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NOrm::NRelation {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Структура запроса без значений литералов
+struct TQueryShape {
+    // Сигнатура дерева клауз: типы узлов, пути колонок, типы литералов.
+    // Запросы, отличающиеся только литералами, имеют одинаковую сигнатуру.
+    std::string Signature;
+    // Значения литералов в порядке плейсхолдеров $1..$n, которые
+    // TPostgresBuilder::BuildParameterized расставляет для этого запроса
+    std::vector<std::string> Params;
+};
+
+// Возвращает nullopt, если в запросе есть клаузы, которые кэш не поддерживает
+std::optional<TQueryShape> GetQueryShape(const TSelect& query);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Кэш скомпилированных запросов: сигнатура структуры -> SQL с плейсхолдерами.
+// При попадании запрос не проходит через TSqlQueryOrganizer и TPostgresBuilder,
+// остается только подставить параметры.
+// Закэшированный SQL зависит от схемы: записи привязаны к версии снимка
+// TRelationManager и сбрасываются, когда публикуется новый снимок.
+class TQueryPlanCache {
+public:
+    explicit TQueryPlanCache(size_t capacity);
+
+    Builder::TParameterizedQuery BuildSelect(const TSelect& query);
+
+    void Clear();
+
+    uint64_t GetHitCount() const;
+    uint64_t GetMissCount() const;
+    size_t GetSize() const;
+
+private:
+    struct TEntry {
+        std::string Query;
+        std::list<std::string>::iterator LruPosition;
+    };
+
+    std::optional<std::string> Find(const std::string& signature, uint64_t schemaVersion);
+    void Insert(const std::string& signature, const std::string& query, uint64_t schemaVersion);
+    // Сбрасывает записи, если схема новее той, по которой они построены.
+    // Возвращает false, если версия запроса устарела. Вызывается под Mutex_
+    bool SyncSchemaVersion(uint64_t schemaVersion);
+
+    const size_t Capacity_;
+    TSqlQueryOrganizer Organizer_;
+
+    mutable std::mutex Mutex_;
+    std::unordered_map<std::string, TEntry> Entries_;
+    // В начале самые недавно использованные сигнатуры
+    std::list<std::string> Lru_;
+    // Версия снимка схемы, по которому построены записи
+    uint64_t SchemaVersion_ = 0;
+
+    std::atomic<uint64_t> Hits_ = 0;
+    std::atomic<uint64_t> Misses_ = 0;
+
+    inline static const std::string LoggingSource = "QueryPlanCache";
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
@@ -23,17 +23,9 @@ TFieldBasePtr RegisterMessageField(const google::protobuf::FieldDescriptor* desc
         return nullptr;
     }
 
+    // Родительское сообщение назначает сам TRelationManager
     auto field = std::make_shared<TFieldMessage>(desc, path);
-
-    auto& relationManager = TRelationManager::GetInstance();
-    auto parentMessage = relationManager.GetMessage(path);
-
-    relationManager.RegisterField(field);
-
-    if (parentMessage) {
-        relationManager.SetParentMessage(field, parentMessage);
-    }
-
+    TRelationManager::GetInstance().RegisterField(field);
     return field;
 }
 
@@ -53,6 +45,17 @@ void RegisterRootMessage(TTableConfigPtr config) {
     TRelationManager::GetInstance().RegisterRoot(rootMessage);
 }
 
+void RegisterRootMessages(const std::vector<TTableConfigPtr>& configs) {
+    std::vector<TRootMessagePtr> roots;
+    for (const auto& config : configs) {
+        if (config) {
+            roots.push_back(std::make_shared<TRootMessage>(config));
+        }
+    }
+
+    TRelationManager::GetInstance().RegisterRoots(roots);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 TMessageInfo::TMessageInfo(const google::protobuf::Descriptor* descriptor)
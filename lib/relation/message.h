@@ -118,6 +118,9 @@ using TRootMessagePtr = std::shared_ptr<TRootMessage>;
 
 void RegisterRootMessage(TTableConfigPtr config);
 
+// Регистрирует все таблицы и публикует схему один раз
+void RegisterRootMessages(const std::vector<TTableConfigPtr>& configs);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // namespace NOrm::NRelation
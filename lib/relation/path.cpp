@@ -3,6 +3,8 @@
 
 #include <common/exception.h>
 
+#include <algorithm>
+
 namespace NOrm::NRelation {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -11,7 +13,7 @@ size_t GetNextPathEntryHash(size_t parent, size_t entry) {
     return parent ^ (std::hash<size_t>{}(entry) + 0x9e3779b9 + (parent << 6) + (parent >> 2));
 }
 
-size_t GetHash(const std::vector<uint32_t>& path) {
+size_t GetHash(std::span<const uint32_t> path) {
     size_t hash_value = 0;
     for (const auto& entry : path) {
         hash_value = GetNextPathEntryHash(hash_value, entry);
@@ -19,54 +21,131 @@ size_t GetHash(const std::vector<uint32_t>& path) {
     return hash_value;
 }
 
+size_t GetHash(const std::vector<uint32_t>& path) {
+    return GetHash(std::span<const uint32_t>(path));
+}
+
 size_t GetHash(const NOrm::NRelation::TMessagePath& path) {
-    size_t hash_value = 0;
-    for (const auto& entry : path) {
-        hash_value = GetNextPathEntryHash(hash_value, entry);
-    }
-    return hash_value;
+    return path.Hash();
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 
-TMessagePath::TMessagePath(uint32_t entry)
-    : Path_({entry}) {}
+TMessagePath::TMessagePath(uint32_t entry) {
+    AppendEntry(entry);
+}
 
-TMessagePath::TMessagePath(const std::string& entry)
-    : Path_({})
-{
+TMessagePath::TMessagePath(const std::string& entry) {
     for (const auto& entry : NCommon::Split(entry, "/")) { AppendEntry(entry); }
 }
 
-TMessagePath::TMessagePath(const std::vector<uint32_t>& entries)
-    : Path_(entries) {}
+TMessagePath::TMessagePath(std::span<const uint32_t> entries) {
+    Assign(entries);
+}
+
+TMessagePath::TMessagePath(const std::vector<uint32_t>& entries) {
+    Assign(entries);
+}
 
-TMessagePath::TMessagePath(const TMessagePath& other)
-    : Path_(other.Path_) {}
+TMessagePath::TMessagePath(const TMessagePath& other) {
+    Assign(other.Number());
+}
 
-TMessagePath::TMessagePath(TMessagePath&& other) noexcept
-    : Path_(std::move(other.Path_)) {}
+TMessagePath::TMessagePath(TMessagePath&& other) noexcept {
+    *this = std::move(other);
+}
+
+TMessagePath::~TMessagePath() {
+    Reset();
+}
 
 TMessagePath& TMessagePath::operator=(const TMessagePath& other) {
     if (this != &other) {
-        Path_ = other.Path_;
+        Assign(other.Number());
     }
     return *this;
 }
 
 TMessagePath& TMessagePath::operator=(TMessagePath&& other) noexcept {
-    if (this != &other) {
-        Path_ = std::move(other.Path_);
+    if (this == &other) {
+        return *this;
+    }
+
+    Reset();
+    if (other.Capacity_ > InlineCapacity) {
+        Heap_ = other.Heap_;
+        Capacity_ = other.Capacity_;
+        other.Capacity_ = InlineCapacity;
+    } else {
+        std::copy_n(other.Inline_, other.Size_, Inline_);
     }
+    Size_ = other.Size_;
+    Hash_ = other.Hash_;
+    other.Size_ = 0;
+    other.Hash_ = 0;
+    return *this;
+}
+
+TMessagePath::TEntryReference::TEntryReference(TMessagePath* path, size_t index)
+    : Path_(path), Index_(index)
+{ }
+
+TMessagePath::TEntryReference::operator uint32_t() const {
+    return Path_->Entries()[Index_];
+}
+
+TMessagePath::TEntryReference& TMessagePath::TEntryReference::operator=(uint32_t entry) {
+    Path_->Entries()[Index_] = entry;
+    Path_->Hash_ = GetHash(Path_->Number());
     return *this;
 }
 
+uint32_t* TMessagePath::Entries() {
+    return Capacity_ > InlineCapacity ? Heap_ : Inline_;
+}
+
+const uint32_t* TMessagePath::Entries() const {
+    return Capacity_ > InlineCapacity ? Heap_ : Inline_;
+}
+
+void TMessagePath::Reserve(size_t capacity) {
+    if (capacity <= Capacity_) {
+        return;
+    }
+
+    capacity = std::max<size_t>(capacity, size_t(Capacity_) * 2);
+    auto* heap = new uint32_t[capacity];
+    std::copy_n(Entries(), Size_, heap);
+    if (Capacity_ > InlineCapacity) {
+        delete[] Heap_;
+    }
+    Heap_ = heap;
+    Capacity_ = static_cast<uint32_t>(capacity);
+}
+
+void TMessagePath::Assign(std::span<const uint32_t> entries) {
+    Size_ = 0;
+    Reserve(entries.size());
+    std::copy(entries.begin(), entries.end(), Entries());
+    Size_ = static_cast<uint32_t>(entries.size());
+    Hash_ = GetHash(entries);
+}
+
+void TMessagePath::Reset() {
+    if (Capacity_ > InlineCapacity) {
+        delete[] Heap_;
+        Capacity_ = InlineCapacity;
+    }
+    Size_ = 0;
+    Hash_ = 0;
+}
+
 uint32_t TMessagePath::at(int index) const {
-    if (index < 0 || index >= Path_.size()) {
+    if (index < 0 || index >= static_cast<int>(Size_)) {
         throw std::out_of_range("Index out of range");
     }
-    return Path_[index];
+    return Entries()[index];
 }
 
 TMessagePath& TMessagePath::operator/=(uint32_t entry) {
@@ -80,18 +159,19 @@ TMessagePath& TMessagePath::operator/=(const std::string& entry) {
 }
 
 void TMessagePath::AppendEntry(const std::string& entry) {
-    auto& relationManager = TRelationManager::GetInstance();
-    auto pathHash = GetHash(Path_);
-    ASSERT(relationManager.EntryNameToEntry_[pathHash].contains(entry), "Entry \"{}/{}\" does not exists", *this, entry);
-    Path_.push_back(relationManager.EntryNameToEntry_[pathHash].at(entry));
+    auto number = TRelationManager::GetInstance().FindEntry(*this, entry);
+    ASSERT(number, "Entry \"{}/{}\" does not exists", *this, entry);
+    AppendEntry(*number);
 }
 
 void TMessagePath::AppendEntry(uint32_t entry) {
-    Path_.push_back(entry);
+    Reserve(size_t(Size_) + 1);
+    Entries()[Size_++] = entry;
+    Hash_ = GetNextPathEntryHash(Hash_, entry);
 }
 
 TMessagePath& TMessagePath::operator/=(const google::protobuf::FieldDescriptor* desc) {
-    Path_.push_back(desc->number());
+    AppendEntry(static_cast<uint32_t>(desc->number()));
     return *this;
 }
 
@@ -111,82 +191,68 @@ TMessagePath TMessagePath::operator/(const google::protobuf::FieldDescriptor* de
 }
 
 std::vector<std::string> TMessagePath::String() const {
-    auto& relationManager = TRelationManager::GetInstance();
-    std::vector<std::string> result;
-    size_t hash = 0;
-    for (size_t el : Path_) {
-        hash = GetNextPathEntryHash(hash, el);
-        if (!relationManager.PathToEntryName_.contains(hash)) { return result; }
-        result.emplace_back(relationManager.PathToEntryName_.at(hash));
-    }
-    return result;
+    return TRelationManager::GetInstance().GetEntryNames(*this);
 }
 
-const std::vector<uint32_t>& TMessagePath::Number() const {
-    return Path_;
+std::span<const uint32_t> TMessagePath::Number() const {
+    return {Entries(), Size_};
 }
 
 bool TMessagePath::empty() const {
-    return Path_.empty();
+    return Size_ == 0;
 }
 
 TMessagePath TMessagePath::parent() const {
     if (empty()) {
         return TMessagePath{};
     }
-    TMessagePath result = *this;
-    result.PopEntry();
-    return result;
+    return parent_();
 }
 
 TMessagePath TMessagePath::parent_() const {
-    TMessagePath result = *this;
-    result.Path_.pop_back();
-    return result;
+    // Хеш префикса не выводится из хеша пути, Assign считает его заново
+    return TMessagePath(Number().first(Size_ - 1));
 }
 
 void TMessagePath::PopEntry() {
-    Path_.pop_back();
+    --Size_;
+    Hash_ = GetHash(Number());
 }
 
-std::vector<uint32_t>::iterator TMessagePath::begin() {
-    return Path_.begin();
+const uint32_t* TMessagePath::begin() const {
+    return Entries();
 }
 
-std::vector<uint32_t>::iterator TMessagePath::end() {
-    return Path_.end();
+const uint32_t* TMessagePath::end() const {
+    return Entries() + Size_;
 }
 
-std::vector<uint32_t>::const_iterator TMessagePath::begin() const {
-    return Path_.begin();
+uint32_t TMessagePath::front() const {
+    ASSERT(!empty(), "Attempt to access element of empty TMessagePath");
+    return Entries()[0];
 }
 
-std::vector<uint32_t>::const_iterator TMessagePath::end() const {
-    return Path_.end();
+uint32_t TMessagePath::back() const {
+    ASSERT(!empty(), "Attempt to access element of empty TMessagePath");
+    return Entries()[Size_ - 1];
 }
 
-const uint32_t TMessagePath::front() const {
-    ASSERT(!Path_.empty(), "Attempt to access element of empty TMessagePath");
-    return *Path_.begin();
+TMessagePath::TEntryReference TMessagePath::front() {
+    ASSERT(!empty(), "Attempt to access element of empty TMessagePath");
+    return TEntryReference(this, 0);
 }
 
-const uint32_t TMessagePath::back() const {
-    ASSERT(!Path_.empty(), "Attempt to access element of empty TMessagePath");
-    return *std::prev(Path_.end());
+TMessagePath::TEntryReference TMessagePath::back() {
+    ASSERT(!empty(), "Attempt to access element of empty TMessagePath");
+    return TEntryReference(this, Size_ - 1);
 }
 
-uint32_t& TMessagePath::front() {
-    ASSERT(!Path_.empty(), "Attempt to access element of empty TMessagePath");
-    return *Path_.begin();
+size_t TMessagePath::size() const {
+    return Size_;
 }
 
-uint32_t& TMessagePath::back() {
-    ASSERT(!Path_.empty(), "Attempt to access element of empty TMessagePath");
-    return *std::prev(Path_.end());
-}
-
-size_t TMessagePath::size() const {
-    return Path_.size();
+size_t TMessagePath::Hash() const {
+    return Hash_;
 }
 
 uint32_t TMessagePath::number() const {
@@ -194,28 +260,17 @@ uint32_t TMessagePath::number() const {
 }
 
 std::string TMessagePath::name() const {
-    const auto& manager = TRelationManager::GetInstance();
-    auto pathHash = GetHash(Path_);
-    ASSERT(manager.PathToEntryName_.contains(pathHash), "Attept to access unknown name in TMessagePath");
-    return manager.PathToEntryName_.at(pathHash);
+    auto names = TRelationManager::GetInstance().GetEntryNames(*this);
+    ASSERT(!empty() && names.size() == Size_, "Attept to access unknown name in TMessagePath");
+    return names.back();
 }
 
-const std::vector<uint32_t>& TMessagePath::data() const {
-    return Path_;
+std::span<const uint32_t> TMessagePath::data() const {
+    return Number();
 }
 
 bool TMessagePath::operator==(const TMessagePath& other) const {
-    if (Path_.size() != other.Path_.size()) {
-        return false;
-    }
-    
-    for (size_t i = 0; i < Path_.size(); ++i) {
-        if (Path_[i] != other.Path_[i]) {
-            return false;
-        }
-    }
-    
-    return true;
+    return Hash_ == other.Hash_ && std::ranges::equal(Number(), other.Number());
 }
 
 bool TMessagePath::operator!=(const TMessagePath& other) const {
@@ -223,26 +278,15 @@ bool TMessagePath::operator!=(const TMessagePath& other) const {
 }
 
 bool TMessagePath::operator<(const TMessagePath& other) const {
-    const size_t minSize = std::min(Path_.size(), other.Path_.size());
-    
-    for (size_t i = 0; i < minSize; ++i) {
-        if (Path_[i] < other.Path_[i]) {
-            return true;
-        }
-        if (Path_[i] > other.Path_[i]) {
-            return false;
-        }
-    }
-    
-    return Path_.size() < other.Path_.size();
+    return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
 }
 
 bool TMessagePath::operator<=(const TMessagePath& other) const {
-    return *this < other || *this == other;
+    return !(other < *this);
 }
 
 bool TMessagePath::operator>(const TMessagePath& other) const {
-    return !(*this <= other);
+    return other < *this;
 }
 
 bool TMessagePath::operator>=(const TMessagePath& other) const {
@@ -250,31 +294,11 @@ bool TMessagePath::operator>=(const TMessagePath& other) const {
 }
 
 bool TMessagePath::isParentOf(const TMessagePath& other) const {
-    if (Path_.size() + 1 != other.Path_.size()) {
-        return false;
-    }
-    
-    for (size_t i = 0; i < Path_.size(); ++i) {
-        if (Path_[i] != other.Path_[i]) {
-            return false;
-        }
-    }
-    
-    return true;
+    return Size_ + 1 == other.Size_ && isAncestorOf(other);
 }
 
 bool TMessagePath::isAncestorOf(const TMessagePath& other) const {
-    if (Path_.size() >= other.Path_.size()) {
-        return false;
-    }
-    
-    for (size_t i = 0; i < Path_.size(); ++i) {
-        if (Path_[i] != other.Path_[i]) {
-            return false;
-        }
-    }
-    
-    return true;
+    return Size_ < other.Size_ && std::equal(begin(), end(), other.begin());
 }
 
 bool TMessagePath::isChildOf(const TMessagePath& other) const {
@@ -285,17 +309,20 @@ bool TMessagePath::isDescendantOf(const TMessagePath& other) const {
     return other.isAncestorOf(*this);
 }
 
+size_t TMessagePath::GetTableSize() const {
+    return TRelationManager::GetInstance().GetParentTable(*this)->GetPath().size();
+}
+
 TMessagePath TMessagePath::GetTablePath() const {
-    const auto& table = TRelationManager::GetInstance().GetParentTable(Path_);
-    return table->GetPath();
+    return TMessagePath(GetTable());
 }
 
-std::vector<uint32_t> TMessagePath::GetTable() const {
-    return GetTablePath().data();
+std::span<const uint32_t> TMessagePath::GetTable() const {
+    return Number().first(GetTableSize());
 }
 
-std::vector<uint32_t> TMessagePath::GetField() const {
-    return {std::next(Path_.begin(), GetTablePath().size()), Path_.end()};
+std::span<const uint32_t> TMessagePath::GetField() const {
+    return Number().subspan(GetTableSize());
 }
 
 } // namespace NOrm::NRelation
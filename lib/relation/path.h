@@ -4,6 +4,7 @@
 
 #include <common/format.h>
 
+#include <span>
 #include <variant>
 
 namespace NOrm::NRelation {
@@ -17,24 +18,53 @@ namespace NOrm::NRelation {
  * This class provides various constructors to initialize a path, methods
  * to manipulate and retrieve entries, and operators for concatenation with
  * other paths or entries.
+ *
+ * Up to InlineCapacity entries are stored inside the object, so typical
+ * paths are copied and extended without heap allocations. The path hash is
+ * maintained incrementally on every append and is read in O(1).
  */
 class TMessagePath {
   public:
+    // Столько номеров полей хранится без выделения памяти
+    static constexpr size_t InlineCapacity = 8;
+
+    // Изменяемый номер поля; присваивание пересчитывает хеш пути
+    class TEntryReference {
+      public:
+        TEntryReference(TMessagePath* path, size_t index);
+
+        operator uint32_t() const;
+
+        TEntryReference& operator=(uint32_t entry);
+
+      private:
+        TMessagePath* Path_;
+        size_t Index_;
+    };
+
     TMessagePath() = default;
 
     TMessagePath(uint32_t entry);
 
     TMessagePath(const std::string& entry);
 
+    TMessagePath(std::span<const uint32_t> entries);
+
     TMessagePath(const std::vector<uint32_t>& entries);
 
     template <typename EntryIt>
-    TMessagePath(EntryIt entryBegin, EntryIt entryEnd) : Path_(entryBegin, entryEnd) {}
+    TMessagePath(EntryIt entryBegin, EntryIt entryEnd) {
+        for (; entryBegin != entryEnd; ++entryBegin) {
+            AppendEntry(static_cast<uint32_t>(*entryBegin));
+        }
+    }
 
     TMessagePath(const TMessagePath& other);
 
     TMessagePath(TMessagePath&& other) noexcept;
 
+    ~TMessagePath();
+
     TMessagePath& operator=(const TMessagePath& other);
 
     TMessagePath& operator=(TMessagePath&& other) noexcept;
@@ -55,7 +85,7 @@ class TMessagePath {
 
     std::vector<std::string> String() const;
 
-    const std::vector<uint32_t>& Number() const;
+    std::span<const uint32_t> Number() const;
 
     bool empty() const;
 
@@ -63,30 +93,29 @@ class TMessagePath {
 
     TMessagePath parent_() const;
 
-    std::vector<uint32_t>::iterator begin();
-
-    std::vector<uint32_t>::iterator end();
+    const uint32_t* begin() const;
 
-    std::vector<uint32_t>::const_iterator begin() const;
+    const uint32_t* end() const;
 
-    std::vector<uint32_t>::const_iterator end() const;
+    uint32_t front() const;
 
-    const uint32_t front() const;
+    uint32_t back() const;
 
-    const uint32_t back() const;
+    TEntryReference front();
 
-    uint32_t& front();
-
-    uint32_t& back();
+    TEntryReference back();
 
     std::string name() const;
 
     uint32_t number() const;
 
-    const std::vector<uint32_t>& data() const;
+    std::span<const uint32_t> data() const;
 
     size_t size() const;
 
+    // Накопленный GetNextPathEntryHash по всем номерам
+    size_t Hash() const;
+
     bool operator==(const TMessagePath& other) const;
     bool operator!=(const TMessagePath& other) const;
     bool operator<(const TMessagePath& other) const;
@@ -101,21 +130,38 @@ class TMessagePath {
 
     TMessagePath GetTablePath() const;
 
-    std::vector<uint32_t> GetTable() const;
-    std::vector<uint32_t> GetField() const;
+    // Части этого же пути, живут не дольше него
+    std::span<const uint32_t> GetTable() const;
+    std::span<const uint32_t> GetField() const;
 
   private:
     void AppendEntry(const std::string& entry);
     void AppendEntry(uint32_t entry);
     void PopEntry();
 
-    std::vector<uint32_t> Path_;
+    uint32_t* Entries();
+    const uint32_t* Entries() const;
+    void Reserve(size_t capacity);
+    void Assign(std::span<const uint32_t> entries);
+    void Reset();
+    size_t GetTableSize() const;
+
+    uint32_t Size_ = 0;
+    // Больше InlineCapacity - номера лежат в Heap_
+    uint32_t Capacity_ = InlineCapacity;
+    size_t Hash_ = 0;
+    union {
+        uint32_t Inline_[InlineCapacity];
+        uint32_t* Heap_;
+    };
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
 size_t GetNextPathEntryHash(size_t parent, size_t entry);
 
+size_t GetHash(std::span<const uint32_t> path);
+
 size_t GetHash(const std::vector<uint32_t>& path);
 
 size_t GetHash(const NOrm::NRelation::TMessagePath& path);
@@ -1,296 +1,310 @@
 #include <relation/relation_manager.h>
-#include <lib/relation/proto/orm_core.pb.h>
 
 #include <common/format.h>
 
 namespace NOrm::NRelation {
 
-namespace {
-
 ////////////////////////////////////////////////////////////////////////////////
 
-std::unordered_set<size_t> FindPrimaryFields(const google::protobuf::Descriptor* desc, const TMessagePath& basePath) {
-    std::unordered_set<size_t> result;
-    if (!desc) {
-        return result;
-    }
-
-    for (int i = 0; i < desc->field_count(); ++i) {
-        const google::protobuf::FieldDescriptor* field = desc->field(i);
-        
-        if (field->is_repeated() || field->is_map()) {
-            continue;
-        }
-        
-        TMessagePath fieldPath = basePath / field;
-        
-        const google::protobuf::FieldOptions& options = field->options();
-        if (options.HasExtension(orm::primary_key) && 
-            options.GetExtension(orm::primary_key)) {
-            result.emplace(GetHash(fieldPath));
-        }
-        
-        if (field->type() == google::protobuf::FieldDescriptor::TYPE_MESSAGE) {
-            result.merge(FindPrimaryFields(field->message_type(), fieldPath));
-        }
-    }
-    
-    return result;
+TRelationManager& TRelationManager::GetInstance() {
+    static TRelationManager instance;
+    return instance;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-
-} // namespace
-
-////////////////////////////////////////////////////////////////////////////////
-
-TTableInfo::TTableInfo(const TMessagePath& path, const google::protobuf::Descriptor* desc)
-    : Path_(path), PrimaryFields_(FindPrimaryFields(desc, Path_))
+TRelationManager::TRelationManager()
+    : Snapshot_(std::make_shared<const TSchemaSnapshot>())
 { }
 
-void TTableInfo::AddRelatedMessage(size_t hash) { RelatedMessages_.emplace(hash); }
+TSchemaSnapshotPtr TRelationManager::GetSnapshot() const {
+    return Snapshot_.load(std::memory_order_acquire);
+}
+
+uint64_t TRelationManager::GetSchemaVersion() const {
+    return Version_.load(std::memory_order_acquire);
+}
 
-const std::unordered_set<size_t>& TTableInfo::GetRelatedMessages() const { return RelatedMessages_; }
+TSchemaSnapshotPtr TRelationManager::Current() const {
+    // Общий указатель из атомика читаем только при смене версии, обычный
+    // поиск читает один атомик, который никто не пишет, и копирует указатель
+    thread_local TSchemaSnapshotPtr snapshot;
+    thread_local uint64_t version = 0;
 
-void TTableInfo::AddRelatedField(size_t hash) { RelatedFields_.emplace(hash); }
+    auto current = Version_.load(std::memory_order_acquire);
+    if (version != current) {
+        snapshot = Snapshot_.load(std::memory_order_acquire);
+        version = current;
+    }
+    return snapshot;
+}
 
-const std::unordered_set<size_t>& TTableInfo::GetRelatedFields() const { return RelatedFields_; }
+void TRelationManager::BeginUpdate() {
+    UpdateLock_.lock();
+    ++UpdateDepth_;
+}
 
-const TMessagePath& TTableInfo::GetPath() const { return Path_; }
+void TRelationManager::EndUpdate() {
+    // Снимок строит писатель: читатели не ждут ни регистрацию, ни заморозку
+    if (--UpdateDepth_ == 0) {
+        try {
+            auto snapshot = std::make_shared<TSchemaSnapshot>(Pending_);
+            snapshot->Freeze();
+            Snapshot_.store(std::move(snapshot), std::memory_order_release);
+            Version_.fetch_add(1, std::memory_order_release);
+            PendingTables_.clear();
+        } catch (...) {
+            UpdateLock_.unlock();
+            throw;
+        }
+    }
+    UpdateLock_.unlock();
+}
 
-const std::unordered_set<size_t>& TTableInfo::GetPrimaryFields() const { return PrimaryFields_; }
+void TRelationManager::RegisterRoot(TRootMessagePtr message) {
+    RegisterRoots({std::move(message)});
+}
 
-////////////////////////////////////////////////////////////////////////////////
+void TRelationManager::RegisterRoots(const std::vector<TRootMessagePtr>& roots) {
+    BeginUpdate();
+    try {
+        for (const auto& root : roots) {
+            AddRoot(root);
+        }
+    } catch (...) {
+        EndUpdate();
+        throw;
+    }
+    EndUpdate();
+}
 
-TRelationManager& TRelationManager::GetInstance() {
-    static TRelationManager instance;
-    return instance;
+void TRelationManager::RegisterField(TFieldBasePtr field) {
+    BeginUpdate();
+    try {
+        AddField(field);
+    } catch (...) {
+        EndUpdate();
+        throw;
+    }
+    EndUpdate();
 }
 
-void TRelationManager::RegisterRoot(TRootMessagePtr message) {
-    auto pathHash = GetHash(message->GetPath());
-    auto tableInfo = NCommon::New<TTableInfo>(message->GetPath(), message->GetMessageDescriptor());
-    TableByPath_[pathHash] = tableInfo;
-    
-    tableInfo->AddRelatedMessage(pathHash);
-    ParentTable_.emplace(pathHash, pathHash);
+void TRelationManager::AddRoot(const TRootMessagePtr& message) {
+    auto id = AddObject(message->GetPath());
+    auto tableInfo = NCommon::New<TTableInfo>(message->GetPath(), id);
+    Pending_.Tables_[id] = tableInfo;
+    PendingTables_.insert(id);
 
-    PathToEntryName_[pathHash] = message->GetSnakeCase();
-    EntryNameToEntry_[0][message->GetSnakeCase()] = message->Number();
+    tableInfo->AddRelatedMessage(id);
+    Pending_.ParentTables_[id] = id;
+    Pending_.EntryNames_[id] = message->GetSnakeCase();
 
-    message->Process();
-    MessagesByPath_[pathHash] = message;
-    RootMessagesByPath_[pathHash] = message;
-    ObjectType_[pathHash] = EObjectType::RootMessage;
+    // Поля из Process находят родителя по номеру, поэтому сообщение записываем заранее
+    Pending_.Messages_[id] = message;
+    Pending_.RootMessages_[id] = message;
+    Pending_.ObjectTypes_[id] = EObjectType::RootMessage;
 
-    for (const auto& field : message->Fields()) {
-        SetParentMessage(field, message);
-    }
+    message->Process();
 }
 
-void TRelationManager::RegisterField(TFieldBasePtr field) {
-    auto pathHash = GetHash(field->GetPath());
-    auto parentHash = GetHash(field->GetPath().parent_());
+void TRelationManager::AddField(const TFieldBasePtr& field) {
+    const auto& path = field->GetPath();
+    auto parentIt = PendingIds_.find(path.parent_());
+    ASSERT(parentIt != PendingIds_.end(), "Table for path not found {}", path.Number());
+    auto parentId = parentIt->second;
 
-    PathToEntryName_[pathHash] = field->GetFieldDescriptor()->name();
-    EntryNameToEntry_[parentHash][field->GetFieldDescriptor()->name()] = field->GetPath().back();
+    auto id = AddObject(path);
+    Pending_.EntryNames_[id] = field->GetFieldDescriptor()->name();
+    Pending_.ParentMessages_[id] = parentId;
+    Pending_.ParentTables_[id] = Pending_.ParentTables_[parentId];
+    Pending_.Fields_[id] = field;
 
-    ParentTable_.emplace(pathHash, ParentTable_.at(parentHash));
+    // Process ниже может перевыделить колонки, держим указатель, а не ссылку
+    TTableInfoPtr table = GetPendingTable(Pending_.ParentTables_[id]);
 
     if (field->IsMessage()) {
         auto messageField = std::static_pointer_cast<TFieldMessage>(field);
-        TRelationManager::GetInstance().GetParentTable(field->GetPath())->AddRelatedMessage(pathHash);
+        table->AddRelatedMessage(id);
 
-        MessagesByPath_[pathHash] = messageField;
-        FieldsByPath_[pathHash] = messageField;
-        ObjectType_[pathHash] = EObjectType::FieldMessage;
+        Pending_.Messages_[id] = messageField;
+        Pending_.ObjectTypes_[id] = EObjectType::FieldMessage;
 
         messageField->Process();
     } else {
         auto primitiveField = std::static_pointer_cast<TPrimitiveFieldInfo>(field);
-        TRelationManager::GetInstance().GetParentTable(field->GetPath())->AddRelatedField(pathHash);
+        table->AddRelatedField(id);
+
+        Pending_.PrimitiveFields_[id] = primitiveField;
+        Pending_.ObjectTypes_[id] = EObjectType::PrimitiveField;
 
-        FieldsByPath_[pathHash] = primitiveField;
-        PrimitiveFieldsByPath_[pathHash] = primitiveField;
-        ObjectType_[pathHash] = EObjectType::PrimitiveField;
+        // Первичный ключ не может лежать внутри повторяемого поля
+        bool singular = true;
+        for (auto current = id; current != table->GetId(); current = Pending_.ParentMessages_[current]) {
+            singular = singular && !Pending_.Fields_[current]->GetFieldDescriptor()->is_repeated();
+        }
+        if (singular && primitiveField->IsPrimaryKey()) {
+            table->AddPrimaryField(id);
+        }
     }
 }
 
-std::map<TMessagePath, TMessageInfoPtr> TRelationManager::GetMessagesFromSubtree(const TMessagePath& rootPath) {
-    auto cacheIt = MessagesFromSubtreeCache_.find(rootPath);
-    if (cacheIt != MessagesFromSubtreeCache_.end()) {
-        return cacheIt->second;
-    }
-    
-    if (rootPath.empty()) {
-        std::map<TMessagePath, TMessageInfoPtr> emptyResult;
-        MessagesFromSubtreeCache_[rootPath] = emptyResult;
-        return emptyResult;
+TTableInfoPtr TRelationManager::GetPendingTable(TObjectId id) {
+    auto& table = Pending_.Tables_[id];
+    if (PendingTables_.insert(id).second) {
+        auto copy = NCommon::New<TTableInfo>(table->Path_, table->Id_);
+        copy->RelatedMessages_ = table->RelatedMessages_;
+        copy->RelatedFields_ = table->RelatedFields_;
+        copy->PrimaryFields_ = table->PrimaryFields_;
+        table = std::move(copy);
     }
-    
-    std::map<TMessagePath, TMessageInfoPtr> result;
-    for (const auto& [_, message] : MessagesByPath_) {
-        const auto& path = message->GetPath();
-        if (rootPath.isAncestorOf(path) || rootPath == path) {
-            result[path] = message;
-        }
+    return table;
+}
+
+TObjectId TRelationManager::AddObject(const TMessagePath& path) {
+    auto [it, inserted] = PendingIds_.emplace(path, static_cast<TObjectId>(Pending_.Paths_.size()));
+    if (inserted) {
+        Pending_.Paths_.push_back(path);
+        Pending_.ObjectTypes_.push_back(EObjectType::None);
+        Pending_.EntryNames_.emplace_back();
+        Pending_.Messages_.emplace_back();
+        Pending_.Fields_.emplace_back();
+        Pending_.PrimitiveFields_.emplace_back();
+        Pending_.RootMessages_.emplace_back();
+        Pending_.ParentMessages_.push_back(InvalidObjectId);
+        Pending_.ParentTables_.push_back(InvalidObjectId);
+        Pending_.Tables_.emplace_back();
     }
-    
-    MessagesFromSubtreeCache_[rootPath] = result;
-    
-    return result;
+    return it->second;
 }
 
-TMessageInfoPtr TRelationManager::GetMessage(const TMessagePath& path) {
-    return GetMessage(GetHash(path));
+TObjectId TRelationManager::Resolve(const TMessagePath& path) const {
+    return Current()->Resolve(path);
 }
 
-TMessageInfoPtr TRelationManager::GetMessage(size_t hash) {
-    auto it = MessagesByPath_.find(hash);
-    if (it != MessagesByPath_.end()) {
-        return it->second;
-    }
-    
-    return nullptr;
+TSnapshotRange<TMessageInfoPtr> TRelationManager::GetMessagesFromSubtree(const TMessagePath& rootPath) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return {snapshot, snapshot->GetMessagesFromSubtree(snapshot->Resolve(rootPath))};
 }
 
-TRootMessagePtr TRelationManager::GetRootMessage(const TMessagePath& path) {
-    return GetRootMessage(GetHash(path));
+TMessageInfoPtr TRelationManager::GetMessage(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return snapshot->GetMessage(snapshot->Resolve(path));
 }
 
-TRootMessagePtr TRelationManager::GetRootMessage(size_t hash) {
-    auto it = RootMessagesByPath_.find(hash);
-    if (it != RootMessagesByPath_.end()) {
-        return it->second;
-    }
-    
-    return nullptr;
+TMessageInfoPtr TRelationManager::GetMessage(TObjectId id) const {
+    return Current()->GetMessage(id);
 }
 
-TPrimitiveFieldInfoPtr TRelationManager::GetPrimitiveField(const TMessagePath& path) {
-    return GetPrimitiveField(GetHash(path));
+TRootMessagePtr TRelationManager::GetRootMessage(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return snapshot->GetRootMessage(snapshot->Resolve(path));
 }
 
-TPrimitiveFieldInfoPtr TRelationManager::GetPrimitiveField(size_t hash) {
-    auto it = PrimitiveFieldsByPath_.find(hash);
-    if (it != PrimitiveFieldsByPath_.end()) {
-        return it->second;
-    }
-    
-    return nullptr;
+TRootMessagePtr TRelationManager::GetRootMessage(TObjectId id) const {
+    return Current()->GetRootMessage(id);
 }
 
-TFieldBasePtr TRelationManager::GetField(const TMessagePath& path) {
-    return GetField(GetHash(path));
+TPrimitiveFieldInfoPtr TRelationManager::GetPrimitiveField(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return snapshot->GetPrimitiveField(snapshot->Resolve(path));
 }
 
-TFieldBasePtr TRelationManager::GetField(size_t hash) {
-    auto it = FieldsByPath_.find(hash);
-    if (it != FieldsByPath_.end()) {
-        return it->second;
-    }
-    
-    return nullptr;
+TPrimitiveFieldInfoPtr TRelationManager::GetPrimitiveField(TObjectId id) const {
+    return Current()->GetPrimitiveField(id);
 }
 
-TMessageBasePtr TRelationManager::GetObject(const TMessagePath& path) {
-    return GetObject(GetHash(path));
+TFieldBasePtr TRelationManager::GetField(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return snapshot->GetField(snapshot->Resolve(path));
 }
 
-TMessageBasePtr TRelationManager::GetObject(size_t hash) {
-    if (TMessageBasePtr obj = GetMessage(hash)) {
-        return obj;
-    }
-    return GetField(hash);
+TFieldBasePtr TRelationManager::GetField(TObjectId id) const {
+    return Current()->GetField(id);
+}
+
+TMessageBasePtr TRelationManager::GetObject(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return snapshot->GetObject(snapshot->Resolve(path));
+}
+
+TMessageBasePtr TRelationManager::GetObject(TObjectId id) const {
+    return Current()->GetObject(id);
 }
 
 uint32_t TRelationManager::GetObjectType(const TMessagePath& path) const {
-    return GetObjectType(GetHash(path));
+    TSchemaSnapshotPtr snapshot = Current();
+    return snapshot->GetObjectType(snapshot->Resolve(path));
 }
 
-uint32_t TRelationManager::GetObjectType(size_t hash) const {
-    auto it = ObjectType_.find(hash);
-    if (it != ObjectType_.end()) {
-        return it->second;
-    }
-    
-    return 0;
+uint32_t TRelationManager::GetObjectType(TObjectId id) const {
+    return Current()->GetObjectType(id);
 }
 
-TTableInfoPtr TRelationManager::GetParentTable(const TMessagePath& path) {
-    auto pathHash = GetHash(path);
-    auto parentTableIt = ParentTable_.find(pathHash);
-    ASSERT(parentTableIt != ParentTable_.end(), "Table for path not found {}", path.Number());
+TTableInfoPtr TRelationManager::GetParentTable(const TMessagePath& path) const {
+    // Номер и таблица должны браться из одного снимка
+    TSchemaSnapshotPtr snapshot = Current();
+    auto table = snapshot->FindParentTable(snapshot->Resolve(path));
+    ASSERT(table, "Table for path not found {}", path.Number());
+    return table;
+}
 
-    auto tableHash = parentTableIt->second;
-    return TableByPath_.at(tableHash);
+TSnapshotRange<TMessageBasePtr> TRelationManager::GetObjectWithAncestors(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    return {snapshot, snapshot->GetObjectWithAncestors(snapshot->Resolve(path))};
 }
 
-std::map<TMessagePath, TMessageBasePtr> TRelationManager::GetObjectWithAncestors(const TMessagePath& path) {
-    auto cacheIt = ObjectWithAncestorsCache_.find(path);
-    if (cacheIt != ObjectWithAncestorsCache_.end()) {
-        return cacheIt->second;
+TMessageInfoPtr TRelationManager::GetParentMessage(const TMessageBasePtr entity) const {
+    return Current()->GetParentMessage(entity);
+}
+
+void TRelationManager::SetParentMessage(const TMessageBasePtr entity, const TMessageInfoPtr parent) {
+    if (!entity) {
+        return;
     }
-    
-    std::map<TMessagePath, TMessageBasePtr> result;
-    
-    TMessageBasePtr field = GetObject(path);
-    if (!field) {
-        ObjectWithAncestorsCache_[path] = result;
-        return result;
+
+    BeginUpdate();
+    auto it = PendingIds_.find(entity->GetPath());
+    if (it != PendingIds_.end()) {
+        auto parentIt = parent ? PendingIds_.find(parent->GetPath()) : PendingIds_.end();
+        Pending_.ParentMessages_[it->second] = parentIt != PendingIds_.end() ? parentIt->second : InvalidObjectId;
     }
-    
-    result[field->GetPath()] = field;
-    
-    TMessageInfoPtr parent = GetParentMessage(field);
-    while (parent) {
-        result[parent->GetPath()] = parent;
-        parent = GetParentMessage(parent);
+    EndUpdate();
+}
+
+std::vector<std::string> TRelationManager::GetEntryNames(const TMessagePath& path) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    std::vector<std::string> result;
+    TObjectId id = InvalidObjectId;
+    for (auto entry : path) {
+        id = snapshot->FindChild(id, entry);
+        if (id == InvalidObjectId) {
+            break;
+        }
+        result.push_back(snapshot->GetEntryName(id));
     }
-    
-    ObjectWithAncestorsCache_[path] = result;
-    
     return result;
 }
 
-TMessageInfoPtr TRelationManager::GetParentMessage(const TMessageBasePtr entity) {
-    if (!entity) {
-        return nullptr;
-    }
-    
-    auto it = ParentMap_.find(entity);
-    if (it != ParentMap_.end()) {
-        return it->second;
+std::optional<uint32_t> TRelationManager::FindEntry(const TMessagePath& parent, const std::string& name) const {
+    TSchemaSnapshotPtr snapshot = Current();
+    auto parentId = snapshot->Resolve(parent);
+    if (!parent.empty() && parentId == InvalidObjectId) {
+        return std::nullopt;
     }
-    
-    return nullptr;
-}
 
-void TRelationManager::SetParentMessage(const TMessageBasePtr entity, const TMessageInfoPtr parent) {
-    if (!entity && !parent) {
-        return;
+    auto id = snapshot->FindChild(parentId, name);
+    if (id == InvalidObjectId) {
+        return std::nullopt;
     }
-    
-    ParentMap_[entity] = parent;
-    
-    ObjectWithAncestorsCache_.clear();
+    return snapshot->GetPath(id).back();
 }
 
 void TRelationManager::Clear() {
-    MessagesByPath_.clear();
-    FieldsByPath_.clear();
-    ParentMap_.clear();
+    BeginUpdate();
+    Pending_ = TSchemaSnapshot();
+    PendingIds_.clear();
+    PendingTables_.clear();
+    EndUpdate();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 } // namespace NOrm::NRelation
-
-
-
-
-
-
-
-
-
@@ -1,77 +1,34 @@
 #pragma once
 
-#include <relation/message.h>
-#include <relation/field.h>
+#include <relation/schema_snapshot.h>
 #include <relation/config.h>
 
-#include <common/intrusive_ptr.h>
-
+#include <atomic>
 #include <memory>
-#include <unordered_map>
-#include <map>
+#include <optional>
 #include <string>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace NOrm::NRelation {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-class TRelationManager;
-
-class TTableInfo
-    : public NRefCounted::TRefCountedBase {
-public:
-    TTableInfo(const TMessagePath& path, const google::protobuf::Descriptor* desc);
-
-    void AddRelatedMessage(size_t hash);
-
-    void AddRelatedMessage(const TMessagePath& path) { AddRelatedMessage(GetHash(path)); }
-
-    const std::unordered_set<size_t>& GetRelatedMessages() const;
-
-    void AddRelatedField(size_t hash);
-
-    void AddRelatedField(const TMessagePath& path) { AddRelatedField(GetHash(path)); }
-
-    const std::unordered_set<size_t>& GetRelatedFields() const;
-
-    const TMessagePath& GetPath() const;
-
-    const std::unordered_set<size_t>& GetPrimaryFields() const;
-
-    bool IsRoot() const;
-
-private:
-    TMessagePath Path_;
-    std::unordered_set<size_t> RelatedMessages_;
-    std::unordered_set<size_t> RelatedFields_;
-
-    std::unordered_set<size_t> PrimaryFields_;
-
-    friend TRelationManager;
-
-};
-
-using TTableInfoPtr = NCommon::TIntrusivePtr<TTableInfo>;
-
-enum EObjectType {
-    None = 0,
-    Message = 1 << 0,
-    Root = 1 << 1,
-    Field = 1 << 2,
-
-    PrimitiveField = Field,
-    FieldMessage = Field | Message,
-    RootMessage = Root | Message,
-};
-
 /**
  * @class TRelationManager
  * @brief Singleton for managing access to messages and fields.
  *
  * Provides methods for searching and retrieving information about messages
  * and fields. Registration of objects is done externally.
+ *
+ * Lookups read the current TSchemaSnapshot and never lock. Registration is
+ * serialized and applied to a private copy of the schema; when the outermost
+ * Register call returns, the writer freezes that copy and publishes it as a
+ * new snapshot (RCU-style). Register a batch with RegisterRoots to pay for
+ * one freeze. Readers keep the snapshot they started with until their next
+ * lookup.
  */
 class TRelationManager {
 public:
@@ -83,61 +40,86 @@ public:
     TRelationManager& operator=(TRelationManager&&) = delete;
 
     void RegisterRoot(TRootMessagePtr root);
+    // Публикует один снимок на всю пачку
+    void RegisterRoots(const std::vector<TRootMessagePtr>& roots);
     void RegisterField(TFieldBasePtr field);
 
-    std::map<TMessagePath, TMessageInfoPtr> GetMessagesFromSubtree(const TMessagePath& rootPath);
+    // Снимок для серии поисков, которые должны видеть одну и ту же схему
+    TSchemaSnapshotPtr GetSnapshot() const;
+    // Номер опубликованного снимка, растет с каждой публикацией. По нему
+    // сбрасываются кэши, построенные по прежней схеме
+    uint64_t GetSchemaVersion() const;
+
+    // Путь разбирается один раз, дальше объект ищется по номеру
+    TObjectId Resolve(const TMessagePath& path) const;
 
-    TMessageBasePtr GetObject(size_t hash);
-    TMessageBasePtr GetObject(const TMessagePath& path);
+    // Готовый отрезок индекса снимка, без копирования
+    TSnapshotRange<TMessageInfoPtr> GetMessagesFromSubtree(const TMessagePath& rootPath) const;
 
-    TMessageInfoPtr GetMessage(size_t hash);
-    TMessageInfoPtr GetMessage(const TMessagePath& path);
+    TMessageBasePtr GetObject(TObjectId id) const;
+    TMessageBasePtr GetObject(const TMessagePath& path) const;
 
-    TRootMessagePtr GetRootMessage(size_t hash);
-    TRootMessagePtr GetRootMessage(const TMessagePath& path);
+    TMessageInfoPtr GetMessage(TObjectId id) const;
+    TMessageInfoPtr GetMessage(const TMessagePath& path) const;
 
-    TFieldBasePtr GetField(size_t hash);
-    TFieldBasePtr GetField(const TMessagePath& path);
+    TRootMessagePtr GetRootMessage(TObjectId id) const;
+    TRootMessagePtr GetRootMessage(const TMessagePath& path) const;
 
-    TPrimitiveFieldInfoPtr GetPrimitiveField(size_t hash);
-    TPrimitiveFieldInfoPtr GetPrimitiveField(const TMessagePath& path);
+    TFieldBasePtr GetField(TObjectId id) const;
+    TFieldBasePtr GetField(const TMessagePath& path) const;
 
-    uint32_t GetObjectType(size_t hash) const;
+    TPrimitiveFieldInfoPtr GetPrimitiveField(TObjectId id) const;
+    TPrimitiveFieldInfoPtr GetPrimitiveField(const TMessagePath& path) const;
+
+    uint32_t GetObjectType(TObjectId id) const;
     uint32_t GetObjectType(const TMessagePath& path) const;
 
-    std::map<TMessagePath, TMessageBasePtr> GetObjectWithAncestors(const TMessagePath& path);
+    TSnapshotRange<TMessageBasePtr> GetObjectWithAncestors(const TMessagePath& path) const;
 
-    TMessageInfoPtr GetParentMessage(const TMessageBasePtr entity);
+    TMessageInfoPtr GetParentMessage(const TMessageBasePtr entity) const;
 
     void SetParentMessage(const TMessageBasePtr entity, const TMessageInfoPtr parent);
 
+    // Имена элементов пути по порядку, до первого незарегистрированного
+    std::vector<std::string> GetEntryNames(const TMessagePath& path) const;
+    std::optional<uint32_t> FindEntry(const TMessagePath& parent, const std::string& name) const;
+
     void Clear();
 
-    TTableInfoPtr GetParentTable(const TMessagePath& path);
+    TTableInfoPtr GetParentTable(const TMessagePath& path) const;
 
 private:
-    TRelationManager() = default;
-
-    std::unordered_map<size_t, TMessageInfoPtr> MessagesByPath_;
-    std::unordered_map<size_t, TPrimitiveFieldInfoPtr> PrimitiveFieldsByPath_;
-
-    std::unordered_map<size_t, TRootMessagePtr> RootMessagesByPath_;
-    std::unordered_map<size_t, TFieldBasePtr> FieldsByPath_;
-
-    std::unordered_map<size_t, uint32_t> ObjectType_;
-
-    std::unordered_map<size_t, size_t> ParentTable_;
-    std::unordered_map<size_t, TTableInfoPtr> TableByPath_;
-
-    std::unordered_map<size_t, std::string> PathToEntryName_;
-    std::unordered_map<size_t, std::unordered_map<std::string, size_t>> EntryNameToEntry_;
-
-    std::unordered_map<TMessageBasePtr, TMessageInfoPtr> ParentMap_;
-    
-    std::unordered_map<TMessagePath, std::map<TMessagePath, TMessageInfoPtr>> MessagesFromSubtreeCache_;
-    std::unordered_map<TMessagePath, std::map<TMessagePath, TMessageBasePtr>> ObjectWithAncestorsCache_;
-
-    friend TMessagePath;
+    TRelationManager();
+
+    // Снимок, закешированный в потоке. Возвращается по значению: серию
+    // поисков, которые должны видеть одну схему, ведем по одной копии
+    TSchemaSnapshotPtr Current() const;
+
+    void BeginUpdate();
+    // Когда завершается внешний Register, замораживает Pending_ и публикует снимок
+    void EndUpdate();
+
+    void AddRoot(const TRootMessagePtr& message);
+    void AddField(const TFieldBasePtr& field);
+    // Таблица из Pending_, которую можно менять. Опубликованные снимки делят
+    // TTableInfo с Pending_, поэтому перед первой правкой после публикации
+    // таблица копируется
+    TTableInfoPtr GetPendingTable(TObjectId id);
+    // Номер пути в Pending_, новый путь получает следующий по порядку
+    TObjectId AddObject(const TMessagePath& path);
+
+    // Регистрация рекурсивна: поля регистрируются из TMessageInfo::Process
+    std::recursive_mutex UpdateLock_;
+    int UpdateDepth_ = 0;
+    // Изменяемая копия схемы, видна только писателю; trie в ней не построен
+    TSchemaSnapshot Pending_;
+    std::unordered_map<TMessagePath, TObjectId> PendingIds_;
+    // Таблицы Pending_, созданные или скопированные после последней публикации
+    std::unordered_set<TObjectId> PendingTables_;
+
+    std::atomic<TSchemaSnapshotPtr> Snapshot_;
+    // Меняется после каждой публикации, чтобы читатели обновляли свою копию указателя
+    std::atomic<uint64_t> Version_ = 1;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -167,8 +149,10 @@ inline void FormatHandler(std::ostringstream& out, const ::NOrm::NRelation::TMes
         opts.Set("suffix", "");
         detail::FormatSequenceContainer(out, container.GetTable(), opts);
         opts.Set("prefix", ".f_");
+        // У самой таблицы поля нет, ее обозначает f_1
+        static constexpr uint32_t rootField[] = {1};
         auto fieldPath = container.GetField();
-        detail::FormatSequenceContainer(out, fieldPath.empty() ? std::vector<uint32_t>({1}) : fieldPath, opts);
+        detail::FormatSequenceContainer(out, fieldPath.empty() ? std::span<const uint32_t>(rootField) : fieldPath, opts);
         return;
     }
 
@@ -177,8 +161,9 @@ inline void FormatHandler(std::ostringstream& out, const ::NOrm::NRelation::TMes
         opts.Set("delimiter", "_");
         opts.Set("prefix", "f_");
         opts.Set("suffix", "");
+        static constexpr uint32_t rootField[] = {1};
         auto fieldPath = container.GetField();
-        detail::FormatSequenceContainer(out, fieldPath.empty() ? std::vector<uint32_t>({1}) : fieldPath, opts);
+        detail::FormatSequenceContainer(out, fieldPath.empty() ? std::span<const uint32_t>(rootField) : fieldPath, opts);
         return;
     }
 
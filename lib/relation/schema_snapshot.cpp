@@ -0,0 +1,254 @@
+#include <relation/schema_snapshot.h>
+#include <relation/relation_manager.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace NOrm::NRelation {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename TValue>
+const TValue& At(const std::vector<TValue>& column, TObjectId id) {
+    static const TValue empty{};
+    return id < column.size() ? column[id] : empty;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+TTableInfo::TTableInfo(const TMessagePath& path, TObjectId id)
+    : Path_(path), Id_(id)
+{ }
+
+void TTableInfo::AddRelatedMessage(TObjectId id) { RelatedMessages_.push_back(id); }
+
+const std::vector<TObjectId>& TTableInfo::GetRelatedMessages() const { return RelatedMessages_; }
+
+void TTableInfo::AddRelatedField(TObjectId id) { RelatedFields_.push_back(id); }
+
+const std::vector<TObjectId>& TTableInfo::GetRelatedFields() const { return RelatedFields_; }
+
+void TTableInfo::AddPrimaryField(TObjectId id) { PrimaryFields_.push_back(id); }
+
+const TMessagePath& TTableInfo::GetPath() const { return Path_; }
+
+TObjectId TTableInfo::GetId() const { return Id_; }
+
+const std::vector<TObjectId>& TTableInfo::GetPrimaryFields() const { return PrimaryFields_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+TObjectId TSchemaSnapshot::Resolve(const TMessagePath& path) const {
+    if (path.empty()) {
+        return InvalidObjectId;
+    }
+
+    TObjectId id = InvalidObjectId;
+    for (auto entry : path) {
+        id = FindChild(id, entry);
+        if (id == InvalidObjectId) {
+            break;
+        }
+    }
+    return id;
+}
+
+TObjectId TSchemaSnapshot::FindChild(TObjectId parent, uint32_t entry) const {
+    size_t node = parent == InvalidObjectId ? 0 : size_t(parent) + 1;
+    if (node + 1 >= ChildOffsets_.size()) {
+        return InvalidObjectId;
+    }
+
+    auto begin = ChildEntries_.begin() + ChildOffsets_[node];
+    auto end = ChildEntries_.begin() + ChildOffsets_[node + 1];
+    auto it = std::lower_bound(begin, end, entry);
+    if (it == end || *it != entry) {
+        return InvalidObjectId;
+    }
+    return ChildIds_[it - ChildEntries_.begin()];
+}
+
+TObjectId TSchemaSnapshot::FindChild(TObjectId parent, std::string_view name) const {
+    size_t node = parent == InvalidObjectId ? 0 : size_t(parent) + 1;
+    if (node + 1 >= ChildOffsets_.size()) {
+        return InvalidObjectId;
+    }
+
+    auto begin = ChildIdsByName_.begin() + ChildOffsets_[node];
+    auto end = ChildIdsByName_.begin() + ChildOffsets_[node + 1];
+    auto it = std::lower_bound(begin, end, name, [this] (TObjectId id, std::string_view name) {
+        return EntryNames_[id] < name;
+    });
+    if (it == end || EntryNames_[*it] != name) {
+        return InvalidObjectId;
+    }
+    return *it;
+}
+
+size_t TSchemaSnapshot::GetObjectCount() const {
+    return Paths_.size();
+}
+
+bool TSchemaSnapshot::IsValid(TObjectId id) const {
+    return id < Paths_.size();
+}
+
+TMessageBasePtr TSchemaSnapshot::GetObject(TObjectId id) const {
+    if (TMessageBasePtr obj = GetMessage(id)) {
+        return obj;
+    }
+    return GetField(id);
+}
+
+TMessageInfoPtr TSchemaSnapshot::GetMessage(TObjectId id) const {
+    return At(Messages_, id);
+}
+
+TRootMessagePtr TSchemaSnapshot::GetRootMessage(TObjectId id) const {
+    return At(RootMessages_, id);
+}
+
+TFieldBasePtr TSchemaSnapshot::GetField(TObjectId id) const {
+    return At(Fields_, id);
+}
+
+TPrimitiveFieldInfoPtr TSchemaSnapshot::GetPrimitiveField(TObjectId id) const {
+    return At(PrimitiveFields_, id);
+}
+
+uint32_t TSchemaSnapshot::GetObjectType(TObjectId id) const {
+    return At(ObjectTypes_, id);
+}
+
+const TMessagePath& TSchemaSnapshot::GetPath(TObjectId id) const {
+    return At(Paths_, id);
+}
+
+const std::string& TSchemaSnapshot::GetEntryName(TObjectId id) const {
+    return At(EntryNames_, id);
+}
+
+TTableInfoPtr TSchemaSnapshot::FindParentTable(TObjectId id) const {
+    if (!IsValid(id)) {
+        return TTableInfoPtr();
+    }
+    return Tables_[ParentTables_[id]];
+}
+
+TObjectId TSchemaSnapshot::GetParentMessageId(TObjectId id) const {
+    return IsValid(id) ? ParentMessages_[id] : InvalidObjectId;
+}
+
+TMessageInfoPtr TSchemaSnapshot::GetParentMessage(const TMessageBasePtr& entity) const {
+    if (!entity) {
+        return nullptr;
+    }
+    return GetMessage(GetParentMessageId(Resolve(entity->GetPath())));
+}
+
+std::span<const std::pair<TMessagePath, TMessageInfoPtr>> TSchemaSnapshot::GetMessagesFromSubtree(TObjectId id) const {
+    if (!IsValid(id)) {
+        return {};
+    }
+    return std::span(SubtreeMessages_).subspan(SubtreeBegins_[id], SubtreeEnds_[id] - SubtreeBegins_[id]);
+}
+
+std::span<const std::pair<TMessagePath, TMessageBasePtr>> TSchemaSnapshot::GetObjectWithAncestors(TObjectId id) const {
+    if (!IsValid(id)) {
+        return {};
+    }
+    return std::span(Ancestors_).subspan(AncestorOffsets_[id], AncestorOffsets_[id + 1] - AncestorOffsets_[id]);
+}
+
+void TSchemaSnapshot::Freeze() {
+    auto count = static_cast<TObjectId>(Paths_.size());
+
+    // В лексикографическом порядке предок идет раньше потомков, а потомки
+    // одного узла - подряд по возрастанию номера поля
+    std::vector<TObjectId> sorted(count);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(), [this] (TObjectId left, TObjectId right) {
+        return Paths_[left] < Paths_[right];
+    });
+
+    // Заодно раскладываем сообщения в порядке обхода: объект закрывает свое
+    // поддерево, когда снимается со стека
+    std::vector<uint32_t> parentNodes(count);
+    SubtreeMessages_.clear();
+    SubtreeBegins_.assign(count, 0);
+    SubtreeEnds_.assign(count, 0);
+    std::vector<TObjectId> stack;
+    auto closeSubtree = [&] {
+        SubtreeEnds_[stack.back()] = SubtreeMessages_.size();
+        stack.pop_back();
+    };
+    for (auto id : sorted) {
+        const auto& path = Paths_[id];
+        while (!stack.empty() && !Paths_[stack.back()].isAncestorOf(path)) {
+            closeSubtree();
+        }
+        ASSERT(stack.empty() ? path.size() == 1 : Paths_[stack.back()].size() + 1 == path.size(),
+            "Parent of {} is not registered", path.Number());
+        parentNodes[id] = stack.empty() ? 0 : stack.back() + 1;
+        stack.push_back(id);
+
+        SubtreeBegins_[id] = SubtreeMessages_.size();
+        if (Messages_[id]) {
+            SubtreeMessages_.emplace_back(path, Messages_[id]);
+        }
+    }
+    while (!stack.empty()) {
+        closeSubtree();
+    }
+
+    ChildOffsets_.assign(size_t(count) + 2, 0);
+    for (TObjectId id = 0; id < count; ++id) {
+        ++ChildOffsets_[parentNodes[id] + 1];
+    }
+    std::partial_sum(ChildOffsets_.begin(), ChildOffsets_.end(), ChildOffsets_.begin());
+
+    ChildEntries_.resize(count);
+    ChildIds_.resize(count);
+    std::vector<uint32_t> cursors(ChildOffsets_.begin(), ChildOffsets_.end() - 1);
+    for (auto id : sorted) {
+        auto position = cursors[parentNodes[id]]++;
+        ChildEntries_[position] = Paths_[id].back();
+        ChildIds_[position] = id;
+    }
+
+    ChildIdsByName_ = ChildIds_;
+    for (size_t node = 0; node + 1 < ChildOffsets_.size(); ++node) {
+        std::sort(ChildIdsByName_.begin() + ChildOffsets_[node], ChildIdsByName_.begin() + ChildOffsets_[node + 1],
+            [this] (TObjectId left, TObjectId right) {
+                return EntryNames_[left] < EntryNames_[right];
+            });
+    }
+
+    // Родителя можно переназначить через SetParentMessage, поэтому цепочка
+    // идет по ParentMessages_, а не по префиксам пути
+    AncestorOffsets_.assign(size_t(count) + 1, 0);
+    Ancestors_.clear();
+    for (TObjectId id = 0; id < count; ++id) {
+        AncestorOffsets_[id] = Ancestors_.size();
+        if (TMessageBasePtr object = GetObject(id)) {
+            Ancestors_.emplace_back(Paths_[id], std::move(object));
+            for (auto parent = ParentMessages_[id]; parent != InvalidObjectId; parent = ParentMessages_[parent]) {
+                Ancestors_.emplace_back(Paths_[parent], Messages_[parent]);
+            }
+            std::sort(Ancestors_.begin() + AncestorOffsets_[id], Ancestors_.end(), [] (const auto& left, const auto& right) {
+                return left.first < right.first;
+            });
+        }
+    }
+    AncestorOffsets_[count] = Ancestors_.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
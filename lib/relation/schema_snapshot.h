@@ -0,0 +1,201 @@
+#pragma once
+
+#include <relation/message.h>
+#include <relation/field.h>
+
+#include <common/intrusive_ptr.h>
+
+#include <limits>
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace NOrm::NRelation {
+
+////////////////////////////////////////////////////////////////////////////////
+
+class TRelationManager;
+
+// Плотный номер сообщения или поля, назначается при регистрации
+using TObjectId = uint32_t;
+
+constexpr TObjectId InvalidObjectId = std::numeric_limits<TObjectId>::max();
+
+class TTableInfo
+    : public NRefCounted::TRefCountedBase {
+public:
+    TTableInfo(const TMessagePath& path, TObjectId id);
+
+    void AddRelatedMessage(TObjectId id);
+
+    const std::vector<TObjectId>& GetRelatedMessages() const;
+
+    void AddRelatedField(TObjectId id);
+
+    const std::vector<TObjectId>& GetRelatedFields() const;
+
+    void AddPrimaryField(TObjectId id);
+
+    const TMessagePath& GetPath() const;
+
+    TObjectId GetId() const;
+
+    const std::vector<TObjectId>& GetPrimaryFields() const;
+
+    bool IsRoot() const;
+
+private:
+    TMessagePath Path_;
+    TObjectId Id_;
+
+    // В порядке регистрации, то есть в порядке полей в описании сообщения
+    std::vector<TObjectId> RelatedMessages_;
+    std::vector<TObjectId> RelatedFields_;
+
+    std::vector<TObjectId> PrimaryFields_;
+
+    friend TRelationManager;
+
+};
+
+using TTableInfoPtr = NCommon::TIntrusivePtr<TTableInfo>;
+
+enum EObjectType {
+    None = 0,
+    Message = 1 << 0,
+    Root = 1 << 1,
+    Field = 1 << 2,
+
+    PrimitiveField = Field,
+    FieldMessage = Field | Message,
+    RootMessage = Root | Message,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @class TSchemaSnapshot
+ * @brief Frozen view of the registered schema.
+ *
+ * TRelationManager collects registrations into a private copy and publishes
+ * it as a new snapshot, so a published snapshot is never modified. Readers
+ * from any thread use it without locks; derived lookups (subtrees, ancestor
+ * chains) are computed once when the snapshot is frozen.
+ *
+ * Every registered path has a dense TObjectId, metadata is kept in arrays
+ * indexed by it. A path is resolved to its id once by walking a trie of
+ * path entries, later lookups by id are plain array accesses.
+ */
+class TSchemaSnapshot {
+public:
+    // InvalidObjectId для незарегистрированного пути
+    TObjectId Resolve(const TMessagePath& path) const;
+    TObjectId FindChild(TObjectId parent, uint32_t entry) const;
+    // parent == InvalidObjectId ищет среди таблиц
+    TObjectId FindChild(TObjectId parent, std::string_view name) const;
+
+    size_t GetObjectCount() const;
+
+    TMessageBasePtr GetObject(TObjectId id) const;
+    TMessageInfoPtr GetMessage(TObjectId id) const;
+    TRootMessagePtr GetRootMessage(TObjectId id) const;
+    TFieldBasePtr GetField(TObjectId id) const;
+    TPrimitiveFieldInfoPtr GetPrimitiveField(TObjectId id) const;
+    uint32_t GetObjectType(TObjectId id) const;
+    const TMessagePath& GetPath(TObjectId id) const;
+    const std::string& GetEntryName(TObjectId id) const;
+
+    // nullptr для незарегистрированного объекта
+    TTableInfoPtr FindParentTable(TObjectId id) const;
+    TObjectId GetParentMessageId(TObjectId id) const;
+    TMessageInfoPtr GetParentMessage(const TMessageBasePtr& entity) const;
+
+    // Сообщение и все вложенные в него сообщения, по возрастанию пути
+    std::span<const std::pair<TMessagePath, TMessageInfoPtr>> GetMessagesFromSubtree(TObjectId id) const;
+    // Объект и цепочка его родительских сообщений, по возрастанию пути
+    std::span<const std::pair<TMessagePath, TMessageBasePtr>> GetObjectWithAncestors(TObjectId id) const;
+
+private:
+    bool IsValid(TObjectId id) const;
+
+    // Строит trie путей и производные индексы; после этого снимок только читается
+    void Freeze();
+
+    // Колонки по TObjectId
+    std::vector<TMessagePath> Paths_;
+    std::vector<uint32_t> ObjectTypes_;
+    std::vector<std::string> EntryNames_;
+    std::vector<TMessageInfoPtr> Messages_;
+    std::vector<TFieldBasePtr> Fields_;
+    std::vector<TPrimitiveFieldInfoPtr> PrimitiveFields_;
+    std::vector<TRootMessagePtr> RootMessages_;
+    std::vector<TObjectId> ParentMessages_;
+    std::vector<TObjectId> ParentTables_;
+    // Заполнено только для корней таблиц
+    std::vector<TTableInfoPtr> Tables_;
+
+    // Trie в виде CSR: потомки узла node лежат в [ChildOffsets_[node], ChildOffsets_[node + 1]),
+    // узел 0 - пустой путь, узел id + 1 - объект id
+    std::vector<uint32_t> ChildOffsets_;
+    // Отсортированы по номеру поля внутри узла
+    std::vector<uint32_t> ChildEntries_;
+    std::vector<TObjectId> ChildIds_;
+    // Те же потомки, отсортированные по имени
+    std::vector<TObjectId> ChildIdsByName_;
+
+    // Сообщения в порядке обхода в глубину (он же порядок путей): поддерево
+    // любого объекта - отрезок [SubtreeBegins_[id], SubtreeEnds_[id])
+    std::vector<std::pair<TMessagePath, TMessageInfoPtr>> SubtreeMessages_;
+    std::vector<uint32_t> SubtreeBegins_;
+    std::vector<uint32_t> SubtreeEnds_;
+
+    // Цепочка объекта id лежит в [AncestorOffsets_[id], AncestorOffsets_[id + 1])
+    std::vector<uint32_t> AncestorOffsets_;
+    std::vector<std::pair<TMessagePath, TMessageBasePtr>> Ancestors_;
+
+    friend TRelationManager;
+};
+
+using TSchemaSnapshotPtr = std::shared_ptr<const TSchemaSnapshot>;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Отрезок индекса снимка, отсортированный по пути. Данные не копируются,
+// снимок держится живым, пока жив отрезок.
+template <typename TValue>
+class TSnapshotRange {
+public:
+    using TEntry = std::pair<TMessagePath, TValue>;
+
+    TSnapshotRange() = default;
+
+    TSnapshotRange(TSchemaSnapshotPtr snapshot, std::span<const TEntry> entries)
+        : Snapshot_(std::move(snapshot)), Entries_(entries)
+    { }
+
+    const TEntry* begin() const { return Entries_.data(); }
+    const TEntry* end() const { return Entries_.data() + Entries_.size(); }
+
+    size_t size() const { return Entries_.size(); }
+    bool empty() const { return Entries_.empty(); }
+
+    // end(), если пути нет
+    const TEntry* find(const TMessagePath& path) const {
+        auto it = std::lower_bound(begin(), end(), path, [] (const TEntry& entry, const TMessagePath& path) {
+            return entry.first < path;
+        });
+        return it != end() && it->first == path ? it : end();
+    }
+
+private:
+    TSchemaSnapshotPtr Snapshot_;
+    std::span<const TEntry> Entries_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
@@ -0,0 +1,62 @@
+#include <requests/clause_arena.h>
+
+namespace NOrm::NRelation {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+thread_local TClauseArena* CurrentArena = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+TClauseArena::TClauseArena(size_t initialSize)
+    : Resource_(initialSize) {}
+
+size_t TClauseArena::GetAllocatedBytes() const {
+    return AllocatedBytes_;
+}
+
+void* TClauseArena::do_allocate(size_t bytes, size_t alignment) {
+    AllocatedBytes_ += bytes;
+    return Resource_.allocate(bytes, alignment);
+}
+
+void TClauseArena::do_deallocate(void* /*ptr*/, size_t /*bytes*/, size_t /*alignment*/) {
+    // Память возвращается только вместе со всей ареной
+}
+
+bool TClauseArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TClauseArenaScope::TClauseArenaScope(TClauseArenaPtr arena)
+    : Arena_(std::move(arena))
+    , Previous_(CurrentArena) {
+    CurrentArena = Arena_ ? Arena_.operator->() : nullptr;
+}
+
+TClauseArenaScope::~TClauseArenaScope() {
+    CurrentArena = Previous_;
+}
+
+TClauseArena* GetCurrentClauseArena() {
+    return CurrentArena;
+}
+
+std::pmr::memory_resource* GetClauseMemoryResource() {
+    if (CurrentArena) {
+        return CurrentArena;
+    }
+    return std::pmr::get_default_resource();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
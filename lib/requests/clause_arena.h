@@ -0,0 +1,106 @@
+#pragma once
+
+#include <common/intrusive_ptr.h>
+
+#include <memory>
+#include <memory_resource>
+
+namespace NOrm::NRelation {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Арена для узлов дерева клауз одного запроса.
+// Узлы и их контейнеры размещаются подряд в крупных блоках, блоки
+// освобождаются разом, когда уничтожен последний узел из арены.
+// Арена однопоточная: запрос должен строиться в одном потоке.
+class TClauseArena
+    : public NRefCounted::TRefCountedBase
+    , public std::pmr::memory_resource
+{
+public:
+    explicit TClauseArena(size_t initialSize = 4096);
+
+    size_t GetAllocatedBytes() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::monotonic_buffer_resource Resource_;
+    size_t AllocatedBytes_ = 0;
+};
+
+DECLARE_REFCOUNTED(TClauseArena);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Аллокатор для std::allocate_shared. Держит ссылку на арену,
+// поэтому арена живет, пока жив хотя бы один размещенный в ней узел.
+template <typename T>
+class TClauseArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit TClauseArenaAllocator(TClauseArenaPtr arena)
+        : Arena_(std::move(arena)) {}
+
+    template <typename U>
+    TClauseArenaAllocator(const TClauseArenaAllocator<U>& other)
+        : Arena_(other.Arena_) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(Arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t count) {
+        Arena_->deallocate(ptr, count * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const TClauseArenaAllocator<U>& other) const {
+        return Arena_.operator->() == other.Arena_.operator->();
+    }
+
+private:
+    template <typename U>
+    friend class TClauseArenaAllocator;
+
+    TClauseArenaPtr Arena_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Пока объект жив, узлы клауз, создаваемые в этом потоке, размещаются в арене.
+// Области могут быть вложенными, при выходе восстанавливается предыдущая арена.
+class TClauseArenaScope {
+public:
+    explicit TClauseArenaScope(TClauseArenaPtr arena);
+    ~TClauseArenaScope();
+
+    TClauseArenaScope(const TClauseArenaScope&) = delete;
+    TClauseArenaScope& operator=(const TClauseArenaScope&) = delete;
+
+private:
+    TClauseArenaPtr Arena_;
+    TClauseArena* Previous_;
+};
+
+// Текущая арена потока, nullptr вне TClauseArenaScope
+TClauseArena* GetCurrentClauseArena();
+
+// Ресурс для контейнеров внутри узлов: текущая арена или обычная куча
+std::pmr::memory_resource* GetClauseMemoryResource();
+
+// Создает реализацию узла клаузы в текущей арене, если она есть
+template <typename T>
+std::shared_ptr<T> MakeClauseImpl() {
+    if (auto* arena = GetCurrentClauseArena()) {
+        return std::allocate_shared<T>(TClauseArenaAllocator<T>(TClauseArenaPtr(arena)));
+    }
+    return std::make_shared<T>();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
@@ -37,6 +37,10 @@ TClause CreateClauseFromProto(const NApi::TQuery& input, uint32_t startPoint) {
             return RegisterCluase<TExpression>(input, startPoint);
         case NOrm::NApi::TClause::ValueCase::kColumn:
             return RegisterCluase<TColumn>(input, startPoint);
+        case NOrm::NApi::TClause::ValueCase::kAll:
+            return RegisterCluase<TAll>(input, startPoint);
+        case NOrm::NApi::TClause::ValueCase::kDefault:
+            return RegisterCluase<TDefault>(input, startPoint);
         case NOrm::NApi::TClause::ValueCase::kSelect:
             return RegisterCluase<TSelect>(input, startPoint);
         case NOrm::NApi::TClause::ValueCase::kInsert:
@@ -198,7 +202,7 @@ NQuery::EExpressionType TExpression::GetExpressionType() const {
     return std::dynamic_pointer_cast<TExpressionImpl>(Impl_)->ExpressionType_;
 }
 
-const std::vector<TClause>& TExpression::GetOperands() const {
+const std::pmr::vector<TClause>& TExpression::GetOperands() const {
     return std::dynamic_pointer_cast<TExpressionImpl>(Impl_)->Operands_;
 }
 
@@ -288,6 +292,7 @@ void TDefault::FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint) {
 
 void TSelectImpl::ToProto(NApi::TQuery* output) const {
     auto selectVal = new NApi::TSelect();
+    selectVal->set_table_num(Table_);
     
     for (auto& selector : Selectors_) {
         selector.ToProto(output);
@@ -324,6 +329,7 @@ void TSelectImpl::ToProto(NApi::TQuery* output) const {
 
 void TSelectImpl::FromProto(const NApi::TQuery& input, uint32_t startPoint) {
     const auto& select = input.clauses().at(startPoint).select();
+    Table_ = select.table_num();
     
     Selectors_.clear();
     for (const auto& selector : select.selectors()) {
@@ -389,7 +395,7 @@ uint32_t TSelect::GetTableNum() const {
     return std::dynamic_pointer_cast<TSelectImpl>(Impl_)->Table_;
 }
 
-const std::vector<TClause>& TSelect::GetSelectors() const {
+const std::pmr::vector<TClause>& TSelect::GetSelectors() const {
     return std::dynamic_pointer_cast<TSelectImpl>(Impl_)->Selectors_;
 }
 
@@ -820,6 +826,11 @@ void TQuery::ToProto(NOrm::NApi::TQuery* output) const {
 }
 
 void TQuery::FromProto(const NOrm::NApi::TQuery& input) {
+    if (Impl_->Arena_) {
+        TClauseArenaScope scope(Impl_->Arena_);
+        Impl_->FromProto(input);
+        return;
+    }
     Impl_->FromProto(input);
 }
 
@@ -832,6 +843,10 @@ const std::vector<TClause>& TQuery::GetClauses() const {
     return Impl_->Clauses_;
 }
 
+TClauseArenaPtr TQuery::GetArena() const {
+    return Impl_->Arena_;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 TWhenCase::TWhenCase(TExpression expression)
@@ -1386,4 +1401,8 @@ TQuery CreateQuery() {
     return TQuery();
 }
 
+TQuery CreateQuery(TClauseArenaPtr arena) {
+    return TQuery(std::move(arena));
+}
+
 } // namespace NOrm::NRelation
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <lib/requests/proto/query.pb.h>
+#include <requests/clause_arena.h>
 #include <relation/base.h>
 #include <relation/path.h>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -94,7 +96,7 @@ struct TStringImpl : public TClauseImpl {
 
 class TString : public TClause {
 public:
-    TString() : TClause(std::make_shared<TStringImpl>()) {}
+    TString() : TClause(MakeClauseImpl<TStringImpl>()) {}
     
     TString& SetValue(const std::string& value);
     std::string GetValue() const;
@@ -110,7 +112,7 @@ struct TIntImpl : public TClauseImpl {
 
 class TInt : public TClause {
 public:
-    TInt() : TClause(std::make_shared<TIntImpl>()) {}
+    TInt() : TClause(MakeClauseImpl<TIntImpl>()) {}
     
     TInt& SetValue(int32_t value);
     int32_t GetValue() const;
@@ -126,7 +128,7 @@ struct TFloatImpl : public TClauseImpl {
 
 class TFloat : public TClause {
 public:
-    TFloat() : TClause(std::make_shared<TFloatImpl>()) {}
+    TFloat() : TClause(MakeClauseImpl<TFloatImpl>()) {}
     
     TFloat& SetValue(double value);
     double GetValue() const;
@@ -142,7 +144,7 @@ struct TBoolImpl : public TClauseImpl {
 
 class TBool : public TClause {
 public:
-    TBool() : TClause(std::make_shared<TBoolImpl>()) {}
+    TBool() : TClause(MakeClauseImpl<TBoolImpl>()) {}
     
     TBool& SetValue(bool value);
     bool GetValue() const;
@@ -163,19 +165,19 @@ struct TExpressionImpl : public TClauseImpl {
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint) override;
     NOrm::NApi::TClause::ValueCase Type() const override;
     
-    mutable std::vector<TClause> Operands_;
+    mutable std::pmr::vector<TClause> Operands_{GetClauseMemoryResource()};
     NOrm::NQuery::EExpressionType ExpressionType_;
 };
 
 class TExpression : public TClause {
 public:
-    TExpression() : TClause(std::make_shared<TExpressionImpl>()) {}
+    TExpression() : TClause(MakeClauseImpl<TExpressionImpl>()) {}
     
     TExpression& SetExpressionType(NOrm::NQuery::EExpressionType type);
     TExpression& AddOperand(TClause operand);
     
     NOrm::NQuery::EExpressionType GetExpressionType() const;
-    const std::vector<TClause>& GetOperands() const;
+    const std::pmr::vector<TClause>& GetOperands() const;
 };
 
 struct TAllImpl : public TClauseImpl {
@@ -186,7 +188,7 @@ struct TAllImpl : public TClauseImpl {
 
 class TAll : public TClause {
 public:
-    TAll() : TClause(std::make_shared<TAllImpl>()) {}
+    TAll() : TClause(MakeClauseImpl<TAllImpl>()) {}
     
     void ToProto(NOrm::NApi::TQuery* output) const;
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint);
@@ -203,7 +205,7 @@ struct TColumnImpl : public TClauseImpl {
 
 class TColumn : public TClause {
 public:
-    TColumn() : TClause(std::make_shared<TColumnImpl>()) {}
+    TColumn() : TClause(MakeClauseImpl<TColumnImpl>()) {}
     
     TColumn& SetPath(const TMessagePath& path);
     TColumn& SetType(NOrm::NQuery::EColumnType type);
@@ -220,7 +222,7 @@ struct TDefaultImpl : public TClauseImpl {
 
 class TDefault : public TClause {
 public:
-    TDefault() : TClause(std::make_shared<TDefaultImpl>()) {}
+    TDefault() : TClause(MakeClauseImpl<TDefaultImpl>()) {}
     
     void ToProto(NOrm::NApi::TQuery* output) const;
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint);
@@ -234,8 +236,8 @@ struct TSelectImpl : public TClauseImpl {
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint) override;
     NOrm::NApi::TClause::ValueCase Type() const override;
     
-    uint32_t Table_;
-    std::vector<TClause> Selectors_;
+    uint32_t Table_ = 0;
+    std::pmr::vector<TClause> Selectors_{GetClauseMemoryResource()};
     TClause Where_;
     TClause GroupBy_;
     TClause Having_;
@@ -245,7 +247,7 @@ struct TSelectImpl : public TClauseImpl {
 
 class TSelect : public TClause {
 public:
-    TSelect() : TClause(std::make_shared<TSelectImpl>()) {}
+    TSelect() : TClause(MakeClauseImpl<TSelectImpl>()) {}
 
 
     TSelect& SetTableNum(uint32_t table);
@@ -262,7 +264,7 @@ public:
     TSelect& Limit(T limit) { return Limit(Val(limit)); }
 
     uint32_t GetTableNum() const;
-    const std::vector<TClause>& GetSelectors() const;
+    const std::pmr::vector<TClause>& GetSelectors() const;
     TClause GetWhere() const;
     TClause GetGroupBy() const;
     TClause GetHaving() const;
@@ -342,7 +344,7 @@ struct TInsertImpl : public TClauseImpl {
 
 class TInsert : public TClause {
 public:
-    TInsert() : TClause(std::make_shared<TInsertImpl>()) {}
+    TInsert() : TClause(MakeClauseImpl<TInsertImpl>()) {}
     
     TInsert& SetTableNum(uint32_t tableNum);
     TInsert& AddSubrequest(const std::vector<TAttribute>& attributes);
@@ -364,7 +366,7 @@ struct TUpdateImpl : public TClauseImpl {
 
 class TUpdate : public TClause {
 public:
-    TUpdate() : TClause(std::make_shared<TUpdateImpl>()) {}
+    TUpdate() : TClause(MakeClauseImpl<TUpdateImpl>()) {}
     
     TUpdate& SetTableNum(uint32_t tableNum);
     TUpdate& AddUpdate(const std::vector<TAttribute>& attributes);
@@ -384,7 +386,7 @@ struct TDeleteImpl : public TClauseImpl {
 
 class TDelete : public TClause {
 public:
-    TDelete() : TClause(std::make_shared<TDeleteImpl>()) {}
+    TDelete() : TClause(MakeClauseImpl<TDeleteImpl>()) {}
     
     TDelete& SetTableNum(uint32_t tableNum);
     TDelete& Where(TClause conditions);
@@ -403,7 +405,7 @@ struct TTruncateImpl : public TClauseImpl {
 
 class TTruncate : public TClause {
 public:
-    TTruncate() : TClause(std::make_shared<TTruncateImpl>()) {}
+    TTruncate() : TClause(MakeClauseImpl<TTruncateImpl>()) {}
     
     TTruncate& SetTableNum(uint32_t tableNum);
     uint32_t GetTableNum() const;
@@ -419,7 +421,7 @@ struct TStartTransactionImpl : public TClauseImpl {
 
 class TStartTransaction : public TClause {
 public:
-    TStartTransaction() : TClause(std::make_shared<TStartTransactionImpl>()) {}
+    TStartTransaction() : TClause(MakeClauseImpl<TStartTransactionImpl>()) {}
     
     void ToProto(NOrm::NApi::TQuery* output) const;
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint);
@@ -434,7 +436,7 @@ struct TCommitTransactionImpl : public TClauseImpl {
 
 class TCommitTransaction : public TClause {
 public:
-    TCommitTransaction() : TClause(std::make_shared<TCommitTransactionImpl>()) {}
+    TCommitTransaction() : TClause(MakeClauseImpl<TCommitTransactionImpl>()) {}
     
     void ToProto(NOrm::NApi::TQuery* output) const;
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint);
@@ -448,7 +450,7 @@ struct TRollbackTransactionImpl : public TClauseImpl {
 
 class TRollbackTransaction : public TClause {
 public:
-    TRollbackTransaction() : TClause(std::make_shared<TRollbackTransactionImpl>()) {}
+    TRollbackTransaction() : TClause(MakeClauseImpl<TRollbackTransactionImpl>()) {}
     
     void ToProto(NOrm::NApi::TQuery* output) const;
     void FromProto(const NOrm::NApi::TQuery& input, uint32_t startPoint);
@@ -462,6 +464,7 @@ struct TQueryImpl {
     void FromProto(const NOrm::NApi::TQuery& input);
     
     std::vector<TClause> Clauses_;
+    TClauseArenaPtr Arena_;
 };
 
 class TQuery {
@@ -469,6 +472,13 @@ public:
     TQuery() {
         Impl_ = std::make_shared<TQueryImpl>();
     }
+
+    // Клаузы, разобранные FromProto, размещаются в арене. Клаузы, собираемые
+    // через DSL, попадают в арену внутри TClauseArenaScope(query.GetArena()).
+    explicit TQuery(TClauseArenaPtr arena) {
+        Impl_ = std::make_shared<TQueryImpl>();
+        Impl_->Arena_ = std::move(arena);
+    }
     
     void ToProto(NOrm::NApi::TQuery* output) const;
     void FromProto(const NOrm::NApi::TQuery& input);
@@ -476,6 +486,8 @@ public:
     TQuery& AddClause(TClause clause);
     const std::vector<TClause>& GetClauses() const;
 
+    TClauseArenaPtr GetArena() const;
+
 private:
     std::shared_ptr<TQueryImpl> Impl_;
 };
@@ -514,6 +526,7 @@ TDelete Delete(const TMessagePath& path);
 TTruncate Truncate(const std::string& path);
 TTruncate Truncate(const TMessagePath& path);
 TQuery CreateQuery();
+TQuery CreateQuery(TClauseArenaPtr arena);
 
 ////////////////////////////////////////////////////////////////////////////////
 
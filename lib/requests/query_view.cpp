@@ -0,0 +1,59 @@
+#include <requests/query_view.h>
+
+#include <common/exception.h>
+
+namespace NOrm::NRelation {
+
+////////////////////////////////////////////////////////////////////////////////
+
+TClauseView::TClauseView(const NOrm::NApi::TQuery* query, int32_t index)
+    : Query_(query)
+    , Index_(index) {
+    ASSERT(Index_ >= 0 && Index_ < Query_->clauses_size(), "Clause index {} is out of range, clauses: {}", Index_, Query_->clauses_size());
+}
+
+TClauseView::operator bool() const {
+    return Query_ != nullptr;
+}
+
+NOrm::NApi::TClause::ValueCase TClauseView::Type() const {
+    return Get().value_case();
+}
+
+const NOrm::NApi::TClause& TClauseView::Get() const {
+    return Query_->clauses(Index_);
+}
+
+int32_t TClauseView::GetIndex() const {
+    return Index_;
+}
+
+TClauseView TClauseView::Child(int32_t index) const {
+    ASSERT(index >= 0 && index < Index_, "Invalid reference from clause {} to clause {}", Index_, index);
+    return TClauseView(Query_, index);
+}
+
+TClauseView TClauseView::OptionalChild(bool has, int32_t index) const {
+    if (!has) {
+        return TClauseView();
+    }
+    return Child(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TQueryView::TQueryView(const NOrm::NApi::TQuery& query)
+    : Query_(query) {}
+
+size_t TQueryView::GetClauseCount() const {
+    return Query_.start_points_size();
+}
+
+TClauseView TQueryView::GetClause(size_t idx) const {
+    ASSERT(idx < GetClauseCount(), "Start point {} is out of range", idx);
+    return TClauseView(&Query_, Query_.start_points(idx));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <lib/requests/proto/query.pb.h>
+
+#include <cstdint>
+
+namespace NOrm::NRelation {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Клауза внутри разобранного NApi::TQuery: указатель на сообщение и индекс.
+// Дает доступ к данным клаузы без построения графа TClauseImpl, строки
+// и пути читаются прямо из сообщения (в том числе размещенного в арене protobuf).
+// Сообщение должно жить дольше представления.
+class TClauseView {
+public:
+    TClauseView() = default;
+    TClauseView(const NOrm::NApi::TQuery* query, int32_t index);
+
+    explicit operator bool() const;
+
+    NOrm::NApi::TClause::ValueCase Type() const;
+    const NOrm::NApi::TClause& Get() const;
+    int32_t GetIndex() const;
+
+    // Дочерняя клауза по индексу из полей текущей. ToProto всегда записывает
+    // дочерние клаузы раньше родительской, поэтому индекс обязан быть меньше
+    // текущего: это защищает от циклов и выхода за границы в чужих сообщениях.
+    TClauseView Child(int32_t index) const;
+    TClauseView OptionalChild(bool has, int32_t index) const;
+
+private:
+    const NOrm::NApi::TQuery* Query_ = nullptr;
+    int32_t Index_ = -1;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Корневые клаузы запроса в порядке start_points
+class TQueryView {
+public:
+    explicit TQueryView(const NOrm::NApi::TQuery& query);
+
+    size_t GetClauseCount() const;
+    TClauseView GetClause(size_t idx) const;
+
+private:
+    const NOrm::NApi::TQuery& Query_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NOrm::NRelation
@@ -0,0 +1,146 @@
+#include <rpc/admission.h>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+TAdmissionController::TAdmissionController(size_t maxInFlight, size_t maxQueued, std::chrono::milliseconds maxQueueTime)
+    : MaxInFlight_(maxInFlight)
+    , MaxQueued_(maxQueued)
+    , MaxQueueTime_(maxQueueTime)
+{}
+
+void TAdmissionController::SetPolicy(size_t route, TAdmissionPolicy policy) {
+    auto guard = std::lock_guard(Mutex_);
+    if (Routes_.size() <= route) {
+        Routes_.resize(route + 1);
+    }
+    Routes_[route].Policy = policy;
+}
+
+void TAdmissionController::Submit(size_t route, TAction run, TAction reject) {
+    {
+        auto guard = std::lock_guard(Mutex_);
+        // Пока ожидающие есть, каждый из них упирается в занятый слот, поэтому
+        // запрос, которому слота хватает, никого не обгоняет
+        if (CanRun(route)) {
+            Acquire(route);
+        } else if (MaxQueued_ != 0 && Queued_ >= MaxQueued_) {
+            ++Rejected_;
+            run = nullptr;
+        } else {
+            auto* state = FindRoute(route);
+            auto policy = state ? state->Policy : TAdmissionPolicy();
+            auto queueTime = policy.MaxQueueTime.count() != 0 ? policy.MaxQueueTime : MaxQueueTime_;
+            auto deadline = queueTime.count() != 0 ? TClock::now() + queueTime : TClock::time_point::max();
+
+            Queues_[static_cast<size_t>(policy.Priority)].push_back({route, deadline, std::move(run), std::move(reject)});
+            ++Queued_;
+            return;
+        }
+    }
+
+    if (run) {
+        run();
+    } else {
+        reject();
+    }
+}
+
+void TAdmissionController::Release(size_t route) {
+    std::vector<TAction> actions;
+    {
+        auto guard = std::lock_guard(Mutex_);
+        --InFlight_;
+        if (auto* state = FindRoute(route)) {
+            --state->InFlight;
+        }
+        Drain(TClock::now(), &actions);
+    }
+
+    for (auto& action : actions) {
+        action();
+    }
+}
+
+void TAdmissionController::ExpireQueued(TClock::time_point now) {
+    std::vector<TAction> actions;
+    {
+        auto guard = std::lock_guard(Mutex_);
+        if (Queued_ == 0) {
+            return;
+        }
+        Drain(now, &actions);
+    }
+
+    for (auto& action : actions) {
+        action();
+    }
+}
+
+std::optional<TAdmissionController::TClock::time_point> TAdmissionController::GetNextDeadline() const {
+    auto guard = std::lock_guard(Mutex_);
+    std::optional<TClock::time_point> result;
+    for (const auto& queue : Queues_) {
+        for (const auto& pending : queue) {
+            if (pending.Deadline != TClock::time_point::max() && (!result || pending.Deadline < *result)) {
+                result = pending.Deadline;
+            }
+        }
+    }
+    return result;
+}
+
+TAdmissionStats TAdmissionController::GetStats() const {
+    auto guard = std::lock_guard(Mutex_);
+    return {
+        .InFlight = InFlight_,
+        .Queued = Queued_,
+        .Admitted = Admitted_,
+        .Rejected = Rejected_,
+    };
+}
+
+TAdmissionController::TRouteState* TAdmissionController::FindRoute(size_t route) {
+    return route < Routes_.size() ? &Routes_[route] : nullptr;
+}
+
+bool TAdmissionController::CanRun(size_t route) {
+    if (MaxInFlight_ != 0 && InFlight_ >= MaxInFlight_) {
+        return false;
+    }
+    auto* state = FindRoute(route);
+    return !state || state->Policy.MaxConcurrency == 0 || state->InFlight < state->Policy.MaxConcurrency;
+}
+
+void TAdmissionController::Acquire(size_t route) {
+    ++InFlight_;
+    ++Admitted_;
+    if (auto* state = FindRoute(route)) {
+        ++state->InFlight;
+    }
+}
+
+void TAdmissionController::Drain(TClock::time_point now, std::vector<TAction>* actions) {
+    // Сначала высокий приоритет, внутри приоритета — в порядке поступления
+    for (auto queue = Queues_.rbegin(); queue != Queues_.rend(); ++queue) {
+        for (auto it = queue->begin(); it != queue->end();) {
+            if (it->Deadline <= now) {
+                ++Rejected_;
+                actions->push_back(std::move(it->Reject));
+            } else if (CanRun(it->Route)) {
+                Acquire(it->Route);
+                actions->push_back(std::move(it->Run));
+            } else {
+                ++it;
+                continue;
+            }
+            it = queue->erase(it);
+            --Queued_;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Порядок, в котором ожидающие запросы получают освободившиеся слоты
+enum class EPriority {
+    Low,
+    Normal,
+    High,
+};
+
+struct TAdmissionPolicy {
+    // Одновременно выполняемых запросов маршрута, 0 — без ограничения
+    size_t MaxConcurrency = 0;
+    EPriority Priority = EPriority::Normal;
+    // Сколько запрос маршрута может ждать слота, 0 — значение из конфигурации сервера
+    std::chrono::milliseconds MaxQueueTime{0};
+};
+
+struct TAdmissionStats {
+    size_t InFlight = 0;
+    size_t Queued = 0;
+    uint64_t Admitted = 0;
+    uint64_t Rejected = 0;
+};
+
+// Ограничивает число одновременно обрабатываемых запросов: общее и по
+// маршрутам. Запрос, которому не хватило слота, ждет в очереди своего
+// приоритета и отклоняется, если очередь полна или срок ожидания истек.
+// Колбэки вызываются вне блокировки, в потоке, освободившем слот или
+// подавшем запрос.
+class TAdmissionController {
+public:
+    using TClock = std::chrono::steady_clock;
+    using TAction = std::function<void()>;
+
+    // Маршрут без политики, например обработчик ненайденных путей
+    static constexpr size_t NoRoute = std::numeric_limits<size_t>::max();
+
+    // Нули отключают соответствующее ограничение
+    TAdmissionController(size_t maxInFlight, size_t maxQueued, std::chrono::milliseconds maxQueueTime);
+
+    // Задается до начала обработки запросов
+    void SetPolicy(size_t route, TAdmissionPolicy policy);
+
+    void Submit(size_t route, TAction run, TAction reject);
+    // Вызывается по завершении запроса, запущенного через Submit
+    void Release(size_t route);
+    // Отклоняет запросы, срок ожидания которых истек
+    void ExpireQueued(TClock::time_point now = TClock::now());
+    // Ближайший срок ожидания среди запросов в очереди
+    std::optional<TClock::time_point> GetNextDeadline() const;
+
+    TAdmissionStats GetStats() const;
+
+private:
+    struct TRouteState {
+        TAdmissionPolicy Policy;
+        size_t InFlight = 0;
+    };
+
+    struct TPending {
+        size_t Route;
+        TClock::time_point Deadline;
+        TAction Run;
+        TAction Reject;
+    };
+
+    TRouteState* FindRoute(size_t route);
+    bool CanRun(size_t route);
+    void Acquire(size_t route);
+    // Переносит в actions запуск ожидающих, которым хватает слотов, и отказы просроченным
+    void Drain(TClock::time_point now, std::vector<TAction>* actions);
+
+    const size_t MaxInFlight_;
+    const size_t MaxQueued_;
+    const std::chrono::milliseconds MaxQueueTime_;
+
+    mutable std::mutex Mutex_;
+    std::vector<TRouteState> Routes_;
+    // По одной очереди на EPriority
+    std::array<std::deque<TPending>, 3> Queues_;
+    size_t InFlight_ = 0;
+    size_t Queued_ = 0;
+    uint64_t Admitted_ = 0;
+    uint64_t Rejected_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
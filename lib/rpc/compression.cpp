@@ -0,0 +1,358 @@
+#include <rpc/compression.h>
+#include <rpc/http_server.h>
+
+#include <common/exception.h>
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include <zlib.h>
+#ifdef RPC_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace NRpc {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// На столько растет выходной буфер за один шаг кодека
+constexpr size_t OutputStep = 64 * 1024;
+// Сколько отдавать zlib за раз, avail_in 32-битный
+constexpr size_t MaxZlibInput = 1u << 30;
+// gzip-обертка вокруг deflate
+constexpr int GzipWindowBits = 15 + 16;
+
+std::string_view Trim(std::string_view value) {
+    auto start = value.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+}
+
+bool EqualsIgnoreCase(std::string_view left, std::string_view right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end(), [] (char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+}
+
+// Дает место под очередной шаг кодека в конце output
+char* Grow(std::string* output, size_t* used) {
+    *used = output->size();
+    output->resize(*used + OutputStep);
+    return output->data() + *used;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class TGzipCompressor
+    : public TStreamCompressor
+{
+public:
+    explicit TGzipCompressor(int level) {
+        ASSERT(deflateInit2(&Stream_, level, Z_DEFLATED, GzipWindowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK,
+            "Failed to initialize gzip compressor: {}", Stream_.msg ? Stream_.msg : "");
+    }
+
+    ~TGzipCompressor() override {
+        deflateEnd(&Stream_);
+    }
+
+    void Write(std::string_view data, std::string* output) override {
+        while (!data.empty()) {
+            auto part = data.substr(0, MaxZlibInput);
+            Run(part, Z_NO_FLUSH, output);
+            data.remove_prefix(part.size());
+        }
+    }
+
+    void Finish(std::string* output) override {
+        Run({}, Z_FINISH, output);
+    }
+
+private:
+    void Run(std::string_view data, int flush, std::string* output) {
+        Stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        Stream_.avail_in = data.size();
+
+        while (true) {
+            size_t used;
+            Stream_.next_out = reinterpret_cast<Bytef*>(Grow(output, &used));
+            Stream_.avail_out = OutputStep;
+
+            int result = deflate(&Stream_, flush);
+            ASSERT(result != Z_STREAM_ERROR, "gzip compression failed");
+            output->resize(used + OutputStep - Stream_.avail_out);
+
+            bool done = flush == Z_FINISH
+                ? result == Z_STREAM_END
+                : Stream_.avail_in == 0 && Stream_.avail_out != 0;
+            if (done) {
+                return;
+            }
+        }
+    }
+
+    z_stream Stream_{};
+};
+
+std::string GzipDecompress(std::string_view data, size_t maxSize) {
+    z_stream stream{};
+    ASSERT(inflateInit2(&stream, GzipWindowBits) == Z_OK, "Failed to initialize gzip decompressor");
+
+    std::string output;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = std::min(data.size(), MaxZlibInput);
+    data.remove_prefix(stream.avail_in);
+
+    int result = Z_OK;
+    while (result != Z_STREAM_END) {
+        if (stream.avail_in == 0 && !data.empty()) {
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            stream.avail_in = std::min(data.size(), MaxZlibInput);
+            data.remove_prefix(stream.avail_in);
+        }
+
+        size_t used;
+        stream.next_out = reinterpret_cast<Bytef*>(Grow(&output, &used));
+        stream.avail_out = OutputStep;
+        result = inflate(&stream, Z_NO_FLUSH);
+        output.resize(used + OutputStep - stream.avail_out);
+
+        bool truncated = result == Z_BUF_ERROR && stream.avail_in == 0 && data.empty();
+        if ((result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) || truncated) {
+            inflateEnd(&stream);
+            throw THttpException(EHttpCode::BadRequest, "Malformed gzip body");
+        }
+        if (output.size() > maxSize) {
+            inflateEnd(&stream);
+            throw THttpException(EHttpCode::BadRequest, "Decompressed body is larger than {} bytes", maxSize);
+        }
+    }
+
+    inflateEnd(&stream);
+    return output;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef RPC_HAS_ZSTD
+
+class TZstdCompressor
+    : public TStreamCompressor
+{
+public:
+    explicit TZstdCompressor(int level)
+        : Context_(ZSTD_createCCtx())
+    {
+        ASSERT(Context_, "Failed to create zstd context");
+        ZSTD_CCtx_setParameter(Context_, ZSTD_c_compressionLevel, level);
+    }
+
+    ~TZstdCompressor() override {
+        ZSTD_freeCCtx(Context_);
+    }
+
+    void Write(std::string_view data, std::string* output) override {
+        Run(data, ZSTD_e_continue, output);
+    }
+
+    void Finish(std::string* output) override {
+        Run({}, ZSTD_e_end, output);
+    }
+
+private:
+    void Run(std::string_view data, ZSTD_EndDirective mode, std::string* output) {
+        ZSTD_inBuffer input{data.data(), data.size(), 0};
+
+        while (true) {
+            size_t used;
+            ZSTD_outBuffer buffer{Grow(output, &used), OutputStep, 0};
+            size_t remaining = ZSTD_compressStream2(Context_, &buffer, &input, mode);
+            output->resize(used + buffer.pos);
+            ASSERT(!ZSTD_isError(remaining), "zstd compression failed: {}", ZSTD_getErrorName(remaining));
+
+            bool done = mode == ZSTD_e_end
+                ? remaining == 0
+                : input.pos == input.size && buffer.pos < buffer.size;
+            if (done) {
+                return;
+            }
+        }
+    }
+
+    ZSTD_CCtx* Context_;
+};
+
+std::string ZstdDecompress(std::string_view data, size_t maxSize) {
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    ASSERT(context, "Failed to create zstd context");
+
+    std::string output;
+    ZSTD_inBuffer input{data.data(), data.size(), 0};
+    size_t remaining = 0;
+    do {
+        size_t used;
+        ZSTD_outBuffer buffer{Grow(&output, &used), OutputStep, 0};
+        remaining = ZSTD_decompressStream(context.get(), &buffer, &input);
+        output.resize(used + buffer.pos);
+
+        if (ZSTD_isError(remaining)) {
+            throw THttpException(EHttpCode::BadRequest, "Malformed zstd body: {}", ZSTD_getErrorName(remaining));
+        }
+        if (output.size() > maxSize) {
+            throw THttpException(EHttpCode::BadRequest, "Decompressed body is larger than {} bytes", maxSize);
+        }
+        // Весь вход прочитан, но кадр не закончен и кодеку нечего выдать
+        if (input.pos == input.size && remaining != 0 && buffer.pos < buffer.size) {
+            throw THttpException(EHttpCode::BadRequest, "Truncated zstd body");
+        }
+    } while (input.pos < input.size || remaining != 0);
+
+    return output;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool IsCompressionSupported(ECompression compression) {
+    switch (compression) {
+        case ECompression::None:
+        case ECompression::Gzip:
+            return true;
+        case ECompression::Zstd:
+#ifdef RPC_HAS_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+std::string_view GetContentEncoding(ECompression compression) {
+    switch (compression) {
+        case ECompression::None: return "identity";
+        case ECompression::Gzip: return "gzip";
+        case ECompression::Zstd: return "zstd";
+    }
+    return "identity";
+}
+
+std::optional<ECompression> ParseContentEncoding(std::string_view encoding) {
+    encoding = Trim(encoding);
+    if (encoding.empty() || EqualsIgnoreCase(encoding, "identity")) {
+        return ECompression::None;
+    }
+    if (EqualsIgnoreCase(encoding, "gzip") || EqualsIgnoreCase(encoding, "x-gzip")) {
+        return ECompression::Gzip;
+    }
+    if (EqualsIgnoreCase(encoding, "zstd") && IsCompressionSupported(ECompression::Zstd)) {
+        return ECompression::Zstd;
+    }
+    return std::nullopt;
+}
+
+ECompression NegotiateCompression(std::string_view acceptEncoding) {
+    std::optional<double> gzip;
+    std::optional<double> zstd;
+    std::optional<double> any;
+
+    while (!acceptEncoding.empty()) {
+        auto comma = acceptEncoding.find(',');
+        auto item = Trim(acceptEncoding.substr(0, comma));
+        acceptEncoding.remove_prefix(comma == std::string_view::npos ? acceptEncoding.size() : comma + 1);
+
+        auto semicolon = item.find(';');
+        auto name = Trim(item.substr(0, semicolon));
+        double quality = 1;
+        if (semicolon != std::string_view::npos) {
+            auto parameter = Trim(item.substr(semicolon + 1));
+            if (parameter.starts_with("q=") || parameter.starts_with("Q=")) {
+                parameter.remove_prefix(2);
+                if (std::from_chars(parameter.data(), parameter.data() + parameter.size(), quality).ec != std::errc()) {
+                    quality = 0;
+                }
+            }
+        }
+
+        if (EqualsIgnoreCase(name, "gzip") || EqualsIgnoreCase(name, "x-gzip")) {
+            gzip = quality;
+        } else if (EqualsIgnoreCase(name, "zstd")) {
+            zstd = quality;
+        } else if (name == "*") {
+            any = quality;
+        }
+    }
+
+    double gzipQuality = gzip.value_or(any.value_or(0));
+    double zstdQuality = IsCompressionSupported(ECompression::Zstd) ? zstd.value_or(any.value_or(0)) : 0;
+
+    if (zstdQuality > 0 && zstdQuality >= gzipQuality) {
+        return ECompression::Zstd;
+    }
+    if (gzipQuality > 0) {
+        return ECompression::Gzip;
+    }
+    return ECompression::None;
+}
+
+std::string Compress(ECompression compression, std::string_view data, int level) {
+    if (compression == ECompression::None) {
+        return std::string(data);
+    }
+
+    auto compressor = CreateStreamCompressor(compression, level);
+    std::string output;
+    output.reserve(data.size() / 4 + OutputStep);
+    compressor->Write(data, &output);
+    compressor->Finish(&output);
+    return output;
+}
+
+std::string Decompress(ECompression compression, std::string_view data, size_t maxSize) {
+    switch (compression) {
+        case ECompression::None:
+            if (data.size() > maxSize) {
+                throw THttpException(EHttpCode::BadRequest, "Body is larger than {} bytes", maxSize);
+            }
+            return std::string(data);
+        case ECompression::Gzip:
+            return GzipDecompress(data, maxSize);
+        case ECompression::Zstd:
+#ifdef RPC_HAS_ZSTD
+            return ZstdDecompress(data, maxSize);
+#else
+            break;
+#endif
+    }
+    throw THttpException(EHttpCode::UnsupportedMediaType, "Unsupported content encoding: {}", GetContentEncoding(compression));
+}
+
+std::unique_ptr<TStreamCompressor> CreateStreamCompressor(ECompression compression, int level) {
+    switch (compression) {
+        case ECompression::Gzip:
+            return std::make_unique<TGzipCompressor>(level);
+        case ECompression::Zstd:
+#ifdef RPC_HAS_ZSTD
+            return std::make_unique<TZstdCompressor>(level);
+#else
+            break;
+#endif
+        case ECompression::None:
+            break;
+    }
+    THROW("No stream compressor for {}", GetContentEncoding(compression));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+enum class ECompression {
+    None,
+    Gzip,
+    Zstd,
+};
+
+// Предел размера распакованного тела запроса
+constexpr size_t MaxDecompressedSize = 64 * 1024 * 1024;
+
+// zstd доступен, только если библиотека нашлась при сборке
+bool IsCompressionSupported(ECompression compression);
+
+// Значение для заголовка Content-Encoding
+std::string_view GetContentEncoding(ECompression compression);
+
+// Кодек из Content-Encoding, nullopt для неподдерживаемого
+std::optional<ECompression> ParseContentEncoding(std::string_view encoding);
+
+// Лучший поддерживаемый кодек по Accept-Encoding с учетом q-значений.
+// При равных весах zstd предпочтительнее gzip.
+ECompression NegotiateCompression(std::string_view acceptEncoding);
+
+std::string Compress(ECompression compression, std::string_view data, int level);
+
+// THttpException с BadRequest, если данные повреждены или распакованное больше maxSize
+std::string Decompress(ECompression compression, std::string_view data, size_t maxSize = MaxDecompressedSize);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Потоковое сжатие для chunked ответов: сжатые данные выдаются по мере
+// накопления в кодеке, Finish дописывает остаток и концовку формата
+class TStreamCompressor {
+public:
+    virtual ~TStreamCompressor() = default;
+
+    virtual void Write(std::string_view data, std::string* output) = 0;
+    virtual void Finish(std::string* output) = 0;
+};
+
+std::unique_ptr<TStreamCompressor> CreateStreamCompressor(ECompression compression, int level);
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
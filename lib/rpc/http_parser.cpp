@@ -0,0 +1,278 @@
+#include <rpc/http_parser.h>
+#include <rpc/http_server.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace NRpc {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr std::string_view CrLf = "\r\n";
+constexpr std::string_view Whitespace = " \t";
+
+bool EqualsIgnoreCase(std::string_view left, std::string_view right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end(), [] (char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+}
+
+bool ContainsIgnoreCase(std::string_view value, std::string_view token) {
+    return std::search(value.begin(), value.end(), token.begin(), token.end(), [] (char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    }) != value.end();
+}
+
+// Границы значения без окружающих пробелов, относительно начала line
+std::pair<size_t, size_t> TrimBounds(std::string_view line, size_t begin) {
+    auto start = line.find_first_not_of(Whitespace, begin);
+    if (start == std::string_view::npos) {
+        return {line.size(), line.size()};
+    }
+    auto end = line.find_last_not_of(Whitespace);
+    return {start, end + 1};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string_view THttpRequestLayout::FindHeader(std::string_view buffer, std::string_view name) const {
+    for (const auto& header : Headers) {
+        if (EqualsIgnoreCase(header.Name.In(buffer), name)) {
+            return header.Value.In(buffer);
+        }
+    }
+    return {};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+THttpRequestParser::THttpRequestParser(size_t maxRequestSize, size_t maxHeaderSize, size_t maxHeaderCount)
+    : MaxRequestSize_(maxRequestSize)
+    , MaxHeaderSize_(std::min(maxHeaderSize, maxRequestSize))
+    , MaxHeaderCount_(maxHeaderCount)
+{}
+
+bool THttpRequestParser::Parse(std::string& buffer) {
+    while (State_ != EState::Done) {
+        switch (State_) {
+            case EState::RequestLine:
+            case EState::Headers:
+            case EState::ChunkSize:
+            case EState::Trailers: {
+                auto lineEnd = FindLineEnd(buffer);
+                // Размер считаем и по дочитанным строкам: иначе множество коротких
+                // заголовков разбиралось бы целиком, сколько бы их ни было
+                size_t blockBegin = State_ == EState::ChunkSize ? Offset_ : HeaderBegin_;
+                size_t blockEnd = lineEnd == std::string_view::npos ? buffer.size() : lineEnd;
+                if (blockEnd - blockBegin > MaxHeaderSize_) {
+                    throw THttpException(EHttpCode::BadRequest, "Request headers are too large");
+                }
+                if (lineEnd == std::string_view::npos) {
+                    return false;
+                }
+
+                if (State_ == EState::RequestLine) {
+                    ParseRequestLine(buffer, lineEnd);
+                    State_ = EState::Headers;
+                } else if (State_ == EState::Headers) {
+                    if (lineEnd == Offset_) {
+                        Offset_ = lineEnd + CrLf.size();
+                        StartBody();
+                        continue;
+                    }
+                    ParseHeader(buffer, lineEnd);
+                } else if (State_ == EState::ChunkSize) {
+                    ParseChunkSize(buffer, lineEnd);
+                } else if (lineEnd == Offset_) {
+                    // Пустая строка завершает трейлеры, сами трейлеры не нужны
+                    State_ = EState::Done;
+                }
+                Offset_ = lineEnd + CrLf.size();
+                break;
+            }
+            case EState::Body: {
+                if (buffer.size() < Layout_.Body.Offset + Layout_.Body.Size) {
+                    return false;
+                }
+                Offset_ = Layout_.Body.Offset + Layout_.Body.Size;
+                State_ = EState::Done;
+                break;
+            }
+            case EState::ChunkData: {
+                size_t available = std::min(buffer.size() - Offset_, ChunkRemaining_);
+                if (available == 0) {
+                    return false;
+                }
+                // Запись всегда левее чтения: перед каждым куском стоит его размер
+                char* bodyEnd = buffer.data() + Layout_.Body.Offset + Layout_.Body.Size;
+                std::memmove(bodyEnd, buffer.data() + Offset_, available);
+                Layout_.Body.Size += available;
+                Offset_ += available;
+                ChunkRemaining_ -= available;
+                if (ChunkRemaining_ == 0) {
+                    State_ = EState::ChunkDataEnd;
+                }
+                break;
+            }
+            case EState::ChunkDataEnd: {
+                if (buffer.size() < Offset_ + CrLf.size()) {
+                    return false;
+                }
+                if (std::string_view(buffer).substr(Offset_, CrLf.size()) != CrLf) {
+                    throw THttpException(EHttpCode::BadRequest, "Chunk is not terminated by CRLF");
+                }
+                Offset_ += CrLf.size();
+                State_ = EState::ChunkSize;
+                break;
+            }
+            case EState::Done:
+                break;
+        }
+    }
+
+    Layout_.Size = Offset_;
+    return true;
+}
+
+const THttpRequestLayout& THttpRequestParser::GetLayout() const {
+    return Layout_;
+}
+
+THttpRequestLayout THttpRequestParser::ReleaseLayout() {
+    return std::move(Layout_);
+}
+
+void THttpRequestParser::Reset() {
+    State_ = EState::RequestLine;
+    Offset_ = 0;
+    Scanned_ = 0;
+    HeaderBegin_ = 0;
+    Chunked_ = false;
+    HasContentLength_ = false;
+    ContentLength_ = 0;
+    ChunkRemaining_ = 0;
+    Layout_ = THttpRequestLayout();
+}
+
+size_t THttpRequestParser::FindLineEnd(std::string_view buffer) {
+    // \r мог прийти последним байтом прошлого чтения
+    size_t from = std::max(Offset_, Scanned_ > 0 ? Scanned_ - 1 : 0);
+    auto lineEnd = buffer.find(CrLf, from);
+    if (lineEnd == std::string_view::npos) {
+        Scanned_ = buffer.size();
+    } else {
+        Scanned_ = lineEnd + CrLf.size();
+    }
+    return lineEnd;
+}
+
+void THttpRequestParser::ParseRequestLine(std::string_view buffer, size_t lineEnd) {
+    auto line = buffer.substr(0, lineEnd);
+
+    auto methodEnd = line.find(' ', Offset_);
+    auto targetEnd = methodEnd == std::string_view::npos ? methodEnd : line.find(' ', methodEnd + 1);
+    if (targetEnd == std::string_view::npos || methodEnd == Offset_ || targetEnd == methodEnd + 1 || targetEnd + 1 == line.size()) {
+        throw THttpException(EHttpCode::BadRequest, "Malformed request line: {}", line.substr(Offset_));
+    }
+
+    Layout_.Method = {Offset_, methodEnd - Offset_};
+    Layout_.Version = {targetEnd + 1, line.size() - targetEnd - 1};
+    if (!Layout_.Version.In(buffer).starts_with("HTTP/")) {
+        throw THttpException(EHttpCode::BadRequest, "Unsupported protocol: {}", Layout_.Version.In(buffer));
+    }
+
+    auto target = TBufferSpan{methodEnd + 1, targetEnd - methodEnd - 1};
+    auto query = target.In(buffer).find('?');
+    if (query == std::string_view::npos) {
+        Layout_.Path = target;
+    } else {
+        Layout_.Path = {target.Offset, query};
+        Layout_.Query = {target.Offset + query + 1, target.Size - query - 1};
+    }
+}
+
+void THttpRequestParser::ParseHeader(std::string_view buffer, size_t lineEnd) {
+    auto line = buffer.substr(0, lineEnd);
+
+    auto colon = line.find(':', Offset_);
+    if (colon == std::string_view::npos || colon == Offset_) {
+        throw THttpException(EHttpCode::BadRequest, "Malformed header: {}", line.substr(Offset_));
+    }
+    if (Layout_.Headers.size() >= MaxHeaderCount_) {
+        throw THttpException(EHttpCode::BadRequest, "Too many headers");
+    }
+    auto name = TBufferSpan{Offset_, colon - Offset_};
+    if (name.In(buffer).find_first_of(Whitespace) != std::string_view::npos) {
+        throw THttpException(EHttpCode::BadRequest, "Whitespace in header name: {}", name.In(buffer));
+    }
+    auto [valueBegin, valueEnd] = TrimBounds(line, colon + 1);
+    auto value = TBufferSpan{valueBegin, valueEnd - valueBegin};
+    Layout_.Headers.push_back({name, value});
+
+    if (EqualsIgnoreCase(name.In(buffer), "Content-Length")) {
+        auto text = value.In(buffer);
+        size_t contentLength = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), contentLength);
+        if (error != std::errc() || end != text.data() + text.size() || text.empty()) {
+            throw THttpException(EHttpCode::BadRequest, "Invalid Content-Length: {}", text);
+        }
+        if (HasContentLength_ && contentLength != ContentLength_) {
+            throw THttpException(EHttpCode::BadRequest, "Conflicting Content-Length headers");
+        }
+        HasContentLength_ = true;
+        ContentLength_ = contentLength;
+    } else if (EqualsIgnoreCase(name.In(buffer), "Transfer-Encoding")) {
+        Chunked_ = Chunked_ || ContainsIgnoreCase(value.In(buffer), "chunked");
+    }
+}
+
+void THttpRequestParser::ParseChunkSize(std::string_view buffer, size_t lineEnd) {
+    auto line = buffer.substr(Offset_, lineEnd - Offset_);
+    // Расширения куска после ';' игнорируем
+    line = line.substr(0, line.find(';'));
+    auto [begin, end] = TrimBounds(line, 0);
+    line = line.substr(begin, end - begin);
+
+    size_t chunkSize = 0;
+    auto [parsed, error] = std::from_chars(line.data(), line.data() + line.size(), chunkSize, 16);
+    if (error != std::errc() || parsed != line.data() + line.size() || line.empty()) {
+        throw THttpException(EHttpCode::BadRequest, "Invalid chunk size: {}", line);
+    }
+    if (chunkSize > MaxRequestSize_ || Layout_.Body.Size + chunkSize > MaxRequestSize_) {
+        throw THttpException(EHttpCode::BadRequest, "Request body is too large");
+    }
+
+    if (chunkSize == 0) {
+        HeaderBegin_ = lineEnd + CrLf.size();
+        State_ = EState::Trailers;
+    } else {
+        ChunkRemaining_ = chunkSize;
+        State_ = EState::ChunkData;
+    }
+}
+
+void THttpRequestParser::StartBody() {
+    Layout_.Body = {Offset_, 0};
+
+    // Transfer-Encoding важнее Content-Length (RFC 9112, 6.3)
+    if (Chunked_) {
+        State_ = EState::ChunkSize;
+        return;
+    }
+    if (ContentLength_ > MaxRequestSize_) {
+        throw THttpException(EHttpCode::BadRequest, "Request body is too large: {}", ContentLength_);
+    }
+    Layout_.Body.Size = ContentLength_;
+    State_ = ContentLength_ ? EState::Body : EState::Done;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
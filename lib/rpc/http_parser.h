@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Участок буфера запроса. Храним смещения, а не string_view: буфер
+// дописывается между чтениями и может переехать.
+struct TBufferSpan {
+    size_t Offset = 0;
+    size_t Size = 0;
+
+    std::string_view In(std::string_view buffer) const {
+        return buffer.substr(Offset, Size);
+    }
+};
+
+// Разметка разобранного запроса внутри его буфера
+struct THttpRequestLayout {
+    struct THeader {
+        TBufferSpan Name;
+        TBufferSpan Value;
+    };
+
+    TBufferSpan Method;
+    TBufferSpan Path;
+    TBufferSpan Query;
+    TBufferSpan Version;
+    std::vector<THeader> Headers;
+    // Для chunked тело уже склеено в буфере подряд
+    TBufferSpan Body;
+    // Сколько байт буфера занимает запрос целиком
+    size_t Size = 0;
+
+    // Имя заголовка сравнивается без учета регистра, пустая строка если его нет
+    std::string_view FindHeader(std::string_view buffer, std::string_view name) const;
+};
+
+// Потоковый разбор HTTP/1.1 запроса прямо в буфере соединения.
+// Parse можно звать после каждого чтения: разбор продолжается с места
+// остановки, уже просмотренные байты повторно не сканируются. Тело
+// читается по Content-Length или Transfer-Encoding: chunked, во втором
+// случае куски сдвигаются в буфере на место заголовков кусков.
+// Ошибки формата и превышение лимита — THttpException с BadRequest.
+class THttpRequestParser {
+public:
+    // Строка запроса с заголовками и трейлеры ограничены отдельно от тела
+    explicit THttpRequestParser(
+        size_t maxRequestSize = 64 * 1024 * 1024,
+        size_t maxHeaderSize = 64 * 1024,
+        size_t maxHeaderCount = 100);
+
+    // true, когда в начале буфера лежит полностью прочитанный запрос
+    bool Parse(std::string& buffer);
+
+    // Валидна после того, как Parse вернул true
+    const THttpRequestLayout& GetLayout() const;
+    THttpRequestLayout ReleaseLayout();
+
+    // Готовит парсер к следующему запросу, буфер должен начинаться с него
+    void Reset();
+
+private:
+    enum class EState {
+        RequestLine,
+        Headers,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkDataEnd,
+        Trailers,
+        Done,
+    };
+
+    // Конец текущей строки (позиция \r\n) или npos, если строка не дочитана
+    size_t FindLineEnd(std::string_view buffer);
+
+    void ParseRequestLine(std::string_view buffer, size_t lineEnd);
+    void ParseHeader(std::string_view buffer, size_t lineEnd);
+    void ParseChunkSize(std::string_view buffer, size_t lineEnd);
+    void StartBody();
+
+    const size_t MaxRequestSize_;
+    const size_t MaxHeaderSize_;
+    const size_t MaxHeaderCount_;
+
+    EState State_ = EState::RequestLine;
+    // Начало еще не разобранной части буфера
+    size_t Offset_ = 0;
+    // До этой позиции конец строки уже искали
+    size_t Scanned_ = 0;
+    // Начало разбираемого блока заголовков: 0 для запроса, начало трейлеров для них
+    size_t HeaderBegin_ = 0;
+
+    bool Chunked_ = false;
+    bool HasContentLength_ = false;
+    size_t ContentLength_ = 0;
+    size_t ChunkRemaining_ = 0;
+
+    THttpRequestLayout Layout_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
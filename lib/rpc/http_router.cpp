@@ -0,0 +1,229 @@
+#include <rpc/http_router.h>
+
+#include <common/exception.h>
+
+#include <algorithm>
+#include <charconv>
+
+namespace NRpc {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr std::string_view RegexSymbols = ".*+?[](){}|^$\\";
+constexpr std::string_view CatchAll = ".*";
+
+bool IsIdentifier(std::string_view value) {
+    if (value.empty()) {
+        return false;
+    }
+    for (char c : value) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Следующий сегмент пути, начинающийся с position; position сдвигается
+// на начало следующего сегмента или становится npos
+std::string_view NextSegment(std::string_view path, size_t& position) {
+    auto slash = path.find('/', position);
+    auto segment = path.substr(position, slash == std::string_view::npos ? std::string_view::npos : slash - position);
+    position = slash == std::string_view::npos ? std::string_view::npos : slash + 1;
+    return segment;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+void THttpRouter::Add(std::string_view method, const std::string& pattern, size_t route) {
+    auto methodIt = Methods_.find(method);
+    if (methodIt == Methods_.end()) {
+        methodIt = Methods_.emplace(std::string(method), TMethodRoutes()).first;
+    }
+    auto& routes = methodIt->second;
+
+    struct TSegment {
+        std::string_view Literal;
+        std::optional<TParamEdge> Param;
+        bool IsCatchAll = false;
+    };
+
+    // Сначала разбираем шаблон целиком: если в нем есть регулярное
+    // выражение, в дерево он не попадает
+    std::vector<TSegment> segments;
+    bool isRegex = !pattern.starts_with('/');
+    bool hasParams = false;
+    for (size_t position = isRegex ? std::string_view::npos : 1; position != std::string_view::npos && !isRegex;) {
+        auto segment = NextSegment(pattern, position);
+
+        if (segment == CatchAll && position == std::string_view::npos) {
+            segments.push_back({.Literal = {}, .Param = std::nullopt, .IsCatchAll = true});
+            continue;
+        }
+
+        if (segment.size() > 2 && segment.front() == '{' && segment.back() == '}') {
+            auto body = segment.substr(1, segment.size() - 2);
+            auto colon = body.find(':');
+            auto name = body.substr(0, colon);
+            auto type = colon == std::string_view::npos ? std::string_view("string") : body.substr(colon + 1);
+
+            if (IsIdentifier(name)) {
+                EParamType paramType;
+                if (type == "string") {
+                    paramType = EParamType::String;
+                } else if (type == "int") {
+                    paramType = EParamType::Int;
+                } else if (type == "uint") {
+                    paramType = EParamType::UInt;
+                } else {
+                    THROW("Unknown path parameter type '{}' in route {}", type, pattern);
+                }
+                segments.push_back({.Literal = {}, .Param = TParamEdge{std::string(name), paramType, nullptr}, .IsCatchAll = false});
+                hasParams = true;
+                continue;
+            }
+        }
+
+        if (segment.find_first_of(RegexSymbols) != std::string_view::npos) {
+            isRegex = true;
+            break;
+        }
+        segments.push_back({.Literal = segment, .Param = std::nullopt, .IsCatchAll = false});
+    }
+
+    if (isRegex) {
+        if (hasParams) {
+            THROW("Route {} mixes path parameters with a regular expression", pattern);
+        }
+        routes.Regexes.push_back({std::regex(pattern), route});
+        return;
+    }
+
+    TNode* node = &routes.Root;
+    for (auto& segment : segments) {
+        if (segment.IsCatchAll) {
+            if (!node->CatchAllRoute) {
+                node->CatchAllRoute = route;
+            }
+            return;
+        }
+
+        if (segment.Param) {
+            auto edge = std::find_if(node->Params.begin(), node->Params.end(), [&] (const TParamEdge& edge) {
+                return edge.Name == segment.Param->Name && edge.Type == segment.Param->Type;
+            });
+            if (edge == node->Params.end()) {
+                segment.Param->Node = std::make_unique<TNode>();
+                node->Params.push_back(std::move(*segment.Param));
+                edge = std::prev(node->Params.end());
+            }
+            node = edge->Node.get();
+            continue;
+        }
+
+        auto& child = node->Literals[std::string(segment.Literal)];
+        if (!child) {
+            child = std::make_unique<TNode>();
+        }
+        node = child.get();
+    }
+
+    // Повторная регистрация не перекрывает первую, как при линейном поиске
+    if (!node->Route) {
+        node->Route = route;
+    }
+}
+
+std::optional<THttpRouter::TMatch> THttpRouter::Match(std::string_view method, std::string_view path) const {
+    auto methodIt = Methods_.find(method);
+    if (methodIt == Methods_.end()) {
+        return std::nullopt;
+    }
+    const auto& routes = methodIt->second;
+
+    std::optional<TMatch> best;
+    if (path.starts_with('/')) {
+        std::vector<TPathParam> params;
+        MatchNode(routes.Root, path, 1, params, best);
+    }
+
+    for (const auto& regex : routes.Regexes) {
+        if (best && best->Route < regex.Route) {
+            break;
+        }
+        if (std::regex_match(path.begin(), path.end(), regex.Regex)) {
+            return TMatch{.Route = regex.Route, .Params = {}};
+        }
+    }
+    return best;
+}
+
+bool THttpRouter::Accepts(EParamType type, std::string_view segment) {
+    if (segment.empty()) {
+        return false;
+    }
+    switch (type) {
+        case EParamType::String:
+            return true;
+        case EParamType::Int: {
+            int64_t value;
+            auto [end, error] = std::from_chars(segment.data(), segment.data() + segment.size(), value);
+            return error == std::errc() && end == segment.data() + segment.size();
+        }
+        case EParamType::UInt: {
+            uint64_t value;
+            auto [end, error] = std::from_chars(segment.data(), segment.data() + segment.size(), value);
+            return error == std::errc() && end == segment.data() + segment.size();
+        }
+    }
+    return false;
+}
+
+void THttpRouter::MatchNode(
+    const TNode& node,
+    std::string_view path,
+    size_t position,
+    std::vector<TPathParam>& params,
+    std::optional<TMatch>& best) const
+{
+    auto isBetter = [&] (size_t route) {
+        return !best || route < best->Route;
+    };
+
+    if (position == std::string_view::npos) {
+        if (node.Route && isBetter(*node.Route)) {
+            best = TMatch{.Route = *node.Route, .Params = params};
+        }
+        return;
+    }
+
+    if (node.CatchAllRoute && isBetter(*node.CatchAllRoute)) {
+        best = TMatch{.Route = *node.CatchAllRoute, .Params = params};
+    }
+
+    auto next = position;
+    auto segment = NextSegment(path, next);
+
+    if (auto it = node.Literals.find(segment); it != node.Literals.end()) {
+        MatchNode(*it->second, path, next, params, best);
+    }
+
+    for (const auto& edge : node.Params) {
+        if (!Accepts(edge.Type, segment)) {
+            continue;
+        }
+        params.push_back({edge.Name, segment});
+        MatchNode(*edge.Node, path, next, params, best);
+        params.pop_back();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
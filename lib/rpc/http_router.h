@@ -0,0 +1,91 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Таблица маршрутов, собранная один раз при регистрации обработчиков.
+// Шаблон пути разбивается на сегменты и кладется в префиксное дерево
+// отдельно для каждого метода:
+//   /objects/list         — литеральные сегменты
+//   /objects/{id:int}     — параметр, тип int, uint или string (по умолчанию)
+//   /static/.*            — хвост пути любой длины, только последним сегментом
+// Остальные шаблоны считаются регулярными выражениями, они компилируются
+// при регистрации и проверяются только если дерево не дало более раннего
+// маршрута. Как и раньше, из подходящих выбирается зарегистрированный первым.
+class THttpRouter {
+public:
+    struct TPathParam {
+        std::string_view Name;
+        // Указывает внутрь пути, переданного в Match
+        std::string_view Value;
+    };
+
+    struct TMatch {
+        size_t Route;
+        std::vector<TPathParam> Params;
+    };
+
+    void Add(std::string_view method, const std::string& pattern, size_t route);
+
+    std::optional<TMatch> Match(std::string_view method, std::string_view path) const;
+
+private:
+    enum class EParamType {
+        String,
+        Int,
+        UInt,
+    };
+
+    struct TNode;
+    using TNodePtr = std::unique_ptr<TNode>;
+
+    struct TParamEdge {
+        std::string Name;
+        EParamType Type;
+        TNodePtr Node;
+    };
+
+    struct TNode {
+        std::map<std::string, TNodePtr, std::less<>> Literals;
+        std::vector<TParamEdge> Params;
+        // Маршрут, заканчивающийся в этом узле
+        std::optional<size_t> Route;
+        // Маршрут с хвостом .* после этого узла
+        std::optional<size_t> CatchAllRoute;
+    };
+
+    struct TRegexRoute {
+        std::regex Regex;
+        size_t Route;
+    };
+
+    struct TMethodRoutes {
+        TNode Root;
+        // В порядке регистрации
+        std::vector<TRegexRoute> Regexes;
+    };
+
+    static bool Accepts(EParamType type, std::string_view segment);
+
+    void MatchNode(
+        const TNode& node,
+        std::string_view path,
+        size_t position,
+        std::vector<TPathParam>& params,
+        std::optional<TMatch>& best) const;
+
+    std::map<std::string, TMethodRoutes, std::less<>> Methods_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
@@ -4,6 +4,9 @@
 #include <common/exception.h>
 #include <common/logging.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <thread>
 #include <signal.h>
@@ -13,7 +16,14 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
 #include <poll.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 #define INVALID_SOCKET -1
 #define SOCKET_ERROR -1
 #endif
@@ -26,42 +36,47 @@ namespace {
 
 inline const std::string LoggingSource = "HttpServer";
 
-std::vector<std::string> Split(const std::string& s, const std::string& delimiter, size_t limit = 0) {
-    std::vector<std::string> tokens;
-    size_t pos_start = 0;
-    const size_t delimiter_length = delimiter.length();
-
-    if (delimiter_length == 0) {
-        tokens.push_back(s);
-        return tokens;
-    }
-
-    while (true) {
-        size_t pos_end = s.find(delimiter, pos_start);
-        bool reached_limit = (limit > 0) && (tokens.size() + 1 >= limit);
-
-        if (reached_limit || pos_end == std::string::npos) {
-            tokens.push_back(s.substr(pos_start));
-            break;
-        }
+// Предел размера одного запроса, больше в буфере соединения не копим
+constexpr size_t MaxRequestSize = 64 * 1024 * 1024;
+constexpr size_t ReadChunkSize = 16 * 1024;
+constexpr int MaxEpollEvents = 256;
+// Сколько сегментов ответа отдавать в один sendmsg
+constexpr size_t MaxWriteSegments = 64;
+constexpr std::string_view LastChunk = "0\r\n\r\n";
+// Как часто проверять простаивающие соединения
+constexpr auto IdleCheckPeriod = std::chrono::milliseconds(1000);
+// Как часто Drain проверяет, закрылись ли соединения
+constexpr auto DrainPollPeriod = std::chrono::milliseconds(10);
+// Как часто поток передачи сокетов проверяет остановку сервера
+constexpr auto HandoffPollPeriod = std::chrono::milliseconds(100);
+
+bool ContainsToken(std::string_view value, std::string_view token) {
+    return std::search(value.begin(), value.end(), token.begin(), token.end(), [] (char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    }) != value.end();
+}
 
-        tokens.push_back(s.substr(pos_start, pos_end - pos_start));
-        pos_start = pos_end + delimiter_length;
+// HTTP/1.1 держит соединение, если клиент не попросил закрыть, HTTP/1.0 — только по просьбе
+bool IsKeepAliveRequested(const TRequest& request) {
+    auto connection = request.GetHeader("Connection");
+    if (request.GetVersion() == "HTTP/1.0") {
+        return ContainsToken(connection, "keep-alive");
     }
-
-    return tokens;
+    return !ContainsToken(connection, "close");
 }
 
-std::string Trim(const std::string& s) {
-    const char* whitespace = " \t\r\n";
-    size_t start = s.find_first_not_of(whitespace);
-    if (start == std::string::npos) return "";
-    size_t end = s.find_last_not_of(whitespace);
-    return s.substr(start, end - start + 1);
+void PinThread(std::thread& thread, int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (int error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus); error != 0) {
+        LOG_ERROR("Failed to pin reactor thread to cpu {}: {}", cpu, error);
+    }
 }
 
-bool IsEmptyLine(const std::string& s) {
-    return s.find_first_not_of("\r\n") == std::string::npos;
+void SetNonBlocking(SOCKET socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    ASSERT(flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1, "Failed to make socket non-blocking: {}", errno);
 }
 
 std::string ReadFile(const std::filesystem::path& path) {
@@ -112,6 +127,7 @@ std::string GetHttpStatusName(EHttpCode code) {
         case EHttpCode::Timeout:            return "Request Timeout";
         case EHttpCode::Conflict:           return "Conflict";
         case EHttpCode::Gone:               return "Gone";
+        case EHttpCode::UnsupportedMediaType: return "Unsupported Media Type";
         
         case EHttpCode::InternalError:      return "Internal Server Error";
         case EHttpCode::NotImplemented:     return "Not Implemented";
@@ -124,7 +140,7 @@ std::string GetHttpStatusName(EHttpCode code) {
 }
 
 bool IsAcceptType(const NRpc::TRequest& request, const std::string& type) {
-    const std::string acceptHeader = request.GetHeader("Accept");
+    const std::string_view acceptHeader = request.GetHeader("Accept");
     
     // If empty, assume the client accepts anything
     if (acceptHeader.empty()) {
@@ -192,70 +208,84 @@ TResponse& TResponse::SetHtml(const std::filesystem::path& path) {
     return *this;
 }
 
+TResponse& TResponse::SetStream(std::function<void(TResponseWriter&)> bodyWriter) {
+    Body.clear();
+    BodyWriter = std::move(bodyWriter);
+    Headers.erase("Content-Length");
+    Headers["Transfer-Encoding"] = "chunked";
+    return *this;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-TRequest::TRequest(const std::string& recievedData) {
-    std::istringstream recv(recievedData);
-    std::string line;
-    std::getline(recv, line);
-
-    auto split = Split(Trim(line), " ");
-    auto urlSplit = Split(split[1], "?");
-
-    Method_ = split[0];
-    Url_ = urlSplit[0];
-    if (urlSplit.size() > 1) {
-        for (auto args : Split(urlSplit[1], "&")) {
-            auto sp = Split(args, "=");
-            if (sp.size() == 2) {
-                UrlArgs_[sp[0]] = sp[1];
-            }
-        }
+TRequest::TRequest(std::string data) {
+    THttpRequestParser parser(data.size());
+    if (!parser.Parse(data)) {
+        throw THttpException(EHttpCode::BadRequest, "Incomplete request");
     }
-    Version_ = split[2];
+    Layout_ = parser.ReleaseLayout();
+    Data_ = std::move(data);
+}
 
-    while (true) {
-        if (!std::getline(recv, line) || line == "\r" || line == "\r\n") {
-            break;
-        }
-        split = Split(Trim(line), ": ");
-        if (split.size() >= 2) {
-            Headers_[split[0]] = split[1];
-        }
-    }
-    
-    // Read body - capture the rest of the data
-    std::string bodyContent;
-    char c;
-    while (recv.get(c)) {
-        bodyContent.push_back(c);
-    }
-    Body_ = bodyContent;
-    
-    // Check for Content-Length to validate we got the entire body
-    auto contentLenIter = Headers_.find("Content-Length");
-    if (contentLenIter != Headers_.end()) {
-        size_t expectedLen = std::stoul(contentLenIter->second);
-        if (Body_.size() < expectedLen) {
-            LOG_WARNING("Incomplete request body: expected {}, got {}", expectedLen, Body_.size());
-        }
-    }
+TRequest::TRequest(std::string data, THttpRequestLayout layout)
+    : Data_(std::move(data))
+    , Layout_(std::move(layout))
+{}
+
+std::string_view TRequest::GetMethod() const {
+    return Layout_.Method.In(Data_);
 }
 
-std::string TRequest::GetMethod() const {
-    return Method_;
+std::string_view TRequest::GetURL() const {
+    return Layout_.Path.In(Data_);
 }
 
-std::string TRequest::GetURL() const {
-    return Url_;
+std::string_view TRequest::GetQuery() const {
+    return Layout_.Query.In(Data_);
+}
+
+std::string_view TRequest::GetVersion() const {
+    return Layout_.Version.In(Data_);
 }
 
-std::string TRequest::GetVersion() const {
-    return Version_;
+std::string_view TRequest::GetHeader(std::string_view key) const {
+    return Layout_.FindHeader(Data_, key);
 }
 
-std::string TRequest::GetHeader(const std::string& key) const {
-    return Headers_.contains(key) ? Headers_.at(key) : "";
+std::string_view TRequest::GetBody() const {
+    return Layout_.Body.In(Data_);
+}
+
+std::string_view TRequest::GetDecodedBody(std::string* storage) const {
+    auto encoding = GetHeader("Content-Encoding");
+    if (encoding.empty()) {
+        return GetBody();
+    }
+
+    auto compression = ParseContentEncoding(encoding);
+    if (!compression) {
+        throw THttpException(EHttpCode::UnsupportedMediaType, "Unsupported content encoding: {}", encoding);
+    }
+    if (*compression == ECompression::None) {
+        return GetBody();
+    }
+    *storage = Decompress(*compression, GetBody());
+    return *storage;
+}
+
+std::string_view TRequest::GetPathParam(std::string_view name) const {
+    for (const auto& param : PathParams_) {
+        if (param.Name == name) {
+            return param.Value.In(Data_);
+        }
+    }
+    return {};
+}
+
+void TRequest::SetPathParam(std::string_view name, std::string_view value) {
+    ASSERT(value.data() >= Data_.data() && value.data() + value.size() <= Data_.data() + Data_.size(),
+        "Path parameter {} does not point into the request", name);
+    PathParams_.push_back({std::string(name), {static_cast<size_t>(value.data() - Data_.data()), value.size()}});
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -267,7 +297,7 @@ THandlerBase::THandlerBase(const std::string& version)
 THandlerBase::THandlerBase(const TRequest& request)
     : THandlerBase()
 {
-    Version_ = request.GetVersion();
+    Version_ = std::string(request.GetVersion());
 }
 
 THandlerBase THandlerBase::SetVersion(const std::string& version) {
@@ -275,32 +305,37 @@ THandlerBase THandlerBase::SetVersion(const std::string& version) {
     return *this;
 }
 
-std::string THandlerBase::FormatResponse(const TResponse& response) const {
-    std::ostringstream headers;
+std::string THandlerBase::FormatHead(const TResponse& response) const {
+    std::string head;
+    head.reserve(128);
+
+    // Make sure the status line starts with HTTP/
+    if (!Version_.starts_with("HTTP/")) {
+        head += "HTTP/";
+    }
+    head += Version_;
+    head += ' ';
+    head += std::to_string(static_cast<int>(response.HttpStatus));
+    head += ' ';
+    head += GetHttpStatusName(response.HttpStatus);
+    head += "\r\n";
+
     for (const auto& [name, value] : response.Headers) {
-        headers << name << ": " << value << "\r\n";
+        head += name;
+        head += ": ";
+        head += value;
+        head += "\r\n";
     }
+    // Empty line separating headers from body
+    head += "\r\n";
+    return head;
+}
 
-    // Make sure the status line starts with HTTP/
-    std::string statusLine;
-    if (Version_.find("HTTP/") == 0) {
-        statusLine = Version_;
-    } else {
-        statusLine = "HTTP/" + Version_;
-    }
-
-    // Build the HTTP response with the correct format
-    std::string httpResponse = 
-        statusLine + " " + std::to_string(static_cast<int>(response.HttpStatus)) + 
-        " " + GetHttpStatusName(response.HttpStatus) + "\r\n" +
-        headers.str() + 
-        "\r\n";  // Empty line separating headers from body
-    
+std::string THandlerBase::FormatResponse(const TResponse& response) const {
     // Append the binary body without any string formatting
     // which could corrupt binary data
-    std::string result = httpResponse;
+    auto result = FormatHead(response);
     result.append(response.Body);
-    
     return result;
 }
 
@@ -411,9 +446,40 @@ int TSocketBase::Poll(const SOCKET& socket, int timeoutMs) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-THttpServer::THttpServer(const std::string& interfaceIp, const short int port)
-    : NotFoundHandler_(&DefaultNotFoundHandler)
+void THttpServerConfig::Load(const nlohmann::json& data) {
+    KeepAliveTimeout = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "keep_alive_timeout_ms", 60000));
+    MaxKeepAliveRequests = TConfigBase::Load<uint32_t>(data, "max_keep_alive_requests", 1000);
+    StreamChunkSize = TConfigBase::Load<size_t>(data, "stream_chunk_size", 64 * 1024);
+    MaxPendingOutput = TConfigBase::Load<size_t>(data, "max_pending_output", 4 * 1024 * 1024);
+    MaxPipelinedInput = TConfigBase::Load<size_t>(data, "max_pipelined_input", 1024 * 1024);
+    EnableCompression = TConfigBase::Load<bool>(data, "enable_compression", true);
+    CompressionMinSize = TConfigBase::Load<size_t>(data, "compression_min_size", 1024);
+    GzipLevel = TConfigBase::Load<int>(data, "gzip_level", 6);
+    ZstdLevel = TConfigBase::Load<int>(data, "zstd_level", 3);
+    MaxInFlight = TConfigBase::Load<size_t>(data, "max_in_flight", 0);
+    MaxQueuedRequests = TConfigBase::Load<size_t>(data, "max_queued_requests", 1024);
+    MaxQueueTime = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "max_queue_time_ms", 0));
+    ReactorCount = std::max<size_t>(TConfigBase::Load<size_t>(data, "reactor_count", 1), 1);
+    ReusePort = TConfigBase::Load<bool>(data, "reuse_port", false);
+    ReactorCpus = TConfigBase::Load<std::vector<int>>(data, "reactor_cpus", std::vector<int>());
+    DrainTimeout = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "drain_timeout_ms", 30000));
+    HandoffSocket = TConfigBase::Load<std::string>(data, "handoff_socket", "");
+    HandoffTimeout = std::chrono::milliseconds(TConfigBase::Load<uint32_t>(data, "handoff_timeout_ms", 5000));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+THttpServer::THttpServer(const std::string& interfaceIp, const short int port, THttpServerConfigPtr config)
+    : Config_(std::move(config))
+    , NotFoundHandler_(&DefaultNotFoundHandler)
 {
+    if (!Config_) {
+        Config_ = NCommon::New<THttpServerConfig>();
+        Config_->Load(nlohmann::json::object());
+    }
+    Admission_ = std::make_unique<TAdmissionController>(Config_->MaxInFlight, Config_->MaxQueuedRequests, Config_->MaxQueueTime);
+    DrainRequestFd_ = eventfd(0, EFD_CLOEXEC);
+    ASSERT(DrainRequestFd_ != -1, "Failed to create eventfd: {}", ErrorCode());
     Listen(interfaceIp, port);
     LOG_INFO("Successfuly start listening...");
 }
@@ -422,50 +488,29 @@ void THttpServer::SetNotFoundHandler(const TUnifiedHandler& handler) {
     NotFoundHandler_ = handler;
 }
 
+TAdmissionStats THttpServer::GetAdmissionStats() const {
+    return Admission_->GetStats();
+}
+
 void THttpServer::Listen(const std::string& interfaceIp, const short int port) {
     try {
         if (Socket_ != INVALID_SOCKET) {
             CloseSocket();
         }
-
-        struct addrinfo hints;
-        memset(&hints, 0, sizeof(hints));
-
-        hints.ai_family = AF_INET;
-        hints.ai_socktype = SOCK_STREAM;
-        hints.ai_protocol = IPPROTO_TCP;
-        hints.ai_flags = AI_PASSIVE;
-
-        struct addrinfo *addr = NULL;
-        int res = getaddrinfo(interfaceIp.c_str(), std::to_string(port).c_str(), &hints, &addr);
-
-        if (res != 0) {
-            freeaddrinfo(addr);
-            THROW("Failed getaddrinfo: {}", res);
-        }
-
-        Socket_ = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
-        bool needFree = true;
-        if (Socket_ == INVALID_SOCKET) {
-            LOG_ERROR("Cant open socket: {}", ErrorCode());
-            freeaddrinfo(addr);
-            needFree = false;
+        for (auto listener : ExtraListeners_) {
+            CloseSocket(listener);
         }
+        ExtraListeners_.clear();
 
-        if (bind(Socket_, addr->ai_addr, addr->ai_addrlen) == SOCKET_ERROR) {
-            LOG_ERROR("Failed to bind: {}", ErrorCode());
-            freeaddrinfo(addr);
-            CloseSocket();
-            needFree = false;
-        }
-
-        if (needFree) {
-            freeaddrinfo(addr);
+        // Работающий предыдущий процесс отдаст свои сокеты вместе с очередью соединений
+        if (!Config_->HandoffSocket.empty() && ReceiveListeners()) {
+            return;
         }
 
-        if (listen(Socket_, SOMAXCONN) == SOCKET_ERROR) {
-            CloseSocket();
-            THROW("Failed to start listen: {}", ErrorCode());
+        Socket_ = OpenListener(interfaceIp, port);
+        // По сокету на каждый реактор, ядро само распределяет между ними соединения
+        for (size_t i = 1; i < Config_->ReactorCount; ++i) {
+            ExtraListeners_.push_back(OpenListener(interfaceIp, port));
         }
     } catch (std::exception& ex) {
         LOG_ERROR("Failed to listen: {}", ex);
@@ -474,82 +519,867 @@ void THttpServer::Listen(const std::string& interfaceIp, const short int port) {
     }
 }
 
+bool THttpServer::ReceiveListeners() {
+    auto listeners = NRpc::ReceiveListeners(Config_->HandoffSocket, &HandoffPeer_, Config_->HandoffTimeout);
+    if (listeners.empty()) {
+        return false;
+    }
+    if (listeners.size() != Config_->ReactorCount) {
+        LOG_WARNING("Received {} listening sockets, {} reactors configured; using received ones", listeners.size(), Config_->ReactorCount);
+    }
+
+    Socket_ = listeners.front();
+    ExtraListeners_.assign(listeners.begin() + 1, listeners.end());
+    LOG_INFO("Took over {} listening sockets from the previous process", listeners.size());
+    return true;
+}
+
+SOCKET THttpServer::OpenListener(const std::string& interfaceIp, const short int port) const {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_PASSIVE;
+
+    struct addrinfo *addr = NULL;
+    int res = getaddrinfo(interfaceIp.c_str(), std::to_string(port).c_str(), &hints, &addr);
+
+    if (res != 0) {
+        freeaddrinfo(addr);
+        THROW("Failed getaddrinfo: {}", res);
+    }
+
+    SOCKET listener = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+    if (listener == INVALID_SOCKET) {
+        freeaddrinfo(addr);
+        THROW("Cant open socket: {}", ErrorCode());
+    }
+
+    // Сервер сам закрывает соединения, и после перезапуска порт занят ими в TIME_WAIT
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (Config_->ReusePort || Config_->ReactorCount > 1) {
+        setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    }
+
+    if (bind(listener, addr->ai_addr, addr->ai_addrlen) == SOCKET_ERROR) {
+        auto error = ErrorCode();
+        freeaddrinfo(addr);
+        CloseSocket(listener);
+        THROW("Failed to bind: {}", error);
+    }
+    freeaddrinfo(addr);
+
+    if (listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+        auto error = ErrorCode();
+        CloseSocket(listener);
+        THROW("Failed to start listen: {}", error);
+    }
+    return listener;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-void THttpServer::ProcessClient() {
-    if (!IsValid()) {
-        LOG_ERROR("Server (listening) socket is invalid!");
+struct THttpServer::TReactor {
+    size_t Index;
+    SOCKET Listener;
+    int EpollFd = -1;
+    int WakeupFd = -1;
+    std::thread Thread;
+
+    // Слушающий сокет убран из epoll, Drain может его закрыть
+    std::atomic<bool> ListenerDetached = false;
+    // Принадлежит потоку реактора
+    bool DrainStarted = false;
+
+    // Для мониторинга, читаются из других потоков
+    std::atomic<size_t> ConnectionCount = 0;
+    std::atomic<uint64_t> Accepted = 0;
+
+    // Принадлежит потоку реактора
+    std::unordered_map<SOCKET, TConnectionPtr> Connections;
+
+    // Ответы, готовые к отправке, передаются из рабочих потоков в реактор
+    std::mutex CompletedMutex;
+    std::vector<TResponsePart> Completed;
+};
+
+struct THttpServer::TConnection {
+    SOCKET Socket;
+    // Реактор, принявший соединение; только он читает и пишет сокет
+    TReactor* Reactor;
+    std::string Input;
+    // Сегменты ответа в порядке отправки, уходят одним sendmsg
+    std::deque<std::string> Output;
+    // Уже отправлено из первого сегмента
+    size_t OutputOffset = 0;
+    // Разбирает Input по мере чтения
+    THttpRequestParser Parser{MaxRequestSize};
+    // Обработано запросов за время жизни соединения
+    uint32_t RequestCount = 0;
+    std::chrono::steady_clock::time_point LastActivity = std::chrono::steady_clock::now();
+    // Запрос передан в пул и ответ еще не получен
+    bool InFlight = false;
+    // Последняя часть ответа в Output, после ее отправки можно брать следующий запрос
+    bool ResponseFinished = false;
+    // Закрыть после отправки текущего ответа
+    bool CloseAfterWrite = false;
+    // Клиент закрыл свою сторону, но ждет ответ
+    bool PeerClosed = false;
+    // Input переполнен, сокет не дочитан; чтение возобновляется после ответа
+    bool ReadPaused = false;
+    bool Closed = false;
+
+    // Общее с рабочим потоком, пишущим потоковый ответ
+    std::mutex OutputMutex;
+    std::condition_variable OutputSpace;
+    // Передано в цикл событий, но еще не отправлено
+    size_t QueuedBytes = 0;
+    bool Aborted = false;
+};
+
+THttpServer::~THttpServer() {
+    Stop();
+    // Пул может держать задачи, ссылающиеся на сервер, дожидаемся их раньше полей
+    Workers_.reset();
+    for (const auto& reactor : Reactors_) {
+        if (reactor->EpollFd != -1) {
+            close(reactor->EpollFd);
+        }
+        if (reactor->WakeupFd != -1) {
+            close(reactor->WakeupFd);
+        }
+    }
+    for (auto listener : ExtraListeners_) {
+        CloseSocket(listener);
+    }
+    if (HandoffPeer_ != INVALID_SOCKET) {
+        close(HandoffPeer_);
+    }
+    close(DrainRequestFd_);
+}
+
+void THttpServer::Start(NCommon::TThreadPoolPtr workers) {
+    ASSERT(IsValid(), "Server (listening) socket is invalid!");
+    ASSERT(Reactors_.empty() || !Reactors_.front()->Thread.joinable(), "Server is already started");
+
+    Workers_ = std::move(workers);
+    Stopping_ = false;
+
+    // После Stop реакторы переиспользуются вместе с epoll
+    if (Reactors_.empty()) {
+        std::vector<SOCKET> listeners = {Socket_};
+        listeners.insert(listeners.end(), ExtraListeners_.begin(), ExtraListeners_.end());
+
+        for (size_t i = 0; i < listeners.size(); ++i) {
+            auto reactor = std::make_unique<TReactor>();
+            reactor->Index = i;
+            reactor->Listener = listeners[i];
+            reactor->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+            ASSERT(reactor->EpollFd != -1, "Failed to create epoll: {}", ErrorCode());
+            reactor->WakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            ASSERT(reactor->WakeupFd != -1, "Failed to create eventfd: {}", ErrorCode());
+
+            SetNonBlocking(reactor->Listener);
+            for (int fd : {static_cast<int>(reactor->Listener), reactor->WakeupFd}) {
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLET;
+                event.data.fd = fd;
+                ASSERT(epoll_ctl(reactor->EpollFd, EPOLL_CTL_ADD, fd, &event) == 0, "Failed to register fd in epoll: {}", ErrorCode());
+            }
+            Reactors_.push_back(std::move(reactor));
+        }
+    }
+
+    for (const auto& reactor : Reactors_) {
+        reactor->Thread = std::thread(&THttpServer::RunLoop, this, std::ref(*reactor));
+        if (!Config_->ReactorCpus.empty()) {
+            PinThread(reactor->Thread, Config_->ReactorCpus[reactor->Index % Config_->ReactorCpus.size()]);
+        }
+    }
+
+    if (Config_->HandoffSocket.empty()) {
         return;
     }
+    // Сначала занимаем путь сами, чтобы следующий процесс нашел уже нас
+    if (!HandoffListener_) {
+        try {
+            HandoffListener_ = std::make_unique<THandoffListener>(Config_->HandoffSocket);
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Socket handoff is disabled: {}", ex.what());
+        }
+    }
+    if (HandoffPeer_ != INVALID_SOCKET) {
+        try {
+            SendHandoffAck(HandoffPeer_);
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Previous process will keep serving: {}", ex.what());
+        }
+        HandoffPeer_ = INVALID_SOCKET;
+    }
+    if (HandoffListener_) {
+        HandoffThread_ = std::thread(&THttpServer::RunHandoff, this);
+    }
+}
 
-    SOCKET clientSocket = accept(Socket_, NULL, NULL);
-    if (clientSocket == INVALID_SOCKET) {
-        LOG_ERROR("Error accepting client: {}", ErrorCode());
-        CloseSocket(clientSocket);
+void THttpServer::Stop() {
+    if (Reactors_.empty() || !Reactors_.front()->Thread.joinable()) {
         return;
     }
+    Stopping_ = true;
+    for (const auto& reactor : Reactors_) {
+        Wakeup(*reactor);
+    }
+    for (const auto& reactor : Reactors_) {
+        reactor->Thread.join();
+    }
+    if (HandoffThread_.joinable()) {
+        HandoffThread_.join();
+    }
+}
 
-    if (Poll(clientSocket) <= 0) {
-        CloseSocket(clientSocket);
+void THttpServer::Drain(std::chrono::milliseconds timeout) {
+    if (Reactors_.empty() || !Reactors_.front()->Thread.joinable()) {
         return;
     }
+    LOG_INFO("Draining: no new connections, waiting for in-flight requests");
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    Draining_ = true;
+    for (const auto& reactor : Reactors_) {
+        Wakeup(*reactor);
+    }
+
+    auto waitFor = [&] (auto&& done) {
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(DrainPollPeriod);
+        }
+        return done();
+    };
+
+    // Закрыть слушающие сокеты можно, только когда реакторы убрали их из epoll
+    bool detached = waitFor([&] {
+        return std::all_of(Reactors_.begin(), Reactors_.end(), [] (const auto& reactor) {
+            return reactor->ListenerDetached.load();
+        });
+    });
+    if (detached) {
+        CloseSocket();
+        for (auto listener : ExtraListeners_) {
+            CloseSocket(listener);
+        }
+        ExtraListeners_.clear();
+    }
+
+    bool drained = waitFor([&] {
+        return std::all_of(Reactors_.begin(), Reactors_.end(), [] (const auto& reactor) {
+            return reactor->ConnectionCount.load() == 0;
+        });
+    });
+    if (!drained) {
+        LOG_WARNING("Drain timeout expired, closing remaining connections");
+    }
+
+    Stop();
+}
+
+void THttpServer::Drain() {
+    Drain(Config_->DrainTimeout);
+}
+
+void THttpServer::RequestDrain() {
+    uint64_t value = 1;
+    // Только write: вызывается из обработчика сигнала
+    [[maybe_unused]] auto result = write(DrainRequestFd_, &value, sizeof(value));
+}
+
+void THttpServer::WaitDrainRequest() {
+    uint64_t value;
+    while (read(DrainRequestFd_, &value, sizeof(value)) < 0 && errno == EINTR) {}
+}
+
+void THttpServer::RunHandoff() {
+    while (!Stopping_ && !Draining_) {
+        SOCKET peer = HandoffListener_->Accept(HandoffPollPeriod);
+        if (peer == INVALID_SOCKET) {
+            continue;
+        }
+
+        std::vector<SOCKET> listeners = {Socket_};
+        listeners.insert(listeners.end(), ExtraListeners_.begin(), ExtraListeners_.end());
+        bool handedOff = false;
+        try {
+            SendListeners(peer, listeners);
+            LOG_INFO("Listening sockets sent to the new process, waiting for it to start");
+            handedOff = WaitHandoffAck(peer, Stopping_);
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Socket handoff failed: {}", ex.what());
+        }
+        close(peer);
+
+        if (handedOff) {
+            LOG_INFO("New process accepts connections, draining");
+            RequestDrain();
+            return;
+        }
+        LOG_WARNING("New process did not take over, keep serving");
+    }
+}
+
+void THttpServer::BeginDrain(TReactor& reactor) {
+    reactor.DrainStarted = true;
+
+    // Уже пришедшие в очередь соединения обслужим, новые пусть идут к другому процессу
+    AcceptClients(reactor);
+    epoll_ctl(reactor.EpollFd, EPOLL_CTL_DEL, reactor.Listener, nullptr);
+    // Номер сокета может достаться новому соединению после закрытия в Drain
+    reactor.Listener = INVALID_SOCKET;
+    reactor.ListenerDetached = true;
+
+    std::vector<TConnectionPtr> idle;
+    for (const auto& [_, connection] : reactor.Connections) {
+        if (!connection->InFlight && connection->Output.empty() && connection->Input.empty()) {
+            idle.push_back(connection);
+        }
+    }
+    for (const auto& connection : idle) {
+        CloseClient(connection);
+    }
+}
+
+std::vector<TReactorStats> THttpServer::GetReactorStats() const {
+    std::vector<TReactorStats> result;
+    for (const auto& reactor : Reactors_) {
+        result.push_back({
+            .Connections = reactor->ConnectionCount.load(std::memory_order_relaxed),
+            .Accepted = reactor->Accepted.load(std::memory_order_relaxed),
+        });
+    }
+    return result;
+}
+
+void THttpServer::Wakeup(TReactor& reactor) {
+    uint64_t value = 1;
+    if (write(reactor.WakeupFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("Failed to wake up event loop: {}", ErrorCode());
+    }
+}
+
+void THttpServer::RunLoop(TReactor& reactor) {
+    epoll_event events[MaxEpollEvents];
+    auto waitTimeout = std::min<std::chrono::milliseconds>(IdleCheckPeriod, Config_->KeepAliveTimeout);
+    auto lastIdleCheck = std::chrono::steady_clock::now();
 
-    std::stringstream recivedString;
+    // Соединения, пришедшие до перезапуска, нового фронта для epoll не дадут
+    AcceptClients(reactor);
 
-    int bufSize = sizeof(InputBuf_) - 1;
+    while (!Stopping_) {
+        if (Draining_ && !reactor.DrainStarted) {
+            BeginDrain(reactor);
+        }
+
+        // Просыпаемся не позже, чем истечет срок первого ожидающего слота запроса
+        auto timeout = waitTimeout;
+        if (auto deadline = Admission_->GetNextDeadline()) {
+            auto untilDeadline = std::chrono::ceil<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+            timeout = std::clamp(untilDeadline, std::chrono::milliseconds(0), timeout);
+        }
 
-    int result = -1;
-    do {
-        result = recv(clientSocket, InputBuf_, bufSize, 0);
-        if (result < 0) {
+        int count = epoll_wait(reactor.EpollFd, events, MaxEpollEvents, std::max<int>(timeout.count(), 1));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("epoll_wait failed: {}", ErrorCode());
             break;
         }
-        InputBuf_[result] = '\0';
-        recivedString << InputBuf_;
-    } while (result >= bufSize);
 
-    if (result == SOCKET_ERROR || result < 0) {
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t flags = events[i].events;
+
+            if (fd == reactor.Listener) {
+                AcceptClients(reactor);
+                continue;
+            }
+            if (fd == reactor.WakeupFd) {
+                uint64_t value;
+                while (read(reactor.WakeupFd, &value, sizeof(value)) > 0) {}
+                CompleteResponses(reactor);
+                continue;
+            }
+
+            auto it = reactor.Connections.find(fd);
+            if (it == reactor.Connections.end()) {
+                continue;
+            }
+            // Копия: соединение может быть удалено из таблицы по ходу обработки
+            auto connection = it->second;
+
+            if (flags & (EPOLLERR | EPOLLHUP)) {
+                CloseClient(connection);
+                continue;
+            }
+            if (flags & (EPOLLIN | EPOLLRDHUP)) {
+                ReadClient(connection);
+            }
+            if (!connection->Closed && (flags & EPOLLOUT)) {
+                WriteClient(connection);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        Admission_->ExpireQueued(now);
+        if (now - lastIdleCheck >= waitTimeout) {
+            lastIdleCheck = now;
+            CloseIdleClients(reactor);
+        }
+    }
+
+    // Через CloseClient, чтобы потоковые обработчики, ждущие места в
+    // очереди вывода, проснулись и не держали пул при остановке
+    std::vector<TConnectionPtr> connections;
+    for (const auto& [_, connection] : reactor.Connections) {
+        connections.push_back(connection);
+    }
+    for (const auto& connection : connections) {
+        CloseClient(connection);
+    }
+}
+
+void THttpServer::AcceptClients(TReactor& reactor) {
+    while (true) {
+        SOCKET clientSocket = accept4(reactor.Listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientSocket == INVALID_SOCKET) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            LOG_ERROR("Error accepting client: {}", ErrorCode());
+            return;
+        }
+
+        // Ответы на конвейерные запросы уходят мелкими порциями подряд,
+        // с алгоритмом Нейгла каждая ждала бы отложенного ACK клиента
+        int noDelay = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        auto connection = std::make_shared<TConnection>();
+        connection->Socket = clientSocket;
+        connection->Reactor = &reactor;
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = clientSocket;
+        if (epoll_ctl(reactor.EpollFd, EPOLL_CTL_ADD, clientSocket, &event) != 0) {
+            LOG_ERROR("Failed to register client in epoll: {}", ErrorCode());
+            CloseSocket(clientSocket);
+            continue;
+        }
+        reactor.Connections[clientSocket] = std::move(connection);
+        reactor.ConnectionCount.store(reactor.Connections.size(), std::memory_order_relaxed);
+        reactor.Accepted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void THttpServer::ReadClient(const TConnectionPtr& connection) {
+    char buffer[ReadChunkSize];
+
+    // Edge-triggered: читаем, пока сокет не опустеет. Пока запрос обрабатывается,
+    // следующие только копятся в Input, поэтому их объем ограничен, иначе один
+    // клиент раздует память сервера. Без запроса в работе буфер ограничен
+    // размером одного запроса
+    while (true) {
+        bool busy = connection->InFlight || !connection->Output.empty();
+        if (connection->Input.size() > (busy ? Config_->MaxPipelinedInput : MaxRequestSize)) {
+            connection->ReadPaused = true;
+            break;
+        }
+
+        auto result = recv(connection->Socket, buffer, sizeof(buffer), 0);
+        if (result > 0) {
+            connection->Input.append(buffer, result);
+            connection->LastActivity = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (result == 0) {
+            connection->PeerClosed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
         LOG_ERROR("Error on client receive: {}", ErrorCode());
-        CloseSocket(clientSocket);
+        CloseClient(connection);
         return;
     }
-    else if (result == 0) {
-        LOG_ERROR("Client closed connection before getting any data!");
-        CloseSocket(clientSocket);
+
+    DispatchNext(connection);
+}
+
+void THttpServer::DispatchNext(const TConnectionPtr& connection) {
+    if (connection->Closed || connection->InFlight || !connection->Output.empty()) {
         return;
     }
 
-    auto request = TRequest(recivedString.str());
+    bool complete = false;
+    try {
+        complete = connection->Parser.Parse(connection->Input);
+        // Чтение остановлено, а запрос не дочитан: держать его целиком в памяти не будем
+        if (!complete && connection->ReadPaused) {
+            throw THttpException(EHttpCode::BadRequest, "Request does not fit into {} bytes", connection->Input.size());
+        }
+    } catch (const THttpException& ex) {
+        LOG_ERROR("Malformed request: {}", ex.what());
+        // Границу следующего запроса уже не найти, соединение закрываем
+        connection->Input.clear();
+        connection->Output.push_back(THandlerBase().FormatResponse(TResponse()
+            .SetStatus(ex.HttpCode())
+            .SetHeader("Connection", "close")
+            .SetRaw("")));
+        connection->ResponseFinished = true;
+        connection->CloseAfterWrite = true;
+        WriteClient(connection);
+        return;
+    }
 
-    LOG_DEBUG("Request: {}", recivedString.str());
+    if (complete) {
+        auto layout = connection->Parser.ReleaseLayout();
+        connection->Parser.Reset();
 
-    int index = -1;
-    for (uint64_t i = 0; i < Handlers_.size(); ++i) {
-        if (request.CheckResponse(Handlers_[i])) {
-            index = i;
-            break;
+        // Обычно в буфере ровно один запрос, тогда забираем буфер без копирования
+        std::string data;
+        if (layout.Size == connection->Input.size()) {
+            data = std::move(connection->Input);
+            connection->Input.clear();
+        } else {
+            data = connection->Input.substr(0, layout.Size);
+            connection->Input.erase(0, layout.Size);
         }
+
+        ++connection->RequestCount;
+        bool allowKeepAlive = !connection->PeerClosed && !Draining_ && connection->RequestCount < Config_->MaxKeepAliveRequests;
+
+        // Маршрут нужен уже здесь: по нему решается, сколько запросов пускать в пул
+        TRequest request(std::move(data), std::move(layout));
+        size_t route = TAdmissionController::NoRoute;
+        if (auto match = Router_.Match(request.GetMethod(), request.GetURL())) {
+            route = match->Route;
+            for (const auto& param : match->Params) {
+                request.SetPathParam(param.Name, param.Value);
+            }
+        }
+        bool keepAlive = allowKeepAlive && IsKeepAliveRequested(request);
+
+        connection->InFlight = true;
+        auto run = [this, connection, request = std::move(request), route, allowKeepAlive] () mutable {
+            Workers_->enqueue([this, connection, request = std::move(request), route, allowKeepAlive] () mutable {
+                try {
+                    HandleRequest(connection, request, route, allowKeepAlive);
+                } catch (const std::exception& ex) {
+                    LOG_ERROR("Failed to handle request: {}", ex.what());
+                    PostResponse({
+                        .Connection = connection,
+                        .Segments = {THandlerBase().FormatResponse(TResponse()
+                            .SetStatus(EHttpCode::InternalError)
+                            .SetHeader("Connection", "close")
+                            .SetRaw(""))},
+                        .Last = true,
+                        .KeepAlive = false,
+                    });
+                }
+                Admission_->Release(route);
+            });
+        };
+        Admission_->Submit(route, std::move(run), [this, connection, keepAlive] {
+            RejectRequest(connection, keepAlive);
+        });
+        return;
     }
 
-    std::string response;
-    if (index != -1) {
-        if (Handlers_[index].IsRaw()) {
-            response = Handlers_[index].GetResponse(request).Body;
+    if (connection->PeerClosed) {
+        if (connection->Input.empty()) {
+            LOG_DEBUG("Client closed connection");
         } else {
-            response = Handlers_[index].GetAnswer(request);
+            LOG_ERROR("Client closed connection before sending a complete request");
         }
-    } else {
-        response = NotFoundHandler_.GetAnswer(request);
+        CloseClient(connection);
     }
+}
 
-    LOG_DEBUG("Request: {}; Response: {}", recivedString.str(), response);
+void THttpServer::WriteClient(const TConnectionPtr& connection) {
+    while (!connection->Output.empty()) {
+        iovec segments[MaxWriteSegments];
+        size_t count = 0;
+        for (auto it = connection->Output.begin(); it != connection->Output.end() && count < MaxWriteSegments; ++it, ++count) {
+            size_t offset = count == 0 ? connection->OutputOffset : 0;
+            segments[count].iov_base = it->data() + offset;
+            segments[count].iov_len = it->size() - offset;
+        }
 
-    result = send(clientSocket, response.c_str(), (int)response.length(), 0);
-    if (result == SOCKET_ERROR) {
+        // writev, но с MSG_NOSIGNAL
+        msghdr message{};
+        message.msg_iov = segments;
+        message.msg_iovlen = count;
+        auto result = sendmsg(connection->Socket, &message, MSG_NOSIGNAL);
+        if (result >= 0) {
+            size_t sent = result;
+            {
+                auto guard = std::lock_guard(connection->OutputMutex);
+                connection->QueuedBytes -= std::min(connection->QueuedBytes, sent);
+            }
+            connection->OutputSpace.notify_all();
+
+            while (sent > 0) {
+                auto left = connection->Output.front().size() - connection->OutputOffset;
+                if (sent < left) {
+                    connection->OutputOffset += sent;
+                    break;
+                }
+                sent -= left;
+                connection->Output.pop_front();
+                connection->OutputOffset = 0;
+            }
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // Допишем по EPOLLOUT
+            return;
+        }
         LOG_ERROR("Failed to send responce to client: {}", ErrorCode());
+        CloseClient(connection);
+        return;
+    }
+
+    // Потоковый ответ еще пишется или ответа не было
+    if (!connection->ResponseFinished) {
+        return;
+    }
+
+    connection->ResponseFinished = false;
+    connection->LastActivity = std::chrono::steady_clock::now();
+
+    // При Drain постоянное соединение закрывается, как только на нем нечего обрабатывать
+    if (connection->CloseAfterWrite || (Draining_ && connection->Input.empty())) {
+        CloseClient(connection);
+        return;
+    }
+    // Остаток сокета сигнала от epoll уже не даст, дочитываем сами
+    if (connection->ReadPaused) {
+        connection->ReadPaused = false;
+        ReadClient(connection);
+        return;
+    }
+    // Следующий запрос мог прийти вместе с текущим
+    DispatchNext(connection);
+}
+
+void THttpServer::CloseClient(const TConnectionPtr& connection) {
+    if (connection->Closed) {
+        return;
+    }
+    connection->Closed = true;
+    {
+        auto guard = std::lock_guard(connection->OutputMutex);
+        connection->Aborted = true;
     }
+    connection->OutputSpace.notify_all();
+    epoll_ctl(connection->Reactor->EpollFd, EPOLL_CTL_DEL, connection->Socket, nullptr);
+    connection->Reactor->Connections.erase(connection->Socket);
+    connection->Reactor->ConnectionCount.store(connection->Reactor->Connections.size(), std::memory_order_relaxed);
+    CloseSocket(connection->Socket);
+}
+
+void THttpServer::CloseIdleClients(TReactor& reactor) {
+    auto deadline = std::chrono::steady_clock::now() - Config_->KeepAliveTimeout;
+
+    std::vector<TConnectionPtr> idle;
+    for (const auto& [_, connection] : reactor.Connections) {
+        if (!connection->InFlight && connection->Output.empty() && connection->LastActivity < deadline) {
+            idle.push_back(connection);
+        }
+    }
+
+    for (const auto& connection : idle) {
+        LOG_DEBUG("Closing idle connection after {} requests", connection->RequestCount);
+        CloseClient(connection);
+    }
+}
+
+void THttpServer::CompleteResponses(TReactor& reactor) {
+    std::vector<TResponsePart> completed;
+    {
+        auto guard = std::lock_guard(reactor.CompletedMutex);
+        completed.swap(reactor.Completed);
+    }
+
+    for (auto& part : completed) {
+        const auto& connection = part.Connection;
+        if (part.Last) {
+            connection->InFlight = false;
+        }
+        if (connection->Closed) {
+            continue;
+        }
+        for (auto& segment : part.Segments) {
+            if (!segment.empty()) {
+                connection->Output.push_back(std::move(segment));
+            }
+        }
+        if (part.Last) {
+            connection->ResponseFinished = true;
+            connection->CloseAfterWrite = !part.KeepAlive;
+        }
+        WriteClient(connection);
+    }
+}
+
+void THttpServer::PostResponse(TResponsePart part) {
+    size_t size = 0;
+    for (const auto& segment : part.Segments) {
+        size += segment.size();
+    }
+    {
+        auto guard = std::lock_guard(part.Connection->OutputMutex);
+        part.Connection->QueuedBytes += size;
+    }
+    auto& reactor = *part.Connection->Reactor;
+    {
+        auto guard = std::lock_guard(reactor.CompletedMutex);
+        reactor.Completed.push_back(std::move(part));
+    }
+    Wakeup(reactor);
+}
+
+void THttpServer::WaitOutputSpace(const TConnectionPtr& connection) {
+    auto lock = std::unique_lock(connection->OutputMutex);
+    connection->OutputSpace.wait(lock, [&] {
+        return connection->Aborted || connection->QueuedBytes < Config_->MaxPendingOutput;
+    });
+    if (connection->Aborted) {
+        THROW("Connection closed while streaming response");
+    }
+}
+
+void THttpServer::RejectRequest(const TConnectionPtr& connection, bool keepAlive) {
+    LOG_WARNING("Request rejected by admission control");
+    PostResponse({
+        .Connection = connection,
+        .Segments = {THandlerBase().FormatResponse(TResponse()
+            .SetStatus(EHttpCode::ServiceUnavailable)
+            .SetHeader("Retry-After", "1")
+            .SetHeader("Connection", keepAlive ? "keep-alive" : "close")
+            .SetRaw(""))},
+        .Last = true,
+        .KeepAlive = keepAlive,
+    });
+}
+
+void THttpServer::HandleRequest(const TConnectionPtr& connection, TRequest& request, size_t route, bool allowKeepAlive) {
+    LOG_DEBUG("Request: {} {}", request.GetMethod(), request.GetURL());
+
+    int index = route != TAdmissionController::NoRoute ? static_cast<int>(route) : -1;
+
+    // Сырой обработчик сам формирует ответ целиком, его границу не знаем
+    if (index != -1 && Handlers_[index].IsRaw()) {
+        auto response = Handlers_[index].GetResponse(request).Body;
+        LOG_DEBUG("Request: {} {}; Response: {}", request.GetMethod(), request.GetURL(), response);
+        PostResponse({.Connection = connection, .Segments = {std::move(response)}, .Last = true, .KeepAlive = false});
+        return;
+    }
+
+    auto response = index != -1
+        ? Handlers_[index].GetResponse(request)
+        : NotFoundHandler_.GetResponse(request);
+    const THandlerBase& formatter = index != -1
+        ? static_cast<const THandlerBase&>(Handlers_[index])
+        : static_cast<const THandlerBase&>(NotFoundHandler_);
+
+    // Drain мог начаться, пока выполнялся обработчик
+    bool keepAlive = allowKeepAlive && !Draining_ && IsKeepAliveRequested(request);
+    response.Headers["Connection"] = keepAlive ? "keep-alive" : "close";
+
+    auto compression = ChooseCompression(request, response);
+    if (compression != ECompression::None) {
+        response.Headers["Content-Encoding"] = GetContentEncoding(compression);
+        response.Headers["Vary"] = "Accept-Encoding";
+    }
+
+    if (response.BodyWriter) {
+        response.Headers.erase("Content-Length");
+        response.Headers["Transfer-Encoding"] = "chunked";
+        PostResponse({.Connection = connection, .Segments = {formatter.FormatHead(response)}, .Last = false, .KeepAlive = false});
+
+        TResponseWriter writer([&] (std::vector<std::string> segments) {
+            WaitOutputSpace(connection);
+            PostResponse({.Connection = connection, .Segments = std::move(segments), .Last = false, .KeepAlive = false});
+        }, Config_->StreamChunkSize);
+        if (compression != ECompression::None) {
+            writer.SetCompressor(CreateStreamCompressor(compression, GetCompressionLevel(compression)));
+        }
+
+        try {
+            response.BodyWriter(writer);
+            writer.Finish();
+        } catch (const std::exception& ex) {
+            // Статус уже отправлен, оборванный chunked ответ скажет клиенту об ошибке
+            LOG_ERROR("Failed to stream response for {} {}: {}", request.GetMethod(), request.GetURL(), ex.what());
+            PostResponse({.Connection = connection, .Segments = {}, .Last = true, .KeepAlive = false});
+            return;
+        }
+
+        LOG_DEBUG("Request: {} {}; Streamed {} bytes", request.GetMethod(), request.GetURL(), writer.ByteCount());
+        PostResponse({.Connection = connection, .Segments = {std::string(LastChunk)}, .Last = true, .KeepAlive = keepAlive});
+        return;
+    }
+
+    if (compression != ECompression::None) {
+        response.Body = Compress(compression, response.Body, GetCompressionLevel(compression));
+        response.Headers["Content-Length"] = std::to_string(response.Body.size());
+    }
+
+    // Без Content-Length клиент не найдет конец ответа на постоянном соединении
+    if (!response.Headers.contains("Content-Length")) {
+        response.Headers["Content-Length"] = std::to_string(response.Body.size());
+    }
+
+    auto head = formatter.FormatHead(response);
+    LOG_DEBUG("Request: {} {}; Response: {}{}", request.GetMethod(), request.GetURL(), head, response.Body);
+    // Тело уходит отдельным сегментом, без склейки с заголовками
+    PostResponse({
+        .Connection = connection,
+        .Segments = {std::move(head), std::move(response.Body)},
+        .Last = true,
+        .KeepAlive = keepAlive,
+    });
+}
+
+ECompression THttpServer::ChooseCompression(const TRequest& request, const TResponse& response) const {
+    if (!Config_->EnableCompression || response.Headers.contains("Content-Encoding")) {
+        return ECompression::None;
+    }
+    // Маленький ответ сжатие не уменьшит настолько, чтобы окупить заголовки кодека
+    if (!response.BodyWriter && response.Body.size() < Config_->CompressionMinSize) {
+        return ECompression::None;
+    }
+    if (response.HttpStatus == EHttpCode::NoContent || response.HttpStatus == EHttpCode::NotModified) {
+        return ECompression::None;
+    }
+    return NegotiateCompression(request.GetHeader("Accept-Encoding"));
+}
 
-    CloseSocket(clientSocket);
+int THttpServer::GetCompressionLevel(ECompression compression) const {
+    return compression == ECompression::Zstd ? Config_->ZstdLevel : Config_->GzipLevel;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
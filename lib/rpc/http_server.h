@@ -2,13 +2,28 @@
 
 #include <common/logging.h>
 #include <common/exception.h>
+#include <common/config.h>
 #include <common/periodic_executor.h>
+#include <common/threadpool.h>
 
+#include <rpc/admission.h>
+#include <rpc/http_parser.h>
+#include <rpc/http_router.h>
 #include <rpc/protobuf_format.h>
+#include <rpc/response_writer.h>
+#include <rpc/socket_handoff.h>
 
 #include <nlohmann/json.hpp>
 
+#include <atomic>
+#include <charconv>
+#include <concepts>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include <functional>
@@ -55,6 +70,7 @@ enum class EHttpCode {
     Timeout            = 408,
     Conflict           = 409,
     Gone               = 410,
+    UnsupportedMediaType = 415,
     
     InternalError      = 500,
     NotImplemented     = 501,
@@ -97,6 +113,8 @@ struct TResponse {
     EHttpCode HttpStatus;
     std::unordered_map<std::string, std::string> Headers;
     std::string Body;
+    // Тело неизвестного размера: пишется во время отправки и уходит chunked
+    std::function<void(TResponseWriter&)> BodyWriter;
 
     TResponse& SetStatus(EHttpCode httpStatus);
     TResponse& SetRaw(const std::string& data);
@@ -105,6 +123,7 @@ struct TResponse {
     TResponse& SetJson(const nlohmann::json& data);
     TResponse& SetText(const std::string& data);
     TResponse& SetHtml(const std::filesystem::path& path);
+    TResponse& SetStream(std::function<void(TResponseWriter&)> bodyWriter);
 
     template <typename Asset>
     TResponse& SetAsset(const Asset& asset) {
@@ -113,10 +132,11 @@ struct TResponse {
         return *this;
     }
 
+    // Сериализует сразу в Body, без промежуточной строки
     template <typename ProtoMessage>
     TResponse& SetProto(const ProtoMessage& message) {
-        std::string serialized;
-        if (!message.SerializeToString(&serialized)) {
+        Body.resize(message.ByteSizeLong());
+        if (!message.SerializeToArray(Body.data(), Body.size())) {
             throw TProtoException(
                 EProtoError::SerializationError,
                 "Failed to serialize protobuf message"
@@ -125,7 +145,6 @@ struct TResponse {
         
         HttpStatus = static_cast<EHttpCode>(message.status().code());
         Headers["Content-Type"] = "application/x-protobuf";
-        Body = serialized;
         Headers["Content-Length"] = std::to_string(Body.size());
         return *this;
     }
@@ -164,6 +183,8 @@ public:
 
     THandlerBase SetVersion(const std::string& version);
     THandlerBase SetContentType(const std::string& contentType);
+    // Строка статуса и заголовки, тело отправляется отдельным сегментом
+    std::string FormatHead(const TResponse& response) const;
     std::string FormatResponse(const TResponse& response) const;
 };
 
@@ -215,38 +236,64 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Запрос хранит свои байты целиком, методы возвращают view в этот буфер
 class TRequest {
-    std::string Method_;
-    std::string Url_;
+    struct TPathParam {
+        std::string Name;
+        TBufferSpan Value;
+    };
 
-    std::string Version_;
-    std::unordered_map<std::string, std::string> Headers_;
-    std::unordered_map<std::string, std::string> UrlArgs_;
-    std::string Body_;
+    std::string Data_;
+    THttpRequestLayout Layout_;
+    std::vector<TPathParam> PathParams_;
 
 public:
-    TRequest(const std::string& recieved_data);
-
-    template <typename Handler>
-    requires(CIsHandler<Handler>)
-    bool CheckResponse(const Handler& response) const {
-        return response.GetMethod() == GetMethod() && std::regex_match(GetURL(), std::regex(response.GetURL()));
+    // Разбирает запрос целиком, THttpException при ошибке формата или неполных данных
+    explicit TRequest(std::string data);
+    // Уже разобранный запрос, layout указывает внутрь data
+    TRequest(std::string data, THttpRequestLayout layout);
+
+    std::string_view GetMethod() const;
+    std::string_view GetURL() const;
+    std::string_view GetQuery() const;
+    std::string_view GetVersion() const;
+    // Имя сравнивается без учета регистра
+    std::string_view GetHeader(std::string_view key) const;
+    std::string_view GetBody() const;
+
+    // Параметр пути из шаблона маршрута, пустая строка если его нет
+    std::string_view GetPathParam(std::string_view name) const;
+
+    template <std::integral T>
+    T GetPathParam(std::string_view name) const {
+        auto text = GetPathParam(name);
+        T value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            throw THttpException(EHttpCode::BadRequest, "Invalid path parameter {}: {}", name, text);
+        }
+        return value;
     }
 
-    std::string GetMethod() const;
-    std::string GetURL() const;
-    std::string GetVersion() const;
-    std::string GetHeader(const std::string& key) const;
+    // value должен указывать внутрь пути этого запроса
+    void SetPathParam(std::string_view name, std::string_view value);
+
+    // Тело с учетом Content-Encoding: без сжатия view в буфер запроса,
+    // иначе распакованная копия в storage. THttpException с UnsupportedMediaType
+    // для неизвестного кодека и BadRequest для поврежденных данных
+    std::string_view GetDecodedBody(std::string* storage) const;
 
     template <typename ProtoMessage>
     bool ParseProtoBody(ProtoMessage* message) const {
         auto contentType = GetHeader("Content-Type");
         
         if (contentType == "application/x-protobuf" || contentType.empty()) {
-            if (Body_.empty()) {
+            std::string storage;
+            auto body = GetDecodedBody(&storage);
+            if (body.empty()) {
                 return false;
             }
-            return message->ParseFromString(Body_);
+            return message->ParseFromArray(body.data(), body.size());
         }
         
         return false;
@@ -272,28 +319,174 @@ protected:
     SOCKET Socket_;
 };
 
+struct THttpServerConfig
+    : public NCommon::TConfigBase
+{
+    // Сколько держать открытым соединение без запросов
+    std::chrono::milliseconds KeepAliveTimeout;
+    // После стольких запросов соединение закрывается, 0 отключает keep-alive
+    uint32_t MaxKeepAliveRequests;
+    // Размер куска для ответов с BodyWriter
+    size_t StreamChunkSize;
+    // Сколько неотправленных байт ответа может ждать в очереди соединения,
+    // дальше BodyWriter блокируется до отправки
+    size_t MaxPendingOutput;
+    // Сколько байт следующих запросов соединения читать вперед, пока текущий
+    // обрабатывается; дальше сокет не читается до отправки ответа
+    size_t MaxPipelinedInput;
+    // Сжимать ответы, если клиент согласен (Accept-Encoding)
+    bool EnableCompression;
+    // Ответы меньше этого размера не сжимаются, потоковые сжимаются всегда
+    size_t CompressionMinSize;
+    int GzipLevel;
+    int ZstdLevel;
+    // Одновременно обрабатываемых запросов, остальные ждут в очереди; 0 — без ограничения
+    size_t MaxInFlight;
+    // Длина очереди ожидающих слота, при переполнении запрос получает 503
+    size_t MaxQueuedRequests;
+    // Сколько запрос может ждать слота до ответа 503, 0 — без ограничения
+    std::chrono::milliseconds MaxQueueTime;
+    // Потоков цикла событий; у каждого свой слушающий сокет с SO_REUSEPORT
+    size_t ReactorCount;
+    // SO_REUSEPORT и для единственного слушающего сокета, чтобы рядом мог слушать другой процесс
+    bool ReusePort;
+    // Реактор i закрепляется за ядром ReactorCpus[i % size], пустой список — без закрепления
+    std::vector<int> ReactorCpus;
+    // Сколько Drain ждет завершения уже принятых запросов
+    std::chrono::milliseconds DrainTimeout;
+    // Unix сокет для передачи слушающих сокетов новому процессу, пусто — без передачи
+    std::string HandoffSocket;
+    // Сколько ждать сокеты от предыдущего процесса, потом открываем свои
+    std::chrono::milliseconds HandoffTimeout;
+
+    void Load(const nlohmann::json& data) override;
+};
+
+DECLARE_REFCOUNTED(THttpServerConfig);
+
+struct TReactorStats {
+    // Открытых соединений сейчас
+    size_t Connections = 0;
+    uint64_t Accepted = 0;
+};
+
+// HTTP сервер на epoll. Поток цикла событий (реактор) принимает соединения и
+// читает/пишет неблокирующие сокеты (edge-triggered), полностью прочитанные
+// запросы обрабатываются в пуле потоков. Число соединений не ограничено
+// числом рабочих потоков. Реакторов может быть несколько: каждый слушает свой
+// сокет с SO_REUSEPORT и обслуживает только принятые им соединения.
+// Соединения HTTP/1.1 по умолчанию постоянные. Запросы, пришедшие подряд
+// (pipelining), обрабатываются по одному, ответы уходят в порядке запросов.
 class THttpServer
     : public TSocketBase
 {
 public:
-    THttpServer(const std::string& interfaceIp, const short int port);
+    THttpServer(const std::string& interfaceIp, const short int port, THttpServerConfigPtr config = THttpServerConfigPtr());
+    ~THttpServer();
 
     void Listen(const std::string& interfaceIp, const short int port);
-    void ProcessClient();
+
+    // Запускает цикл событий, обработчики выполняются в workers.
+    // Если слушающие сокеты получены от предыдущего процесса, сообщает ему,
+    // что соединения принимаются, и он начинает Drain
+    void Start(NCommon::TThreadPoolPtr workers);
+    // Останавливает цикл событий и закрывает все соединения
+    void Stop();
+    // Перестает принимать соединения, закрывает простаивающие, дожидается
+    // ответов на уже принятые запросы не дольше timeout и вызывает Stop
+    void Drain(std::chrono::milliseconds timeout);
+    // Drain с drain_timeout_ms из конфига
+    void Drain();
+
+    // Просит WaitDrainRequest вернуться; можно вызывать из обработчика сигнала
+    void RequestDrain();
+    // Блокируется до RequestDrain или передачи сокетов новому процессу
+    void WaitDrainRequest();
 
     void SetNotFoundHandler(const TUnifiedHandler& handler);
 
     template <typename Handler>
     requires(CIsHandler<Handler>)
-    void RegisterHandler(const Handler& handler) {
+    void RegisterHandler(const Handler& handler, const TAdmissionPolicy& policy = {}) {
+        Router_.Add(handler.GetMethod(), handler.GetURL(), Handlers_.size());
+        Admission_->SetPolicy(Handlers_.size(), policy);
         Handlers_.emplace_back(handler);
     }
 
+    TAdmissionStats GetAdmissionStats() const;
+    // По одной записи на реактор, пусто до Start
+    std::vector<TReactorStats> GetReactorStats() const;
+
 private:
-    char InputBuf_[1024];
+    struct TConnection;
+    using TConnectionPtr = std::shared_ptr<TConnection>;
+    struct TReactor;
+
+    // Часть ответа, переданная из рабочего потока в цикл событий
+    struct TResponsePart {
+        TConnectionPtr Connection;
+        std::vector<std::string> Segments;
+        // Последняя часть ответа на запрос
+        bool Last = true;
+        bool KeepAlive = false;
+    };
+
+    SOCKET OpenListener(const std::string& interfaceIp, const short int port) const;
+    // Слушающие сокеты, полученные от предыдущего процесса; false, если его нет
+    bool ReceiveListeners();
+    // Отдает слушающие сокеты подключившемуся новому процессу
+    void RunHandoff();
+    // Выполняется в потоке реактора при начале Drain
+    void BeginDrain(TReactor& reactor);
+
+    void RunLoop(TReactor& reactor);
+    void Wakeup(TReactor& reactor);
+
+    void AcceptClients(TReactor& reactor);
+    void ReadClient(const TConnectionPtr& connection);
+    void WriteClient(const TConnectionPtr& connection);
+    void CloseClient(const TConnectionPtr& connection);
+    void CloseIdleClients(TReactor& reactor);
+
+    // Отправляет в пул следующий полностью прочитанный запрос, если предыдущий уже обработан
+    void DispatchNext(const TConnectionPtr& connection);
+    void CompleteResponses(TReactor& reactor);
+    // Выполняется в рабочем потоке, route — индекс в Handlers_ или NoRoute
+    void HandleRequest(const TConnectionPtr& connection, TRequest& request, size_t route, bool allowKeepAlive);
+    // Ответ 503 запросу, не дождавшемуся слота
+    void RejectRequest(const TConnectionPtr& connection, bool keepAlive);
+    // Кодек для ответа с учетом Accept-Encoding, размера и уже заданного Content-Encoding
+    ECompression ChooseCompression(const TRequest& request, const TResponse& response) const;
+    int GetCompressionLevel(ECompression compression) const;
+    // Вызывается из рабочих потоков
+    void PostResponse(TResponsePart part);
+    // Ждет, пока очередь соединения не освободится; бросает, если оно закрыто
+    void WaitOutputSpace(const TConnectionPtr& connection);
+
+    THttpServerConfigPtr Config_;
 
     std::vector<THandler> Handlers_;
+    // Индексы в Handlers_
+    THttpRouter Router_;
     TUnifiedHandler NotFoundHandler_;
+    std::unique_ptr<TAdmissionController> Admission_;
+
+    // Слушающие сокеты реакторов, кроме первого, который в Socket_
+    std::vector<SOCKET> ExtraListeners_;
+    // Живут до уничтожения сервера: на них ссылаются соединения в рабочих потоках
+    std::vector<std::unique_ptr<TReactor>> Reactors_;
+    std::atomic<bool> Stopping_ = false;
+    // Новые соединения не принимаются, постоянные закрываются после ответа
+    std::atomic<bool> Draining_ = false;
+    // eventfd для RequestDrain: запись в него безопасна в обработчике сигнала
+    int DrainRequestFd_ = -1;
+
+    // Соединение с предыдущим процессом, ждущим подтверждения в Start
+    SOCKET HandoffPeer_ = -1;
+    std::unique_ptr<THandoffListener> HandoffListener_;
+    std::thread HandoffThread_;
+
+    NCommon::TThreadPoolPtr Workers_;
 };
 
 }
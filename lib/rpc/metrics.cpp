@@ -0,0 +1,274 @@
+#include <rpc/metrics.h>
+
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+namespace NRpc {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Границы le в экспорте: степени двойки от ~1 мкс до ~34 с
+constexpr size_t MinExportPower = 10;
+constexpr size_t MaxExportPower = 35;
+
+constexpr std::array<std::string_view, 3> PhaseNames = {"parse", "handler", "write"};
+constexpr std::array<std::string_view, 6> ResponseClassNames = {"other", "1xx", "2xx", "3xx", "4xx", "5xx"};
+
+// Значение метки по правилам формата: экранируются \, " и перевод строки
+void AppendLabelValue(std::string_view value, std::string* output) {
+    for (char symbol : value) {
+        switch (symbol) {
+            case '\\': *output += "\\\\"; break;
+            case '"': *output += "\\\""; break;
+            case '\n': *output += "\\n"; break;
+            default: *output += symbol;
+        }
+    }
+}
+
+void AppendNumber(double value, std::string* output) {
+    char buffer[32];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    output->append(buffer, end);
+}
+
+void AppendNumber(uint64_t value, std::string* output) {
+    char buffer[24];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    output->append(buffer, end);
+}
+
+// Потоки раздаются по ячейкам по кругу при первой записи
+size_t GetShardIndex() {
+    static std::atomic<size_t> nextShard = 0;
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+void AppendLabels(const THandlerMetrics& metrics, std::string* output) {
+    *output += "method=\"";
+    AppendLabelValue(metrics.GetMethod(), output);
+    *output += "\",path=\"";
+    AppendLabelValue(metrics.GetPath(), output);
+    *output += '"';
+}
+
+void AppendSample(std::string_view name, std::string_view labels, uint64_t value, std::string* output) {
+    *output += name;
+    *output += '{';
+    *output += labels;
+    *output += "} ";
+    AppendNumber(value, output);
+    *output += '\n';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TLatencyHistogram::Record(std::chrono::nanoseconds duration) {
+    uint64_t value = std::max<int64_t>(duration.count(), 0);
+    Counts_[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+
+    auto& shard = Shards_[GetShardIndex() % Shards];
+    shard.Count.fetch_add(1, std::memory_order_relaxed);
+    shard.Sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t TLatencyHistogram::GetCount() const {
+    uint64_t result = 0;
+    for (const auto& shard : Shards_) {
+        result += shard.Count.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::chrono::nanoseconds TLatencyHistogram::GetSum() const {
+    uint64_t result = 0;
+    for (const auto& shard : Shards_) {
+        result += shard.Sum.load(std::memory_order_relaxed);
+    }
+    return std::chrono::nanoseconds(result);
+}
+
+std::chrono::nanoseconds TLatencyHistogram::GetQuantile(double q) const {
+    // Считаем по самим интервалам, GetCount мог уйти вперед при одновременной записи
+    uint64_t total = 0;
+    for (const auto& count : Counts_) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * total));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < Buckets; ++bucket) {
+        seen += Counts_[bucket].load(std::memory_order_relaxed);
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            return std::chrono::nanoseconds(GetBucketEnd(bucket));
+        }
+    }
+    return std::chrono::nanoseconds(GetBucketEnd(Buckets - 1));
+}
+
+uint64_t TLatencyHistogram::GetCountBelowPowerOfTwo(size_t power) const {
+    // Интервалы не пересекают степеней двойки, поэтому граница совпадает с началом интервала
+    auto end = power >= 64 ? Buckets : GetBucket(uint64_t(1) << power);
+    uint64_t result = 0;
+    for (size_t bucket = 0; bucket < end; ++bucket) {
+        result += Counts_[bucket].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+size_t TLatencyHistogram::GetBucket(uint64_t nanoseconds) {
+    if (nanoseconds < SubBuckets) {
+        return nanoseconds;
+    }
+    size_t shift = std::bit_width(nanoseconds) - 1 - SubBucketBits;
+    return (shift + 1) * SubBuckets + ((nanoseconds >> shift) & (SubBuckets - 1));
+}
+
+uint64_t TLatencyHistogram::GetBucketEnd(size_t bucket) {
+    if (bucket < SubBuckets) {
+        return bucket + 1;
+    }
+    size_t shift = bucket / SubBuckets - 1;
+    uint64_t start = (SubBuckets + bucket % SubBuckets) << shift;
+    uint64_t end = start + (uint64_t(1) << shift);
+    // Последний интервал доходит до конца диапазона uint64_t
+    return end > start ? end : std::numeric_limits<uint64_t>::max();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+THandlerMetrics::THandlerMetrics(std::string method, std::string path)
+    : Method_(std::move(method))
+    , Path_(std::move(path))
+{}
+
+void THandlerMetrics::Record(EHandlerPhase phase, TClock::duration duration) {
+    Histograms_[static_cast<size_t>(phase)].Record(duration);
+}
+
+void THandlerMetrics::CountResponse(int httpCode) {
+    int httpClass = httpCode / 100;
+    Responses_[httpClass >= 1 && httpClass <= 5 ? httpClass : 0].fetch_add(1, std::memory_order_relaxed);
+}
+
+const std::string& THandlerMetrics::GetMethod() const {
+    return Method_;
+}
+
+const std::string& THandlerMetrics::GetPath() const {
+    return Path_;
+}
+
+const TLatencyHistogram& THandlerMetrics::GetHistogram(EHandlerPhase phase) const {
+    return Histograms_[static_cast<size_t>(phase)];
+}
+
+uint64_t THandlerMetrics::GetResponseCount(int httpClass) const {
+    return Responses_[httpClass >= 1 && httpClass <= 5 ? httpClass : 0].load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+THandlerMetrics* TMetricsRegistry::Register(const std::string& method, const std::string& path) {
+    return &Handlers_.emplace_back(method, path);
+}
+
+std::string TMetricsRegistry::Format(const TAdmissionStats& admission, const std::vector<TReactorStats>& reactors) const {
+    std::string output;
+    output.reserve(4096 + Handlers_.size() * 2048);
+
+    output += "# HELP rpc_requests_total Responses by handler and status class.\n";
+    output += "# TYPE rpc_requests_total counter\n";
+    for (const auto& handler : Handlers_) {
+        for (size_t httpClass = 0; httpClass < ResponseClassNames.size(); ++httpClass) {
+            auto count = handler.GetResponseCount(httpClass);
+            if (count == 0) {
+                continue;
+            }
+            std::string labels;
+            AppendLabels(handler, &labels);
+            labels += ",code=\"";
+            labels += ResponseClassNames[httpClass];
+            labels += '"';
+            AppendSample("rpc_requests_total", labels, count, &output);
+        }
+    }
+
+    output += "# HELP rpc_handler_duration_seconds Time spent in request phases by handler.\n";
+    output += "# TYPE rpc_handler_duration_seconds histogram\n";
+    for (const auto& handler : Handlers_) {
+        for (size_t phase = 0; phase < PhaseNames.size(); ++phase) {
+            const auto& histogram = handler.GetHistogram(static_cast<EHandlerPhase>(phase));
+            // Сырые обработчики не разбирают тело и не сериализуют ответ
+            if (histogram.GetCount() == 0) {
+                continue;
+            }
+
+            std::string labels;
+            AppendLabels(handler, &labels);
+            labels += ",phase=\"";
+            labels += PhaseNames[phase];
+            labels += '"';
+
+            for (size_t power = MinExportPower; power <= MaxExportPower; ++power) {
+                std::string bucketLabels = labels;
+                bucketLabels += ",le=\"";
+                AppendNumber(std::ldexp(1e-9, power), &bucketLabels);
+                bucketLabels += '"';
+                AppendSample("rpc_handler_duration_seconds_bucket", bucketLabels, histogram.GetCountBelowPowerOfTwo(power), &output);
+            }
+            // Все три значения читаются отдельно, при одновременной записи
+            // +Inf может немного разойтись с последним интервалом
+            AppendSample("rpc_handler_duration_seconds_bucket", labels + ",le=\"+Inf\"", histogram.GetCount(), &output);
+
+            output += "rpc_handler_duration_seconds_sum{";
+            output += labels;
+            output += "} ";
+            AppendNumber(std::chrono::duration<double>(histogram.GetSum()).count(), &output);
+            output += '\n';
+            AppendSample("rpc_handler_duration_seconds_count", labels, histogram.GetCount(), &output);
+        }
+    }
+
+    output += "# HELP rpc_in_flight_requests Requests being handled now.\n";
+    output += "# TYPE rpc_in_flight_requests gauge\n";
+    output += "rpc_in_flight_requests " + std::to_string(admission.InFlight) + "\n";
+    output += "# HELP rpc_queued_requests Requests waiting for admission.\n";
+    output += "# TYPE rpc_queued_requests gauge\n";
+    output += "rpc_queued_requests " + std::to_string(admission.Queued) + "\n";
+    output += "# HELP rpc_admitted_requests_total Requests passed to handlers.\n";
+    output += "# TYPE rpc_admitted_requests_total counter\n";
+    output += "rpc_admitted_requests_total " + std::to_string(admission.Admitted) + "\n";
+    output += "# HELP rpc_rejected_requests_total Requests rejected by admission control.\n";
+    output += "# TYPE rpc_rejected_requests_total counter\n";
+    output += "rpc_rejected_requests_total " + std::to_string(admission.Rejected) + "\n";
+
+    // Перекос между реакторами виден по этим двум метрикам
+    output += "# HELP rpc_reactor_connections Open connections by reactor.\n";
+    output += "# TYPE rpc_reactor_connections gauge\n";
+    for (size_t i = 0; i < reactors.size(); ++i) {
+        AppendSample("rpc_reactor_connections", "reactor=\"" + std::to_string(i) + "\"", reactors[i].Connections, &output);
+    }
+    output += "# HELP rpc_reactor_accepted_total Accepted connections by reactor.\n";
+    output += "# TYPE rpc_reactor_accepted_total counter\n";
+    for (size_t i = 0; i < reactors.size(); ++i) {
+        AppendSample("rpc_reactor_accepted_total", "reactor=\"" + std::to_string(i) + "\"", reactors[i].Accepted, &output);
+    }
+    return output;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <rpc/admission.h>
+#include <rpc/http_server.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Гистограмма задержек в духе HDR: интервал [2^k, 2^(k+1)) наносекунд делится
+// на SubBuckets равных частей, так что относительная погрешность не больше
+// 1/SubBuckets на всем диапазоне. Запись — несколько relaxed инкрементов
+// без блокировок, читать можно одновременно с записью.
+class TLatencyHistogram {
+public:
+    static constexpr size_t SubBucketBits = 3;
+    static constexpr size_t SubBuckets = 1 << SubBucketBits;
+    static constexpr size_t Buckets = (64 - SubBucketBits + 1) * SubBuckets;
+
+    void Record(std::chrono::nanoseconds duration);
+
+    uint64_t GetCount() const;
+    std::chrono::nanoseconds GetSum() const;
+    // Верхняя граница интервала, в который попал квантиль q из [0, 1]
+    std::chrono::nanoseconds GetQuantile(double q) const;
+    // Записей меньше 2^power наносекунд
+    uint64_t GetCountBelowPowerOfTwo(size_t power) const;
+
+    static size_t GetBucket(uint64_t nanoseconds);
+    // Первое значение, не попадающее в bucket
+    static uint64_t GetBucketEnd(size_t bucket);
+
+private:
+    // Число и сумма меняются на каждой записи, общая строка кэша стала бы
+    // узким местом, поэтому у каждого потока своя ячейка из Shards
+    static constexpr size_t Shards = 8;
+
+    struct alignas(64) TShard {
+        std::atomic<uint64_t> Count = 0;
+        std::atomic<uint64_t> Sum = 0;
+    };
+
+    std::array<std::atomic<uint64_t>, Buckets> Counts_{};
+    std::array<TShard, Shards> Shards_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Этапы обработки запроса в обертках TRpcServerBase
+enum class EHandlerPhase {
+    // Разбор тела запроса
+    Parse,
+    Handler,
+    // Сериализация ответа
+    Write,
+};
+
+// Счетчики одного зарегистрированного обработчика
+class THandlerMetrics {
+public:
+    using TClock = std::chrono::steady_clock;
+
+    THandlerMetrics(std::string method, std::string path);
+
+    void Record(EHandlerPhase phase, TClock::duration duration);
+    void CountResponse(int httpCode);
+
+    const std::string& GetMethod() const;
+    const std::string& GetPath() const;
+    const TLatencyHistogram& GetHistogram(EHandlerPhase phase) const;
+    // Ответов с кодом вида Nxx
+    uint64_t GetResponseCount(int httpClass) const;
+
+private:
+    const std::string Method_;
+    const std::string Path_;
+    std::array<TLatencyHistogram, 3> Histograms_;
+    // По классу кода ответа 1xx..5xx, нулевой — для нестандартных кодов
+    std::array<std::atomic<uint64_t>, 6> Responses_{};
+};
+
+// Метрики всех обработчиков сервера в текстовом формате Prometheus.
+// Обработчики добавляются при регистрации, до старта сервера; указатели
+// на метрики не меняются до уничтожения реестра.
+class TMetricsRegistry {
+public:
+    THandlerMetrics* Register(const std::string& method, const std::string& path);
+
+    // Тело ответа /metrics
+    std::string Format(const TAdmissionStats& admission, const std::vector<TReactorStats>& reactors) const;
+
+private:
+    std::deque<THandlerMetrics> Handlers_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
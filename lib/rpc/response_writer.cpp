@@ -0,0 +1,103 @@
+#include <rpc/response_writer.h>
+
+#include <common/exception.h>
+
+#include <charconv>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+TResponseWriter::TResponseWriter(TSink sink, size_t chunkSize)
+    : Sink_(std::move(sink))
+    , ChunkSize_(chunkSize)
+{
+    ASSERT(ChunkSize_ > 0, "Chunk size must be positive");
+    Buffer_.reserve(ChunkSize_);
+}
+
+void TResponseWriter::Write(std::string_view data) {
+    while (!data.empty()) {
+        if (Buffer_.size() == ChunkSize_) {
+            Flush();
+        }
+        auto part = std::min(data.size(), ChunkSize_ - Buffer_.size());
+        Buffer_.append(data.substr(0, part));
+        ByteCount_ += part;
+        data.remove_prefix(part);
+    }
+}
+
+void TResponseWriter::SetCompressor(std::unique_ptr<TStreamCompressor> compressor) {
+    ASSERT(ByteCount_ == 0, "Compressor must be set before writing");
+    Compressor_ = std::move(compressor);
+}
+
+void TResponseWriter::Flush() {
+    if (Buffer_.empty()) {
+        return;
+    }
+
+    if (Compressor_) {
+        // Кодек может придержать данные до следующих кусков, тогда отправлять нечего
+        std::string compressed;
+        Compressor_->Write(Buffer_, &compressed);
+        Buffer_.clear();
+        if (!compressed.empty()) {
+            EmitChunk(std::move(compressed));
+        }
+        return;
+    }
+
+    EmitChunk(std::move(Buffer_));
+    Buffer_ = std::string();
+    Buffer_.reserve(ChunkSize_);
+}
+
+void TResponseWriter::Finish() {
+    Flush();
+    if (Compressor_) {
+        std::string tail;
+        Compressor_->Finish(&tail);
+        Compressor_.reset();
+        if (!tail.empty()) {
+            EmitChunk(std::move(tail));
+        }
+    }
+}
+
+void TResponseWriter::EmitChunk(std::string data) {
+    std::vector<std::string> segments;
+    segments.reserve(3);
+    char size[24];
+    auto end = std::to_chars(size, size + sizeof(size), data.size(), 16).ptr;
+    segments.push_back(std::string(size, end) + "\r\n");
+    segments.push_back(std::move(data));
+    segments.push_back("\r\n");
+    Sink_(std::move(segments));
+}
+
+bool TResponseWriter::Next(void** data, int* size) {
+    if (Buffer_.size() == ChunkSize_) {
+        Flush();
+    }
+    auto used = Buffer_.size();
+    Buffer_.resize(ChunkSize_);
+    *data = Buffer_.data() + used;
+    *size = static_cast<int>(ChunkSize_ - used);
+    ByteCount_ += *size;
+    return true;
+}
+
+void TResponseWriter::BackUp(int count) {
+    Buffer_.resize(Buffer_.size() - count);
+    ByteCount_ -= count;
+}
+
+int64_t TResponseWriter::ByteCount() const {
+    return ByteCount_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
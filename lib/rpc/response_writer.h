@@ -0,0 +1,71 @@
+#pragma once
+
+#include <rpc/compression.h>
+#include <rpc/protobuf_format.h>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Тело ответа, размер которого заранее неизвестен. Данные копятся в буфере
+// размером с кусок chunked, заполненный буфер уходит в sink без копирования
+// вместе с заголовком куска, сервер отправляет их одним writev.
+// Как ZeroCopyOutputStream позволяет сериализовать protobuf сразу в буферы
+// кусков, не собирая сообщение в отдельной строке.
+class TResponseWriter
+    : public google::protobuf::io::ZeroCopyOutputStream
+{
+public:
+    // Получает сегменты одного куска; может блокироваться, пока клиент не
+    // заберет уже отправленное, и бросать, если соединение закрыто
+    using TSink = std::function<void(std::vector<std::string> segments)>;
+
+    TResponseWriter(TSink sink, size_t chunkSize);
+
+    // Куски сжимаются перед отправкой; задается до первой записи
+    void SetCompressor(std::unique_ptr<TStreamCompressor> compressor);
+
+    void Write(std::string_view data);
+
+    template <typename ProtoMessage>
+    void WriteProto(const ProtoMessage& message) {
+        if (!message.SerializeToZeroCopyStream(this)) {
+            throw TProtoException(
+                EProtoError::SerializationError,
+                "Failed to serialize protobuf message"
+            );
+        }
+    }
+
+    // Отправляет накопленное отдельным куском
+    void Flush();
+    // Отправляет остаток и завершает поток сжатия, после него писать нельзя
+    void Finish();
+
+    bool Next(void** data, int* size) override;
+    void BackUp(int count) override;
+    int64_t ByteCount() const override;
+
+private:
+    void EmitChunk(std::string data);
+
+    TSink Sink_;
+    const size_t ChunkSize_;
+    std::unique_ptr<TStreamCompressor> Compressor_;
+
+    std::string Buffer_;
+    // Несжатых байт, как того требует ZeroCopyOutputStream
+    int64_t ByteCount_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
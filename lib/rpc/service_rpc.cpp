@@ -4,36 +4,49 @@ namespace NRpc {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-TRpcServerBase::TRpcServerBase(const std::string& interfaceIp, const short int port, size_t threadCount)
-    : HttpServer_(interfaceIp, port),
+TRpcServerBase::TRpcServerBase(const std::string& interfaceIp, const short int port, size_t threadCount, THttpServerConfigPtr httpConfig)
+    : HttpServer_(interfaceIp, port, std::move(httpConfig)),
       ThreadCount_(threadCount),
       ThreadPool_(NCommon::New<NCommon::TThreadPool>(ThreadCount_))
-{}
+{
+    // Регистрируется первым, поэтому обработчики сервиса не могут занять этот путь.
+    // Высокий приоритет, чтобы метрики были доступны и под нагрузкой
+    HttpServer_.RegisterHandler(THandler("GET", "/metrics", [this] (const TRequest&) {
+        return TResponse()
+            .SetStatus(EHttpCode::Ok)
+            .SetHeader("Content-Type", "text/plain; version=0.0.4")
+            .SetRaw(FormatMetrics());
+    }), {.Priority = EPriority::High});
+}
 
 void TRpcServerBase::Start() {
-    for (size_t iter = 0; iter < ThreadCount_; iter++) {
-        ThreadPool_->enqueue(NCommon::Bind(
-            &TRpcServerBase::Worker,
-            MakeWeak(this)
-        ));
-    }
-}
-
-void TRpcServerBase::Worker() {
-    auto job = NCommon::Bind(&TRpcServerBase::Job, MakeWeak(this));
-    while (true) {
-        try {
-            if (job()) {
-                break;
-            }
-        } catch (const std::exception& ex) {
-            LOG_ERROR("Error in worker: {}", ex.what());
-        }
-    }
-}
-
-void TRpcServerBase::Job() {
-    HttpServer_.ProcessClient();
+    HttpServer_.Start(ThreadPool_);
+}
+
+void TRpcServerBase::Stop() {
+    HttpServer_.Stop();
+}
+
+void TRpcServerBase::Serve() {
+    Start();
+    HttpServer_.WaitDrainRequest();
+    HttpServer_.Drain();
+}
+
+void TRpcServerBase::RequestDrain() {
+    HttpServer_.RequestDrain();
+}
+
+TAdmissionStats TRpcServerBase::GetAdmissionStats() const {
+    return HttpServer_.GetAdmissionStats();
+}
+
+std::vector<TReactorStats> TRpcServerBase::GetReactorStats() const {
+    return HttpServer_.GetReactorStats();
+}
+
+std::string TRpcServerBase::FormatMetrics() const {
+    return Metrics_.Format(GetAdmissionStats(), GetReactorStats());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <rpc/http_server.h>
+#include <rpc/metrics.h>
 
 #include <common/intrusive_ptr.h>
 #include <common/weak_ptr.h>
@@ -14,105 +15,62 @@ namespace NRpc {
 class TRpcServerBase
     : public NRefCounted::TRefCountedBase {
 public:
-    TRpcServerBase(const std::string& interfaceIp, const short int port, size_t threadCount);
+    // httpConfig задает и параметры приема соединений: число реакторов
+    // со своими SO_REUSEPORT сокетами и их закрепление за ядрами
+    TRpcServerBase(const std::string& interfaceIp, const short int port, size_t threadCount, THttpServerConfigPtr httpConfig = THttpServerConfigPtr());
 
+    // Запускает цикл событий HTTP сервера, запросы обрабатываются в пуле из threadCount потоков
     void Start();
+    void Stop();
+    // Start, затем ожидание RequestDrain или передачи сокетов новому процессу
+    // и Drain с таймаутом из конфига
+    void Serve();
+    // Безопасен в обработчике сигнала, например в TProgram::OnInterrupt
+    void RequestDrain();
+
+    TAdmissionStats GetAdmissionStats() const;
+    std::vector<TReactorStats> GetReactorStats() const;
+    // Метрики обработчиков в формате Prometheus, их же отдает GET /metrics
+    std::string FormatMetrics() const;
 
 protected:
+    // policy ограничивает одновременные запросы маршрута и задает их приоритет,
+    // чтобы тяжелые запросы не занимали все рабочие потоки
     template<typename HandlerFunc>
-    void RegisterHandler(const std::string& method, const std::string& url, HandlerFunc&& handler, bool isRaw = false) {
-        auto wrappedHandler = [handler = std::forward<HandlerFunc>(handler)](const NRpc::TRequest& req) {
-            try {
-                return handler(req);
-            } catch (const NRpc::THttpException& ex) {
-                return NRpc::TResponse()
-                    .SetStatus(ex.HttpCode())
-                    .SetJson(ex.what());
-            } catch (const std::exception& ex) {
-                LOG_ERROR("Handler error for {} {}: {}", req.GetMethod(), req.GetURL(), ex.what());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::InternalError)
-                    .SetText("Internal Server Error");
-            } catch (...) {
-                LOG_ERROR("Unknown error in handler for {} {}", req.GetMethod(), req.GetURL());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::InternalError)
-                    .SetText("Internal Server Error");
-            }
+    void RegisterHandler(const std::string& method, const std::string& url, HandlerFunc&& handler, bool isRaw = false, const TAdmissionPolicy& policy = {}) {
+        auto* metrics = Metrics_.Register(method, url);
+        auto wrappedHandler = [handler = std::forward<HandlerFunc>(handler), metrics](const NRpc::TRequest& req) {
+            auto start = THandlerMetrics::TClock::now();
+            auto response = CallHandler(handler, req);
+            metrics->Record(EHandlerPhase::Handler, THandlerMetrics::TClock::now() - start);
+            metrics->CountResponse(static_cast<int>(response.HttpStatus));
+            return response;
         };
         
-        HttpServer_.RegisterHandler(NRpc::THandler(method, url, wrappedHandler, isRaw));
+        HttpServer_.RegisterHandler(NRpc::THandler(method, url, wrappedHandler, isRaw), policy);
     }
 
     template<typename ProtoRequestType, typename ProtoResponseType, typename HandlerFunc>
-    void RegisterProtoHandler(const std::string& method, const std::string& url, HandlerFunc&& handler) {
-        auto wrappedHandler = [handler = std::forward<HandlerFunc>(handler)](const NRpc::TRequest& req) {
-            try {
-                ProtoRequestType protoRequest;
-                if (!req.ParseProtoBody(&protoRequest)) {
-                    return NRpc::TResponse()
-                        .SetStatus(NRpc::EHttpCode::BadRequest)
-                        .SetText("Failed to parse protobuf request");
-                }
-                
-                ProtoResponseType protoResponse;
-                handler(protoRequest, protoResponse);
-                
-                return NRpc::TResponse().SetProto(protoResponse);
-            } catch (const NRpc::THttpException& ex) {
-                return NRpc::TResponse()
-                    .SetStatus(ex.HttpCode())
-                    .SetText(ex.what());
-            } catch (const NRpc::TProtoException& ex) {
-                LOG_ERROR("Proto handling error: {}", ex.what());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::BadRequest)
-                    .SetText(ex.what());
-            } catch (const std::exception& ex) {
-                LOG_ERROR("Handler error for {} {}: {}", req.GetMethod(), req.GetURL(), ex.what());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::InternalError)
-                    .SetText("Internal Server Error");
-            } catch (...) {
-                LOG_ERROR("Unknown error in handler for {} {}", req.GetMethod(), req.GetURL());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::InternalError)
-                    .SetText("Internal Server Error");
-            }
+    void RegisterProtoHandler(const std::string& method, const std::string& url, HandlerFunc&& handler, const TAdmissionPolicy& policy = {}) {
+        auto* metrics = Metrics_.Register(method, url);
+        auto wrappedHandler = [handler = std::forward<HandlerFunc>(handler), metrics](const NRpc::TRequest& req) {
+            auto response = CallProtoHandler<ProtoRequestType, ProtoResponseType>(handler, req, metrics);
+            metrics->CountResponse(static_cast<int>(response.HttpStatus));
+            return response;
         };
         
-        HttpServer_.RegisterHandler(NRpc::THandler(method, url, wrappedHandler, false));
+        HttpServer_.RegisterHandler(NRpc::THandler(method, url, wrappedHandler, false), policy);
     }
 
     template<typename HandlerFunc>
     void RegisterNotFoundHandler(HandlerFunc&& handler) {
         auto wrappedHandler = [handler = std::forward<HandlerFunc>(handler)](const NRpc::TRequest& req) {
-            try {
-                return handler(req);
-            } catch (const NRpc::THttpException& ex) {
-                return NRpc::TResponse()
-                    .SetStatus(ex.HttpCode())
-                    .SetJson(ex.what());
-            } catch (const std::exception& ex) {
-                LOG_ERROR("Handler error for {} {}: {}", req.GetMethod(), req.GetURL(), ex.what());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::InternalError)
-                    .SetText("Internal Server Error");
-            } catch (...) {
-                LOG_ERROR("Unknown error in handler for {} {}", req.GetMethod(), req.GetURL());
-                return NRpc::TResponse()
-                    .SetStatus(NRpc::EHttpCode::InternalError)
-                    .SetText("Internal Server Error");
-            }
+            return CallHandler(handler, req);
         };
         
         HttpServer_.SetNotFoundHandler(NRpc::TUnifiedHandler(wrappedHandler));
     }
 
-    void Worker();
-
-    void Job();
-
     NRpc::THttpServer HttpServer_;
 
     size_t ThreadCount_;
@@ -120,6 +78,74 @@ protected:
 
     inline static const std::string LoggingSource = "Rpc";
 
+private:
+    template<typename HandlerFunc>
+    static NRpc::TResponse CallHandler(HandlerFunc& handler, const NRpc::TRequest& req) {
+        try {
+            return handler(req);
+        } catch (const NRpc::THttpException& ex) {
+            return NRpc::TResponse()
+                .SetStatus(ex.HttpCode())
+                .SetJson(ex.what());
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Handler error for {} {}: {}", req.GetMethod(), req.GetURL(), ex.what());
+            return NRpc::TResponse()
+                .SetStatus(NRpc::EHttpCode::InternalError)
+                .SetText("Internal Server Error");
+        } catch (...) {
+            LOG_ERROR("Unknown error in handler for {} {}", req.GetMethod(), req.GetURL());
+            return NRpc::TResponse()
+                .SetStatus(NRpc::EHttpCode::InternalError)
+                .SetText("Internal Server Error");
+        }
+    }
+
+    // Время разбора, обработчика и сериализации пишется отдельно
+    template<typename ProtoRequestType, typename ProtoResponseType, typename HandlerFunc>
+    static NRpc::TResponse CallProtoHandler(HandlerFunc& handler, const NRpc::TRequest& req, THandlerMetrics* metrics) {
+        try {
+            auto start = THandlerMetrics::TClock::now();
+            ProtoRequestType protoRequest;
+            if (!req.ParseProtoBody(&protoRequest)) {
+                return NRpc::TResponse()
+                    .SetStatus(NRpc::EHttpCode::BadRequest)
+                    .SetText("Failed to parse protobuf request");
+            }
+            auto parsed = THandlerMetrics::TClock::now();
+            metrics->Record(EHandlerPhase::Parse, parsed - start);
+            
+            ProtoResponseType protoResponse;
+            handler(protoRequest, protoResponse);
+            auto handled = THandlerMetrics::TClock::now();
+            metrics->Record(EHandlerPhase::Handler, handled - parsed);
+            
+            auto response = NRpc::TResponse().SetProto(protoResponse);
+            metrics->Record(EHandlerPhase::Write, THandlerMetrics::TClock::now() - handled);
+            return response;
+        } catch (const NRpc::THttpException& ex) {
+            return NRpc::TResponse()
+                .SetStatus(ex.HttpCode())
+                .SetText(ex.what());
+        } catch (const NRpc::TProtoException& ex) {
+            LOG_ERROR("Proto handling error: {}", ex.what());
+            return NRpc::TResponse()
+                .SetStatus(NRpc::EHttpCode::BadRequest)
+                .SetText(ex.what());
+        } catch (const std::exception& ex) {
+            LOG_ERROR("Handler error for {} {}: {}", req.GetMethod(), req.GetURL(), ex.what());
+            return NRpc::TResponse()
+                .SetStatus(NRpc::EHttpCode::InternalError)
+                .SetText("Internal Server Error");
+        } catch (...) {
+            LOG_ERROR("Unknown error in handler for {} {}", req.GetMethod(), req.GetURL());
+            return NRpc::TResponse()
+                .SetStatus(NRpc::EHttpCode::InternalError)
+                .SetText("Internal Server Error");
+        }
+    }
+
+    TMetricsRegistry Metrics_;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,210 @@
+#include <rpc/socket_handoff.h>
+
+#include <common/exception.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace NRpc {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Больше слушающих сокетов, чем реакторов, у сервера не бывает
+constexpr size_t MaxHandoffSockets = 256;
+constexpr char ListenersMessage = 'L';
+constexpr char AckMessage = 'A';
+// Как часто проверять cancel, пока нет ответа
+constexpr int PollStepMs = 100;
+
+sockaddr_un MakeAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    ASSERT(path.size() < sizeof(address.sun_path), "Handoff socket path is too long: {}", path);
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// false, если до deadline данных не было
+bool WaitReadable(SOCKET socket, std::chrono::steady_clock::time_point deadline) {
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        pollfd descriptor{.fd = socket, .events = POLLIN, .revents = 0};
+        int ready = poll(&descriptor, 1, std::max<int64_t>(left.count(), 0));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        return ready > 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+THandoffListener::THandoffListener(std::string path)
+    : Path_(std::move(path))
+{
+    auto address = MakeAddress(Path_);
+    Socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT(Socket_ != -1, "Failed to create handoff socket: {}", errno);
+
+    unlink(Path_.c_str());
+    if (bind(Socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(Socket_, 1) != 0) {
+        auto error = errno;
+        close(Socket_);
+        THROW("Failed to listen handoff socket {}: {}", Path_, error);
+    }
+
+    struct stat info{};
+    if (stat(Path_.c_str(), &info) == 0) {
+        Inode_ = info.st_ino;
+    }
+}
+
+THandoffListener::~THandoffListener() {
+    close(Socket_);
+    struct stat info{};
+    if (stat(Path_.c_str(), &info) == 0 && info.st_ino == Inode_) {
+        unlink(Path_.c_str());
+    }
+}
+
+SOCKET THandoffListener::Accept(std::chrono::milliseconds timeout) {
+    pollfd descriptor{.fd = Socket_, .events = POLLIN, .revents = 0};
+    if (poll(&descriptor, 1, timeout.count()) <= 0) {
+        return -1;
+    }
+    return accept4(Socket_, nullptr, nullptr, SOCK_CLOEXEC);
+}
+
+void SendListeners(SOCKET peer, const std::vector<SOCKET>& listeners) {
+    ASSERT(!listeners.empty() && listeners.size() <= MaxHandoffSockets, "Invalid number of sockets to hand off: {}", listeners.size());
+
+    char payload = ListenersMessage;
+    iovec data{.iov_base = &payload, .iov_len = 1};
+
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * listeners.size()));
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    auto* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * listeners.size());
+    std::memcpy(CMSG_DATA(header), listeners.data(), sizeof(int) * listeners.size());
+
+    ssize_t result;
+    do {
+        result = sendmsg(peer, &message, MSG_NOSIGNAL);
+    } while (result < 0 && errno == EINTR);
+    ASSERT(result == 1, "Failed to send listening sockets: {}", errno);
+}
+
+bool WaitHandoffAck(SOCKET peer, const std::atomic<bool>& cancel) {
+    while (!cancel) {
+        pollfd descriptor{.fd = peer, .events = POLLIN, .revents = 0};
+        int ready = poll(&descriptor, 1, PollStepMs);
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        char reply = 0;
+        auto result = recv(peer, &reply, 1, 0);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        return result == 1 && reply == AckMessage;
+    }
+    return false;
+}
+
+std::vector<SOCKET> ReceiveListeners(const std::string& path, SOCKET* peer, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto address = MakeAddress(path);
+    SOCKET connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT(connection != -1, "Failed to create handoff socket: {}", errno);
+
+    // connect ждет места в очереди слушающего сокета не дольше SO_SNDTIMEO
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timeval connectTimeout{
+        .tv_sec = static_cast<time_t>(seconds.count()),
+        .tv_usec = static_cast<suseconds_t>(std::chrono::duration_cast<std::chrono::microseconds>(timeout - seconds).count()),
+    };
+    setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &connectTimeout, sizeof(connectTimeout));
+
+    // Нет файла или никто его не слушает — передавать сокеты некому
+    if (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(connection);
+        return {};
+    }
+
+    // Зависший предыдущий процесс не должен держать запуск нового
+    if (!WaitReadable(connection, deadline)) {
+        close(connection);
+        return {};
+    }
+
+    char payload = 0;
+    iovec data{.iov_base = &payload, .iov_len = 1};
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * MaxHandoffSockets));
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    ssize_t result;
+    do {
+        result = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+    } while (result < 0 && errno == EINTR);
+
+    std::vector<SOCKET> listeners;
+    for (auto* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            listeners.resize(count);
+            std::memcpy(listeners.data(), CMSG_DATA(header), sizeof(int) * count);
+        }
+    }
+
+    if (result != 1 || payload != ListenersMessage || listeners.empty()) {
+        for (auto listener : listeners) {
+            close(listener);
+        }
+        close(connection);
+        return {};
+    }
+
+    *peer = connection;
+    return listeners;
+}
+
+void SendHandoffAck(SOCKET peer) {
+    char reply = AckMessage;
+    if (send(peer, &reply, 1, MSG_NOSIGNAL) != 1) {
+        close(peer);
+        THROW("Failed to acknowledge socket handoff: {}", errno);
+    }
+    close(peer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
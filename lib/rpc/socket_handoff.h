@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#ifndef SOCKET
+#define SOCKET int
+#endif
+
+namespace NRpc {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Передача слушающих сокетов новому процессу при перезапуске без простоя.
+// Старый процесс слушает unix сокет; новый подключается к нему, получает
+// копии слушающих сокетов (SCM_RIGHTS) и, когда сам начинает принимать
+// соединения, подтверждает это одним байтом. Пока подтверждения нет, старый
+// процесс продолжает работать, и соединения из общей очереди принимает он.
+
+// Unix сокет, через который новый процесс забирает слушающие сокеты
+class THandoffListener {
+public:
+    // Старый файл сокета по этому пути удаляется: им владел предыдущий процесс
+    explicit THandoffListener(std::string path);
+    // Файл удаляется, только если его не заменил следующий процесс
+    ~THandoffListener();
+
+    THandoffListener(const THandoffListener&) = delete;
+    THandoffListener& operator=(const THandoffListener&) = delete;
+
+    // Ждет подключения не дольше timeout, -1 если его не было
+    SOCKET Accept(std::chrono::milliseconds timeout);
+
+private:
+    const std::string Path_;
+    SOCKET Socket_ = -1;
+    ino_t Inode_ = 0;
+};
+
+// Бросает, если сокеты не удалось отправить
+void SendListeners(SOCKET peer, const std::vector<SOCKET>& listeners);
+
+// true, если новый процесс подтвердил прием соединений; false, если он
+// закрыл соединение без подтверждения или выставлен cancel
+bool WaitHandoffAck(SOCKET peer, const std::atomic<bool>& cancel);
+
+// Подключается к процессу, слушающему path, и забирает его слушающие сокеты.
+// Пустой результат, если такого процесса нет или он не отдал сокеты за
+// timeout. В peer остается соединение для SendHandoffAck
+std::vector<SOCKET> ReceiveListeners(const std::string& path, SOCKET* peer, std::chrono::milliseconds timeout);
+
+// Подтверждает прием соединений и закрывает peer
+void SendHandoffAck(SOCKET peer);
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc
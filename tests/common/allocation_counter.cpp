@@ -0,0 +1,66 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::atomic<size_t> AllocationCount{0};
+std::atomic<size_t> LiveBytes{0};
+std::atomic<size_t> PeakBytes{0};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+void* operator new(size_t size) {
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    auto live = LiveBytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed) + malloc_usable_size(ptr);
+    auto peak = PeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) {
+        LiveBytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+    }
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace NCommon::NTesting {
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t GetAllocationCount() {
+    return AllocationCount.load(std::memory_order_relaxed);
+}
+
+size_t GetLiveBytes() {
+    return LiveBytes.load(std::memory_order_relaxed);
+}
+
+size_t GetPeakBytes() {
+    return PeakBytes.load(std::memory_order_relaxed);
+}
+
+void ResetPeakBytes() {
+    PeakBytes.store(LiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NCommon::NTesting
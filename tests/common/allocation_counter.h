@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+namespace NCommon::NTesting {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Учет памяти через глобальный operator new для бенчмарков; подключается
+// в бинарник один раз.
+
+// Число вызовов operator new с начала работы бинарника.
+size_t GetAllocationCount();
+
+// Живая память и ее пик. Пик сбрасывается до текущего объема, так бенчмарк
+// меряет пик одного участка кода.
+size_t GetLiveBytes();
+size_t GetPeakBytes();
+void ResetPeakBytes();
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NCommon::NTesting
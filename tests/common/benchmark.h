@@ -0,0 +1,41 @@
+#pragma once
+
+#include <tests/common/allocation_counter.h>
+
+#include <chrono>
+#include <cstddef>
+
+namespace NCommon::NTesting {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Среднее время и число аллокаций на одну итерацию замера
+struct TMeasurement {
+    double NanosPerIteration = 0;
+    double AllocationsPerIteration = 0;
+
+    double MicrosPerIteration() const {
+        return NanosPerIteration / 1000;
+    }
+};
+
+// Гоняет func iterations раз; бинарник должен линковаться с allocation_counter.cpp
+template <typename TFunc>
+TMeasurement Measure(size_t iterations, TFunc&& func) {
+    size_t allocationsBefore = GetAllocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    size_t allocations = GetAllocationCount() - allocationsBefore;
+
+    return {
+        .NanosPerIteration = std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+        .AllocationsPerIteration = static_cast<double>(allocations) / iterations,
+    };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NCommon::NTesting
@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+#include <ipc/db_client.h>
+#include <query_builder/builders/postgres.h>
+#include <relation/message.h>
+#include <relation/relation_manager.h>
+#include <tests/proto/test_objects.pb.h>
+
+#include <cstdlib>
+#include <optional>
+#include <thread>
+
+namespace {
+
+using namespace NIpc;
+using namespace NOrm::NRelation;
+
+// Тестам нужен настоящий PostgreSQL: IP адрес, база и пользователь берутся из
+// ORM_TEST_DB_HOST, ORM_TEST_DB_NAME, ORM_TEST_DB_USER, пароль из ORM_TEST_DB_PASSWORD,
+// порт из необязательного ORM_TEST_DB_PORT. Без них тесты пропускаются
+std::optional<nlohmann::json> GetTestDbConfig() {
+    const char* host = getenv("ORM_TEST_DB_HOST");
+    const char* name = getenv("ORM_TEST_DB_NAME");
+    const char* user = getenv("ORM_TEST_DB_USER");
+    if (!host || !name || !user || !getenv("ORM_TEST_DB_PASSWORD")) {
+        return std::nullopt;
+    }
+
+    nlohmann::json data = {
+        {"host_address", host},
+        {"db_name", name},
+        {"user_name", user},
+        {"password_env", "ORM_TEST_DB_PASSWORD"},
+    };
+    if (const char* port = getenv("ORM_TEST_DB_PORT")) {
+        data["port"] = std::stoul(port);
+    }
+    return data;
+}
+
+class DbClientTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto data = GetTestDbConfig();
+        if (!data) {
+            GTEST_SKIP() << "ORM_TEST_DB_* is not set";
+        }
+        BaseConfig = std::move(*data);
+    }
+
+    TDataBaseConfigPtr MakeConfig(const nlohmann::json& overrides = nlohmann::json::object()) {
+        auto data = BaseConfig;
+        data.update(overrides);
+        auto config = NCommon::New<TDataBaseConfig>();
+        config->Load(data);
+        return config;
+    }
+
+    TDbClientPtr Connect(const nlohmann::json& overrides = nlohmann::json::object()) {
+        auto client = NCommon::New<TDbClient>(MakeConfig(overrides));
+        client->Connect();
+        return client;
+    }
+
+    nlohmann::json BaseConfig;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(DbClientTest, PoolOpensMinConnections) {
+    auto client = Connect({{"min_connections", 2}, {"max_connections", 3}});
+    auto pool = client->GetPool();
+    EXPECT_EQ(pool->GetTotalCount(), 2u);
+    EXPECT_EQ(pool->GetIdleCount(), 2u);
+
+    auto result = client->ExecuteQuery("SELECT $1::int + 1", "41");
+    EXPECT_EQ(result[0][0].as<int>(), 42);
+    // Соединение вернулось в пул
+    EXPECT_EQ(pool->GetIdleCount(), 2u);
+}
+
+TEST_F(DbClientTest, CheckoutTimesOut) {
+    auto client = Connect({{"min_connections", 1}, {"max_connections", 1}});
+    auto pool = client->GetPool();
+
+    auto lease = pool->Acquire();
+    EXPECT_ANY_THROW(pool->Acquire(std::chrono::milliseconds(50)));
+
+    lease.Release();
+    EXPECT_TRUE(pool->Acquire(std::chrono::milliseconds(50)));
+}
+
+TEST_F(DbClientTest, CheckoutWakesWaiter) {
+    auto client = Connect({{"min_connections", 1}, {"max_connections", 1}});
+    auto pool = client->GetPool();
+
+    auto lease = pool->Acquire();
+    std::thread releasing([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        lease.Release();
+    });
+    EXPECT_TRUE(pool->Acquire(std::chrono::seconds(5)));
+    releasing.join();
+}
+
+TEST_F(DbClientTest, TransactionOwnsConnection) {
+    auto client = Connect({{"min_connections", 1}, {"max_connections", 2}});
+
+    auto txn = client->BeginTransaction();
+    txn.ExecuteQuery("CREATE TEMP TABLE orm_pool_test (id int)");
+    txn.ExecuteQuery("INSERT INTO orm_pool_test VALUES (1), (2)");
+
+    // Запросы клиента идут через другое соединение и не видят временную таблицу
+    EXPECT_ANY_THROW(client->ExecuteQuery("SELECT count(*) FROM orm_pool_test"));
+    EXPECT_EQ(txn.ExecuteQuery("SELECT count(*) FROM orm_pool_test")[0][0].as<int>(), 2);
+
+    txn.Rollback();
+    EXPECT_EQ(client->GetPool()->GetIdleCount(), client->GetPool()->GetTotalCount());
+}
+
+TEST_F(DbClientTest, EvictedStatementsDeallocatedAfterTransaction) {
+    auto client = Connect({{"min_connections", 1}, {"max_connections", 1}, {"prepared_cache_size", 1}});
+
+    auto txn = client->BeginTransaction();
+    EXPECT_EQ(txn.ExecutePrepared("SELECT $1::int", {"1"})[0][0].as<int>(), 1);
+    // Вытеснение первого выражения не трогает транзакцию пользователя
+    EXPECT_EQ(txn.ExecutePrepared("SELECT $1::int + 1", {"1"})[0][0].as<int>(), 2);
+    EXPECT_EQ(txn.ExecuteQuery("SELECT 3")[0][0].as<int>(), 3);
+    txn.Commit();
+
+    // Единственное соединение пула: на сервере осталось только последнее выражение
+    EXPECT_EQ(client->ExecuteQuery("SELECT count(*) FROM pg_prepared_statements")[0][0].as<int>(), 1);
+}
+
+TEST_F(DbClientTest, AsyncQueryReturnsResult) {
+    auto client = Connect({{"max_connections", 2}, {"async_threads", 2}});
+
+    auto first = client->ExecuteQueryAsync("SELECT $1::int * 2", {"21"});
+    auto second = client->ExecuteQueryAsync("SELECT $1::text || $2::text", {"foo", "bar"}, std::chrono::seconds(10));
+
+    auto firstResult = first.get();
+    ASSERT_TRUE(firstResult);
+    EXPECT_EQ(firstResult.Value()[0][0].as<int>(), 42);
+    auto secondResult = second.get();
+    ASSERT_TRUE(secondResult);
+    EXPECT_EQ(secondResult.Value()[0][0].as<std::string>(), "foobar");
+
+    // Ошибка запроса возвращается через результат, а не рушит поток пула
+    auto failed = client->ExecuteQueryAsync("SELECT * FROM orm_missing_table", {}).get();
+    EXPECT_FALSE(failed);
+    EXPECT_ANY_THROW(failed.ThrowOnError());
+}
+
+TEST_F(DbClientTest, AsyncQueryDeadlineExceeded) {
+    auto client = Connect({{"max_connections", 1}, {"async_threads", 1}});
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = client->ExecuteQueryAsync("SELECT pg_sleep(10)", {}, std::chrono::milliseconds(200)).get();
+    EXPECT_FALSE(result);
+    // Сервер прерывает запрос по statement_timeout, не дожидаясь pg_sleep
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    // Дедлайн истекает, пока единственное соединение занято
+    auto lease = client->GetPool()->Acquire();
+    EXPECT_FALSE(client->ExecuteQueryAsync("SELECT 1", {}, std::chrono::milliseconds(50)).get());
+    lease.Release();
+
+    // Соединение после прерванного запроса пригодно для работы
+    auto next = client->ExecuteQueryAsync("SELECT 1", {}, std::chrono::seconds(10)).get();
+    ASSERT_TRUE(next);
+    EXPECT_EQ(next.Value()[0][0].as<int>(), 1);
+}
+
+TEST_F(DbClientTest, AsyncQueryCanceled) {
+    auto client = Connect({{"max_connections", 1}, {"async_threads", 1}});
+
+    // Отмененный заранее запрос не запускается
+    auto canceler = NCommon::New<TQueryCanceler>();
+    canceler->Cancel();
+    EXPECT_TRUE(canceler->IsCanceled());
+    EXPECT_FALSE(client->ExecuteQueryAsync("SELECT 1", {}, std::nullopt, canceler).get());
+
+    canceler = NCommon::New<TQueryCanceler>();
+    auto start = std::chrono::steady_clock::now();
+    auto future = client->ExecuteQueryAsync("SELECT pg_sleep(10)", {}, std::nullopt, canceler);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    canceler->Cancel();
+
+    EXPECT_FALSE(future.get());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    auto next = client->ExecuteQueryAsync("SELECT 1", {}).get();
+    ASSERT_TRUE(next);
+    EXPECT_EQ(next.Value()[0][0].as<int>(), 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class DbClientSchemaTest : public DbClientTest {
+protected:
+    void SetUp() override {
+        DbClientTest::SetUp();
+        if (IsSkipped()) {
+            return;
+        }
+
+        test_objects::SimpleMessage simple;
+        TRelationManager::GetInstance().Clear();
+
+        auto config = NCommon::New<TTableConfig>();
+        config->Number = 1;
+        config->SnakeCase = "simple_message";
+        config->CamelCase = "SimpleMessage";
+        config->Scheme = "test_objects.SimpleMessage";
+        RegisterRootMessage(config);
+
+        SimplePath = TMessagePath("simple_message");
+    }
+
+    void TearDown() override {
+        TRelationManager::GetInstance().Clear();
+    }
+
+    // Таблица создается внутри транзакции и исчезает при ее откате
+    void CreateSimpleTable(TTransaction& txn) {
+        auto table = TRelationManager::GetInstance().GetRootMessage(SimplePath);
+        for (const auto& statement : Builder::TPostgresBuilder().BuildStatements(Organizer.CreateTable(table))) {
+            txn.ExecuteQuery(statement);
+        }
+    }
+
+    TSqlQueryOrganizer Organizer;
+    TMessagePath SimplePath;
+};
+
+TEST_F(DbClientSchemaTest, CopyInsertEndToEnd) {
+    auto insert = Insert(SimplePath);
+    for (int32_t id = 1; id <= 2500; ++id) {
+        insert.AddSubrequest({
+            TAttribute(SimplePath / "id", id),
+            TAttribute(SimplePath / "name", "name\t" + std::to_string(id)),
+        });
+    }
+    auto copy = Organizer.OrganizeCopyInsert(insert);
+    ASSERT_TRUE(copy);
+
+    // Чанк меньше числа строк: COPY перезапускается по ходу загрузки
+    auto client = Connect({{"copy_chunk_size", 1000}});
+    auto txn = client->BeginTransaction();
+    CreateSimpleTable(txn);
+
+    EXPECT_EQ(txn.CopyRows(*copy), 2500u);
+
+    auto result = txn.ExecuteQuery("SELECT count(*), max(f_1) FROM t_1");
+    EXPECT_EQ(result[0][0].as<int>(), 2500);
+    EXPECT_EQ(result[0][1].as<int>(), 2500);
+    // Спецсимволы доходят до базы без искажений, пропущенная колонка получает DEFAULT
+    result = txn.ExecuteQuery("SELECT f_2, f_3 FROM t_1 WHERE f_1 = $1", 7);
+    EXPECT_EQ(result[0][0].as<std::string>(), "name\t7");
+    EXPECT_TRUE(result[0][1].as<bool>());
+
+    txn.Rollback();
+}
+
+TEST_F(DbClientSchemaTest, StreamSelect) {
+    auto client = Connect({{"stream_batch_size", 1000}});
+    // Курсор без WITH HOLD видит только таблицы своей транзакции
+    auto txn = client->BeginTransaction();
+    CreateSimpleTable(txn);
+    txn.ExecuteQuery("INSERT INTO t_1 (f_1, f_2) SELECT i, 'name_' || i FROM generate_series(1, 2500) AS i");
+
+    auto query = Select(SimplePath, Col(SimplePath / "id"), Col(SimplePath / "name"));
+    query.Where(Col(SimplePath / "id") > Val(100));
+
+    std::vector<size_t> batches;
+    int64_t sum = 0;
+    auto total = txn.StreamQuery(query, [&] (const pqxx::result& batch) {
+        batches.push_back(batch.size());
+        for (const auto& row : batch) {
+            sum += row[0].as<int64_t>();
+        }
+        return true;
+    });
+    EXPECT_EQ(total, 2400u);
+    EXPECT_EQ(batches, (std::vector<size_t>{1000, 1000, 400}));
+    EXPECT_EQ(sum, (101 + 2500) * 2400 / 2);
+
+    // Колбэк прекращает чтение после первой пачки
+    total = txn.StreamQuery(query, [] (const pqxx::result&) {
+        return false;
+    });
+    EXPECT_EQ(total, 1000u);
+
+    auto cursor = txn.OpenCursor(query);
+    EXPECT_EQ(cursor->NextBatch().size(), 1000u);
+    cursor->Close();
+
+    txn.Rollback();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -630,4 +630,69 @@ TEST_F(PostgresQueryBuilderTest, DeleteWithTableName) {
     EXPECT_EQ(deleteSQL, "DELETE FROM t_1 WHERE (t_1.f_1 = 1)");
 }
 
+// Тест параметризованной сборки: литералы заменяются на $1..$n
+TEST_F(PostgresQueryBuilderTest, ParameterizedSelectAndInsert) {
+    auto idCol = std::make_shared<TColumn>(simplePath.GetTable(), std::vector<uint32_t>{1});
+    idCol->SetColumnType(NOrm::NQuery::EColumnType::ESingular);
+    idCol->SetKeyType(EKeyType::Simple);
+
+    auto nameCol = std::make_shared<TColumn>(simplePath.GetTable(), std::vector<uint32_t>{2});
+    nameCol->SetColumnType(NOrm::NQuery::EColumnType::ESingular);
+    nameCol->SetKeyType(EKeyType::Simple);
+
+    auto makeSelect = [&](int32_t id, const std::string& name) {
+        auto idCondition = std::make_shared<TExpression>();
+        idCondition->SetExpressionType(NOrm::NQuery::EExpressionType::greater_than);
+        idCondition->SetOperands({idCol, std::make_shared<TInt>(id)});
+
+        auto nameCondition = std::make_shared<TExpression>();
+        nameCondition->SetExpressionType(NOrm::NQuery::EExpressionType::equals);
+        nameCondition->SetOperands({nameCol, std::make_shared<TString>(name)});
+
+        auto whereExpr = std::make_shared<TExpression>();
+        whereExpr->SetExpressionType(NOrm::NQuery::EExpressionType::and_);
+        whereExpr->SetOperands({idCondition, nameCondition});
+
+        auto selectQuery = std::make_shared<TSelect>();
+        selectQuery->SetSelectors({idCol, nameCol});
+        selectQuery->SetFrom({std::make_shared<TTable>(simplePath)});
+        selectQuery->SetWhere(whereExpr);
+        return selectQuery;
+    };
+
+    // Проверяем соответствие плейсхолдеров значениям
+    auto paramOf = [](const TParameterizedQuery& query, const std::string& type) {
+        auto typePos = query.Query.find("::" + type);
+        auto dollarPos = query.Query.rfind('$', typePos);
+        return query.Params.at(std::stoul(query.Query.substr(dollarPos + 1, typePos - dollarPos - 1)) - 1);
+    };
+
+    auto first = builder->BuildParameterized(makeSelect(10, "it's"));
+    EXPECT_EQ(first.Params.size(), 2u);
+    EXPECT_EQ(paramOf(first, "integer"), "10");
+    EXPECT_EQ(paramOf(first, "text"), "it's");
+    EXPECT_EQ(first.Query.find("10"), std::string::npos);
+    EXPECT_EQ(first.Query.find('\''), std::string::npos);
+    // Параметры нумеруются в порядке записи в запрос
+    EXPECT_EQ(first.Params, (std::vector<std::string>{"10", "it's"}));
+
+    // Запросы одной формы дают одинаковый текст
+    auto second = builder->BuildParameterized(makeSelect(20, "other"));
+    EXPECT_EQ(second.Query, first.Query);
+    EXPECT_EQ(paramOf(second, "integer"), "20");
+    EXPECT_EQ(paramOf(second, "text"), "other");
+
+    auto insertQuery = std::make_shared<TInsert>(simplePath);
+    insertQuery->SetSelectors({idCol, nameCol});
+    insertQuery->SetIsValues(true);
+    insertQuery->SetValues({{std::make_shared<TFloat>(0.1), std::make_shared<TBool>(true)}});
+
+    auto insert = builder->BuildParameterized(insertQuery);
+    EXPECT_EQ(insert.Query, "INSERT INTO t_1 (t_1.f_1, t_1.f_2) VALUES ($1::double precision, $2::boolean)");
+    EXPECT_EQ(insert.Params, (std::vector<std::string>{"0.10000000000000001", "true"}));
+
+    // Обычная сборка после параметризованной по-прежнему встраивает литералы
+    EXPECT_EQ(BuildInt(123), "123");
+}
+
 } // namespace
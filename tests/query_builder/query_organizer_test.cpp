@@ -116,6 +116,74 @@ TEST_F(SqlQueryOrganizerTest, OrganizeInsert) {
     EXPECT_TRUE(sql.find("VALUES") != std::string::npos);
 }
 
+TEST_F(SqlQueryOrganizerTest, OrganizeCopyInsert) {
+    auto insertQuery = Insert(simplePath);
+
+    for (int32_t id = 1; id <= 3; ++id) {
+        std::vector<TAttribute> attributes;
+        attributes.emplace_back(simplePath / "id", id);
+        attributes.emplace_back(simplePath / "name", "Name\t" + std::to_string(id));
+        insertQuery.AddSubrequest(attributes);
+    }
+
+    // Порядок атрибутов в строке не важен
+    std::vector<TAttribute> reordered;
+    reordered.emplace_back(simplePath / "name", std::string("Last"));
+    reordered.emplace_back(simplePath / "id", 4);
+    insertQuery.AddSubrequest(reordered);
+
+    auto copyInsert = sqlOrganizer->OrganizeCopyInsert(insertQuery);
+    ASSERT_TRUE(copyInsert.has_value());
+
+    EXPECT_EQ(BuildQuery(copyInsert->Table), "t_1");
+    ASSERT_EQ(copyInsert->Columns.size(), 2u);
+    EXPECT_EQ(BuildQuery(copyInsert->Columns[0]), "f_1");
+    EXPECT_EQ(BuildQuery(copyInsert->Columns[1]), "f_2");
+
+    std::vector<TCopyRow> rows;
+    TCopyRow row;
+    while (copyInsert->NextRow(row)) {
+        rows.push_back(row);
+    }
+
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0], (TCopyRow{"1", "Name\t1"}));
+    EXPECT_EQ(rows[2], (TCopyRow{"3", "Name\t3"}));
+    EXPECT_EQ(rows[3], (TCopyRow{"4", "Last"}));
+}
+
+TEST_F(SqlQueryOrganizerTest, CopyInsertEncodesUInt32LikeValues) {
+    // Колонка uint32 - INTEGER, значение от 2^31 оба пути пишут как int32
+    auto insertQuery = Insert(simplePath);
+    insertQuery.AddSubrequest({TAttribute(simplePath / "id", uint32_t(3000000000u))});
+
+    auto copyInsert = sqlOrganizer->OrganizeCopyInsert(insertQuery);
+    ASSERT_TRUE(copyInsert.has_value());
+    TCopyRow row;
+    ASSERT_TRUE(copyInsert->NextRow(row));
+    EXPECT_EQ(row, (TCopyRow{"-1294967296"}));
+
+    auto sql = BuildQuery(sqlOrganizer->OrganizeInsert(insertQuery));
+    EXPECT_NE(sql.find("-1294967296"), std::string::npos) << sql;
+    EXPECT_EQ(sql.find("3000000000"), std::string::npos) << sql;
+}
+
+TEST_F(SqlQueryOrganizerTest, OrganizeCopyInsertFallback) {
+    // Upsert невозможно выразить через COPY
+    auto upsertQuery = Insert(simplePath);
+    upsertQuery.AddSubrequest({TAttribute(simplePath / "id", 1)});
+    upsertQuery.UpdateIfExists();
+    EXPECT_FALSE(sqlOrganizer->OrganizeCopyInsert(upsertQuery).has_value());
+
+    // Пропущенная колонка должна получить DEFAULT, а COPY запишет NULL
+    auto sparseQuery = Insert(simplePath);
+    sparseQuery.AddSubrequest({TAttribute(simplePath / "id", 1), TAttribute(simplePath / "name", std::string("Test"))});
+    sparseQuery.AddSubrequest({TAttribute(simplePath / "id", 2)});
+    EXPECT_FALSE(sqlOrganizer->OrganizeCopyInsert(sparseQuery).has_value());
+
+    EXPECT_FALSE(sqlOrganizer->OrganizeCopyInsert(Insert(simplePath)).has_value());
+}
+
 TEST_F(SqlQueryOrganizerTest, OrganizeUpdate) {
     auto updateQuery = Update(simplePath);
     
@@ -134,6 +202,23 @@ TEST_F(SqlQueryOrganizerTest, OrganizeUpdate) {
     EXPECT_TRUE(sql.find("SET") != std::string::npos);
 }
 
+TEST_F(SqlQueryOrganizerTest, OrganizeUpdateStatements) {
+    auto updateQuery = Update(simplePath);
+    updateQuery.AddUpdate({TAttribute(simplePath / "name", std::string("first")), TAttribute(simplePath / "id", 1)});
+    updateQuery.AddUpdate({TAttribute(simplePath / "name", std::string("second")), TAttribute(simplePath / "id", 2)});
+
+    auto organizedUpdate = sqlOrganizer->OrganizeUpdate(updateQuery);
+    ASSERT_NE(organizedUpdate, nullptr);
+
+    // По одному выражению на набор атрибутов, в исходном порядке
+    auto statements = postgresBuilder->BuildStatements(organizedUpdate);
+    ASSERT_EQ(statements.size(), organizedUpdate->GetClauses().size());
+    ASSERT_EQ(statements.size(), 2u);
+    EXPECT_NE(statements[0].find("first"), std::string::npos);
+    EXPECT_NE(statements[1].find("second"), std::string::npos);
+    EXPECT_EQ(statements[0] + "; " + statements[1], BuildQueryFromPtr(organizedUpdate));
+}
+
 TEST_F(SqlQueryOrganizerTest, OrganizeDelete) {
     auto deleteQuery = Delete(simplePath);
     
@@ -342,6 +427,49 @@ TEST_F(SqlQueryOrganizerTest, SelectWithComplexConditionsAndInClause) {
     EXPECT_TRUE(sql.find("(SELECT") != std::string::npos);
 }
 
+TEST_F(SqlQueryOrganizerTest, OrganizeSelectFromProto) {
+    auto idCol = Col(simplePath / "id");
+    auto nameCol = Col(simplePath / "name");
+
+    auto subquery = Select(simplePath, Max(idCol));
+    auto query = Select(simplePath, All(), Lower(nameCol));
+    query.Where((idCol > Val(10) && Like(nameCol, Val("a%"))) || idCol == subquery);
+    query.Limit(5);
+
+    NOrm::NApi::TQuery proto;
+    CreateQuery().AddClause(query).ToProto(&proto);
+
+    // Через восстановленное дерево клауз
+    NOrm::NRelation::TQuery decoded;
+    decoded.FromProto(proto);
+    auto clause = decoded.GetClauses().at(0);
+    NOrm::NRelation::TSelect decodedSelect = clause;
+    std::string expected = BuildQuery(sqlOrganizer->OrganizeSelect(decodedSelect));
+
+    // Прямо из сообщения
+    TQueryView view(proto);
+    ASSERT_EQ(view.GetClauseCount(), 1u);
+    std::string actual = BuildQuery(sqlOrganizer->OrganizeSelect(view.GetClause(0)));
+
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(actual, BuildQuery(sqlOrganizer->OrganizeSelect(query)));
+}
+
+TEST_F(SqlQueryOrganizerTest, OrganizeSelectFromInvalidProto) {
+    auto query = Select(simplePath, Col(simplePath / "id"));
+    query.Where(Col(simplePath / "id") > Val(10));
+
+    NOrm::NApi::TQuery proto;
+    CreateQuery().AddClause(query).ToProto(&proto);
+
+    // Ссылка вперед недопустима: она может образовать цикл
+    auto* expression = proto.mutable_clauses(proto.clauses_size() - 2)->mutable_expression();
+    expression->set_operands(0, proto.clauses_size() - 1);
+
+    TQueryView view(proto);
+    EXPECT_THROW(sqlOrganizer->OrganizeSelect(view.GetClause(0)), std::exception);
+}
+
 TEST_F(SqlQueryOrganizerTest, UpdateWithSubquery) {
     auto updateQuery = Update(simplePath);
     
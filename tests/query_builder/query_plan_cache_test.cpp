@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <query_builder/query_plan_cache.h>
+#include <relation/relation_manager.h>
+#include <relation/message.h>
+#include <tests/proto/test_objects.pb.h>
+
+namespace {
+
+using namespace NOrm::NRelation;
+
+class QueryPlanCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_objects::SimpleMessage simple;
+
+        TRelationManager::GetInstance().Clear();
+
+        simpleConfig = NCommon::New<TTableConfig>();
+        simpleConfig->Number = 1;
+        simpleConfig->SnakeCase = "simple_message";
+        simpleConfig->CamelCase = "SimpleMessage";
+        simpleConfig->Scheme = "test_objects.SimpleMessage";
+
+        RegisterRootMessage(simpleConfig);
+
+        simplePath = TMessagePath("simple_message");
+    }
+
+    void TearDown() override {
+        TRelationManager::GetInstance().Clear();
+    }
+
+    TSelect MakeSelect(int32_t id, const std::string& name) {
+        auto query = Select(simplePath, Col(simplePath / "id"), Col(simplePath / "name"));
+        query.Where(Col(simplePath / "id") > Val(id) && Col(simplePath / "name") == Val(name));
+        return query;
+    }
+
+    TTableConfigPtr simpleConfig;
+    TMessagePath simplePath;
+};
+
+TEST_F(QueryPlanCacheTest, ShapeIgnoresLiterals) {
+    auto first = GetQueryShape(MakeSelect(1, "a"));
+    auto second = GetQueryShape(MakeSelect(2, "b"));
+    ASSERT_TRUE(first && second);
+
+    EXPECT_EQ(first->Signature, second->Signature);
+    EXPECT_EQ(first->Params, (std::vector<std::string>{"1", "a"}));
+    EXPECT_EQ(second->Params, (std::vector<std::string>{"2", "b"}));
+
+    // Другой тип литерала меняет структуру: меняется приведение плейсхолдера
+    auto query = Select(simplePath, Col(simplePath / "id"), Col(simplePath / "name"));
+    query.Where(Col(simplePath / "id") > Val(1.5) && Col(simplePath / "name") == Val("a"));
+    auto other = GetQueryShape(query);
+    ASSERT_TRUE(other);
+    EXPECT_NE(other->Signature, first->Signature);
+}
+
+TEST_F(QueryPlanCacheTest, HitReusesTemplate) {
+    TQueryPlanCache cache(16);
+
+    auto miss = cache.BuildSelect(MakeSelect(10, "it's"));
+    EXPECT_EQ(cache.GetMissCount(), 1u);
+    EXPECT_EQ(cache.GetHitCount(), 0u);
+    EXPECT_EQ(cache.GetSize(), 1u);
+
+    auto hit = cache.BuildSelect(MakeSelect(20, "other"));
+    EXPECT_EQ(cache.GetMissCount(), 1u);
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+
+    EXPECT_EQ(hit.Query, miss.Query);
+    EXPECT_EQ(hit.Params, (std::vector<std::string>{"20", "other"}));
+
+    // Результат совпадает с полной сборкой запроса
+    Builder::TPostgresBuilder builder;
+    auto expected = builder.BuildParameterized(TSqlQueryOrganizer().OrganizeSelect(MakeSelect(20, "other")));
+    EXPECT_EQ(hit.Query, expected.Query);
+    EXPECT_EQ(hit.Params, expected.Params);
+}
+
+TEST_F(QueryPlanCacheTest, LogOperandOrder) {
+    TQueryPlanCache cache(16);
+
+    auto makeQuery = [&](double base) {
+        auto query = Select(simplePath, Col(simplePath / "id"));
+        query.Where(Log(Col(simplePath / "id"), Val(base)) > Val(1));
+        return query;
+    };
+
+    cache.BuildSelect(makeQuery(2.0));
+    auto hit = cache.BuildSelect(makeQuery(10.0));
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+
+    Builder::TPostgresBuilder builder;
+    auto expected = builder.BuildParameterized(TSqlQueryOrganizer().OrganizeSelect(makeQuery(10.0)));
+    EXPECT_EQ(hit.Query, expected.Query);
+    EXPECT_EQ(hit.Params, expected.Params);
+}
+
+TEST_F(QueryPlanCacheTest, EvictsLeastRecentlyUsed) {
+    TQueryPlanCache cache(2);
+
+    auto byId = Select(simplePath, Col(simplePath / "id"));
+    byId.Where(Col(simplePath / "id") == Val(1));
+    auto byName = Select(simplePath, Col(simplePath / "name"));
+    byName.Where(Col(simplePath / "name") == Val("a"));
+
+    cache.BuildSelect(byId);
+    cache.BuildSelect(byName);
+    // byId становится самым недавно использованным
+    cache.BuildSelect(byId);
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+
+    // Вытесняет byName
+    cache.BuildSelect(MakeSelect(1, "a"));
+    EXPECT_EQ(cache.GetSize(), 2u);
+
+    cache.BuildSelect(byId);
+    EXPECT_EQ(cache.GetHitCount(), 2u);
+    cache.BuildSelect(byName);
+    EXPECT_EQ(cache.GetHitCount(), 2u);
+    EXPECT_EQ(cache.GetMissCount(), 4u);
+
+    cache.Clear();
+    EXPECT_EQ(cache.GetSize(), 0u);
+}
+
+TEST_F(QueryPlanCacheTest, ResetsOnSchemaChange) {
+    TQueryPlanCache cache(16);
+
+    cache.BuildSelect(MakeSelect(1, "a"));
+    cache.BuildSelect(MakeSelect(2, "b"));
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+
+    // Новый снимок с той же таблицей: сигнатура прежняя, но запись
+    // построена по старой схеме и не должна переиспользоваться
+    TRelationManager::GetInstance().Clear();
+    simpleConfig->SnakeCase = "renamed_message";
+    RegisterRootMessage(simpleConfig);
+
+    auto after = cache.BuildSelect(MakeSelect(3, "c"));
+    EXPECT_EQ(cache.GetHitCount(), 1u);
+    EXPECT_EQ(cache.GetMissCount(), 2u);
+    EXPECT_EQ(cache.GetSize(), 1u);
+
+    Builder::TPostgresBuilder builder;
+    auto expected = builder.BuildParameterized(TSqlQueryOrganizer().OrganizeSelect(MakeSelect(3, "c")));
+    EXPECT_EQ(after.Query, expected.Query);
+
+    cache.BuildSelect(MakeSelect(4, "d"));
+    EXPECT_EQ(cache.GetHitCount(), 2u);
+}
+
+} // namespace
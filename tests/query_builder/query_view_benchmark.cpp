@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <query_builder/organizers/sql_organizer.h>
+#include <query_builder/builders/postgres.h>
+#include <relation/relation_manager.h>
+#include <requests/query_view.h>
+#include <tests/proto/test_objects.pb.h>
+#include <tests/common/benchmark.h>
+
+#include <iostream>
+
+namespace {
+
+using namespace NOrm::NRelation;
+using NCommon::NTesting::Measure;
+
+constexpr size_t Iterations = 200;
+
+class QueryViewBenchmark : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_objects::SimpleMessage simple;
+
+        TRelationManager::GetInstance().Clear();
+
+        auto simpleConfig = NCommon::New<TTableConfig>();
+        simpleConfig->Number = 1;
+        simpleConfig->SnakeCase = "simple_message";
+        simpleConfig->CamelCase = "SimpleMessage";
+        simpleConfig->Scheme = "test_objects.SimpleMessage";
+
+        RegisterRootMessage(simpleConfig);
+
+        simplePath = TMessagePath("simple_message");
+    }
+
+    void TearDown() override {
+        TRelationManager::GetInstance().Clear();
+    }
+
+    // (id > 0 AND name = 'v0') OR (id > 1 AND name = 'v1') OR ...
+    NOrm::NApi::TQuery MakeWideFilter(size_t predicates) {
+        auto idCol = Col(simplePath / "id");
+        auto nameCol = Col(simplePath / "name");
+
+        TExpression filter = idCol > Val(0) && nameCol == Val("v0");
+        for (size_t i = 1; i < predicates; ++i) {
+            filter = filter || (idCol > Val(static_cast<int>(i)) && nameCol == Val("v" + std::to_string(i)));
+        }
+
+        auto query = Select(simplePath, idCol, nameCol);
+        query.Where(filter);
+        query.Limit(100);
+
+        NOrm::NApi::TQuery proto;
+        CreateQuery().AddClause(query).ToProto(&proto);
+        return proto;
+    }
+
+    TMessagePath simplePath;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(QueryViewBenchmark, WideFilter) {
+    auto proto = MakeWideFilter(200);
+    TSqlQueryOrganizer organizer;
+    Builder::TPostgresBuilder builder;
+
+    auto buildDecoded = [&] {
+        TQuery decoded;
+        decoded.FromProto(proto);
+        auto clause = decoded.GetClauses().at(0);
+        TSelect select = clause;
+        return builder.BuildClause(organizer.OrganizeSelect(select));
+    };
+    auto buildView = [&] {
+        return builder.BuildClause(organizer.OrganizeSelect(TQueryView(proto).GetClause(0)));
+    };
+
+    ASSERT_EQ(buildView(), buildDecoded());
+
+    auto decoded = Measure(Iterations, [&] {
+        ASSERT_FALSE(buildDecoded().empty());
+    });
+    auto view = Measure(Iterations, [&] {
+        ASSERT_FALSE(buildView().empty());
+    });
+
+    std::cout << "wide filter (200 predicates, " << proto.clauses_size() << " clauses)"
+        << ": FromProto " << decoded.MicrosPerIteration() << " us, " << decoded.AllocationsPerIteration << " allocs"
+        << "; view " << view.MicrosPerIteration() << " us, " << view.AllocationsPerIteration << " allocs"
+        << std::endl;
+
+    // Представление не строит промежуточное дерево TClauseImpl
+    EXPECT_LT(view.AllocationsPerIteration, decoded.AllocationsPerIteration);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <relation/path.h>
+#include <relation/relation_manager.h>
+#include <tests/proto/test_objects.pb.h>
+#include <tests/common/benchmark.h>
+
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using namespace NOrm::NRelation;
+using NCommon::NTesting::Measure;
+
+constexpr size_t Iterations = 100000;
+
+class PathBenchmark : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_objects::DeepNestedMessage deepNested;
+
+        TRelationManager::GetInstance().Clear();
+
+        auto deepNestedConfig = NCommon::New<TTableConfig>();
+        deepNestedConfig->Number = 3;
+        deepNestedConfig->SnakeCase = "deep_nested_message";
+        deepNestedConfig->CamelCase = "DeepNestedMessage";
+        deepNestedConfig->Scheme = "test_objects.DeepNestedMessage";
+
+        RegisterRootMessage(deepNestedConfig);
+
+        tablePath = TMessagePath(3);
+    }
+
+    void TearDown() override {
+        TRelationManager::GetInstance().Clear();
+    }
+
+    TMessagePath tablePath;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Так ExpandSelector и OrganizeInsert строят колонку: путь от таблицы вглубь,
+// затем таблица и поле по отдельности и поиск по хешу
+TEST_F(PathBenchmark, ExtendAndSplit) {
+    std::unordered_set<TMessagePath> known = {tablePath / 2 / 2 / 1};
+
+    size_t found = 0;
+    auto path = Measure(Iterations, [&] {
+        auto field = tablePath / 2 / 2 / 1;
+        auto table = field.GetTable();
+        auto fieldEntries = field.GetField();
+        found += known.contains(field) && table.size() + fieldEntries.size() == field.size();
+    });
+    EXPECT_EQ(found, Iterations);
+
+    // Те же операции над вектором, как было до встроенного буфера; размер
+    // таблицы берем у менеджера, как это делал прежний GetTable
+    auto& manager = TRelationManager::GetInstance();
+    std::vector<uint32_t> vectorTable = {3};
+    std::unordered_set<size_t> knownHashes = {GetHash(std::vector<uint32_t>{3, 2, 2, 1})};
+    found = 0;
+    auto vector = Measure(Iterations, [&] {
+        auto field = vectorTable;
+        for (uint32_t entry : {2, 2, 1}) {
+            auto next = field;
+            next.push_back(entry);
+            field = std::move(next);
+        }
+        auto tableSize = manager.GetParentTable(field)->GetPath().size();
+        std::vector<uint32_t> table(field.begin(), field.begin() + tableSize);
+        std::vector<uint32_t> fieldEntries(field.begin() + tableSize, field.end());
+        found += knownHashes.contains(GetHash(field)) && table.size() + fieldEntries.size() == field.size();
+    });
+    EXPECT_EQ(found, Iterations);
+
+    std::cout << "extend and split (4 entries)"
+        << ": path " << path.NanosPerIteration << " ns, " << path.AllocationsPerIteration << " allocs"
+        << "; vector " << vector.NanosPerIteration << " ns, " << vector.AllocationsPerIteration << " allocs"
+        << std::endl;
+
+    // Короткие пути целиком живут во встроенном буфере
+    EXPECT_EQ(path.AllocationsPerIteration, 0);
+    EXPECT_LT(path.AllocationsPerIteration, vector.AllocationsPerIteration);
+}
+
+TEST_F(PathBenchmark, CopyLongPath) {
+    std::vector<uint32_t> entries(TMessagePath::InlineCapacity + 1, 1);
+    TMessagePath longPath(entries);
+
+    auto copy = Measure(Iterations, [&] {
+        TMessagePath copied = longPath;
+        ASSERT_EQ(copied.Hash(), longPath.Hash());
+    });
+
+    std::cout << "copy long path (" << entries.size() << " entries)"
+        << ": " << copy.NanosPerIteration << " ns, " << copy.AllocationsPerIteration << " allocs"
+        << std::endl;
+
+    // Длинный путь уходит в кучу одним выделением на копию
+    EXPECT_EQ(copy.AllocationsPerIteration, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -7,7 +7,10 @@
 // Необходима явная инициализация протобуф объектов в наших тестах
 // для правильной регистрации в DescriptorPool::generated_pool()
 #include <google/protobuf/descriptor.h>
+#include <atomic>
 #include <iostream>
+#include <set>
+#include <thread>
 
 namespace {
 
@@ -220,7 +223,7 @@ TEST_F(RelationManagerTest, GetMessagesFromSubtree) {
     for (const auto& [path, msg] : subtreeMessages) {
         if (path == nestedPath) {
             foundNestedMessage = true;
-        } else if (path.data().size() > 1 && path.data().at(0) == 2 && path.String().back() == "simple") {
+        } else if (path.data().size() > 1 && path.at(0) == 2 && path.String().back() == "simple") {
             foundSimpleInNested = true;
         }
     }
@@ -269,9 +272,9 @@ TEST_F(RelationManagerTest, GetMessageWithAncestors) {
     for (const auto& [path, obj] : ancestorObjects) {
         if (path == nestedSimplePath) {
             foundSimple = true;
-        } else if (path.data().size() == 2 && path.data().at(0) == 3 && path.String().back() == "nested") {
+        } else if (path.data().size() == 2 && path.at(0) == 3 && path.String().back() == "nested") {
             foundNested = true;
-        } else if (path.data().size() == 1 && path.data().at(0) == 3) {
+        } else if (path.data().size() == 1 && path.at(0) == 3) {
             foundDeepNested = true;
         }
     }
@@ -486,4 +489,187 @@ TEST_F(RelationManagerTest, EmptyPathHandling) {
     EXPECT_EQ(subtreeMessages.size(), 0);
 }
 
+// Тест неизменности опубликованного снимка схемы
+TEST_F(RelationManagerTest, SnapshotIsImmutable) {
+    RegisterRootMessage(simpleConfig);
+
+    auto& manager = TRelationManager::GetInstance();
+    auto snapshot = manager.GetSnapshot();
+    ASSERT_NE(snapshot->GetRootMessage(snapshot->Resolve(TMessagePath(1))), nullptr);
+
+    RegisterRootMessage(nestedConfig);
+
+    // Старый снимок не видит новую таблицу, менеджер видит
+    EXPECT_EQ(snapshot->GetRootMessage(snapshot->Resolve(TMessagePath(2))), nullptr);
+    EXPECT_NE(manager.GetRootMessage(TMessagePath(2)), nullptr);
+    EXPECT_NE(manager.GetSnapshot(), snapshot);
+}
+
+// Поле, добавленное в уже опубликованную таблицу, не меняет ее описание в старом снимке
+TEST_F(RelationManagerTest, PublishedTableIsNotModified) {
+    RegisterRootMessage(simpleConfig);
+
+    auto& manager = TRelationManager::GetInstance();
+    auto snapshot = manager.GetSnapshot();
+    auto table = snapshot->FindParentTable(snapshot->Resolve(TMessagePath(1)));
+    ASSERT_TRUE(table);
+    auto relatedFields = table->GetRelatedFields();
+    auto primaryFields = table->GetPrimaryFields();
+
+    // Номера 4 в SimpleMessage нет, поле попадает в таблицу новым
+    auto* descriptor = test_objects::DeepNestedMessage::descriptor()->FindFieldByName("numeric_data");
+    manager.RegisterField(std::make_shared<TPrimitiveFieldInfo>(descriptor, TMessagePath(1)));
+
+    EXPECT_EQ(table->GetRelatedFields(), relatedFields);
+    EXPECT_EQ(table->GetPrimaryFields(), primaryFields);
+
+    auto updated = manager.GetParentTable(TMessagePath(1));
+    EXPECT_NE(&*updated, &*table);
+    EXPECT_EQ(updated->GetRelatedFields().size(), relatedFields.size() + 1);
+    EXPECT_EQ(updated->GetPrimaryFields(), primaryFields);
+}
+
+// Тест плотных номеров объектов
+TEST_F(RelationManagerTest, DenseObjectIds) {
+    RegisterRootMessages({simpleConfig, nestedConfig});
+
+    auto& manager = TRelationManager::GetInstance();
+    auto snapshot = manager.GetSnapshot();
+
+    // Каждый номер из [0, count) принадлежит ровно одному пути
+    std::set<TMessagePath> paths;
+    for (TObjectId id = 0; id < snapshot->GetObjectCount(); ++id) {
+        const auto& path = snapshot->GetPath(id);
+        EXPECT_EQ(snapshot->Resolve(path), id);
+        EXPECT_NE(snapshot->GetObject(id), nullptr);
+        paths.insert(path);
+    }
+    EXPECT_EQ(paths.size(), snapshot->GetObjectCount());
+
+    auto id = manager.Resolve(TMessagePath("nested_message/simple/id"));
+    ASSERT_NE(id, InvalidObjectId);
+    EXPECT_EQ(manager.GetPrimitiveField(id), manager.GetPrimitiveField(TMessagePath("nested_message/simple/id")));
+    EXPECT_EQ(snapshot->GetEntryName(id), "id");
+
+    // Вложенное поле знает свое сообщение
+    auto parent = manager.GetParentMessage(manager.GetField(id));
+    ASSERT_NE(parent, nullptr);
+    EXPECT_EQ(parent->GetPath(), TMessagePath("nested_message/simple"));
+
+    EXPECT_EQ(manager.Resolve(TMessagePath(std::vector<uint32_t>{2, 999})), InvalidObjectId);
+    EXPECT_EQ(manager.Resolve(TMessagePath()), InvalidObjectId);
+}
+
+// Тест индекса поддеревьев: результат совпадает с полным перебором
+TEST_F(RelationManagerTest, SubtreeIndexMatchesScan) {
+    RegisterRootMessages({simpleConfig, nestedConfig, deepNestedConfig});
+
+    auto& manager = TRelationManager::GetInstance();
+    auto snapshot = manager.GetSnapshot();
+
+    for (TObjectId id = 0; id < snapshot->GetObjectCount(); ++id) {
+        const auto& root = snapshot->GetPath(id);
+
+        std::vector<TMessagePath> expected;
+        for (TObjectId other = 0; other < snapshot->GetObjectCount(); ++other) {
+            const auto& path = snapshot->GetPath(other);
+            if (snapshot->GetMessage(other) && (path == root || root.isAncestorOf(path))) {
+                expected.push_back(path);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<TMessagePath> actual;
+        for (const auto& [path, message] : manager.GetMessagesFromSubtree(root)) {
+            EXPECT_EQ(message->GetPath(), path);
+            actual.push_back(path);
+        }
+        EXPECT_EQ(actual, expected);
+    }
+}
+
+// Тест: отрезок индекса переживает смену схемы
+TEST_F(RelationManagerTest, SnapshotRangeOutlivesClear) {
+    RegisterRootMessage(deepNestedConfig);
+
+    auto& manager = TRelationManager::GetInstance();
+    TMessagePath nestedPath("deep_nested_message/nested");
+    auto subtree = manager.GetMessagesFromSubtree(TMessagePath(3));
+    auto ancestors = manager.GetObjectWithAncestors(nestedPath / "simple/id");
+
+    manager.Clear();
+    RegisterRootMessage(simpleConfig);
+
+    // deep_nested_message, nested, nested/simple и запись map nested/metadata
+    ASSERT_EQ(subtree.size(), 4u);
+    EXPECT_EQ(subtree.begin()->first, TMessagePath(3));
+    ASSERT_EQ(ancestors.size(), 4u);
+    EXPECT_NE(ancestors.find(nestedPath), ancestors.end());
+    EXPECT_EQ(ancestors.find(TMessagePath(1)), ancestors.end());
+}
+
+// Тест пакетной регистрации таблиц
+TEST_F(RelationManagerTest, RegisterRootMessages) {
+    RegisterRootMessages({simpleConfig, nestedConfig, deepNestedConfig});
+
+    auto& manager = TRelationManager::GetInstance();
+    for (uint32_t number : {1, 2, 3}) {
+        EXPECT_NE(manager.GetRootMessage(TMessagePath(number)), nullptr);
+    }
+    EXPECT_EQ(manager.GetParentTable(TMessagePath("nested_message/simple/id"))->GetPath(), TMessagePath(2));
+}
+
+// Тест публикации: снимок готов сразу после регистрации, пачка публикуется один раз
+TEST_F(RelationManagerTest, PublishesWhenRegistrationEnds) {
+    auto& manager = TRelationManager::GetInstance();
+    RegisterRootMessage(simpleConfig);
+    auto first = manager.GetSnapshot();
+    auto firstVersion = manager.GetSchemaVersion();
+    EXPECT_NE(first->GetRootMessage(first->Resolve(TMessagePath(1))), nullptr);
+    EXPECT_EQ(manager.GetSnapshot(), first);
+    EXPECT_EQ(manager.GetSchemaVersion(), firstVersion);
+
+    RegisterRootMessages({nestedConfig, deepNestedConfig});
+    auto second = manager.GetSnapshot();
+    ASSERT_NE(second, first);
+    EXPECT_EQ(manager.GetSchemaVersion(), firstVersion + 1);
+
+    EXPECT_NE(second->GetRootMessage(second->Resolve(TMessagePath(2))), nullptr);
+    EXPECT_NE(second->GetRootMessage(second->Resolve(TMessagePath(3))), nullptr);
+    EXPECT_EQ(first->Resolve(TMessagePath(3)), InvalidObjectId);
+}
+
+// Тест чтения схемы из нескольких потоков во время регистрации
+TEST_F(RelationManagerTest, ConcurrentLookupsDuringRegistration) {
+    RegisterRootMessage(simpleConfig);
+
+    auto& manager = TRelationManager::GetInstance();
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> misses = 0;
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                if (!manager.GetMessage(TMessagePath(1)) || manager.GetMessagesFromSubtree(TMessagePath(1)).empty()) {
+                    ++misses;
+                }
+                manager.GetObjectWithAncestors(TMessagePath("simple_message/id"));
+            }
+        });
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        RegisterRootMessage(nestedConfig);
+        RegisterRootMessage(deepNestedConfig);
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(misses, 0u);
+    EXPECT_NE(manager.GetMessage(TMessagePath(3)), nullptr);
+}
+
 } // namespace
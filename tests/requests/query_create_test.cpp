@@ -377,6 +377,57 @@ TEST_F(QueryBuilderTest, QueryTest) {
     ASSERT_EQ(newQuery.GetClauses().size(), 2);
 }
 
+// Тест для арены узлов клауз
+TEST_F(QueryBuilderTest, ClauseArenaTest) {
+    auto buildFilter = [&] {
+        auto col = Col(simplePath / "id");
+        TClause filter = col > 0;
+        for (int i = 1; i < 200; ++i) {
+            filter = filter && (col != i);
+        }
+        return Select("simple_message", col).Where(filter);
+    };
+
+    NOrm::NApi::TQuery expected;
+    CreateQuery().AddClause(buildFilter()).ToProto(&expected);
+
+    // Узлы, собранные внутри области, размещаются в арене
+    auto arena = NCommon::New<TClauseArena>();
+    auto query = CreateQuery(arena);
+    {
+        TClauseArenaScope scope(query.GetArena());
+        query.AddClause(buildFilter());
+    }
+    EXPECT_GT(arena->GetAllocatedBytes(), 0u);
+    EXPECT_EQ(GetCurrentClauseArena(), nullptr);
+
+    NOrm::NApi::TQuery actual;
+    query.ToProto(&actual);
+    EXPECT_EQ(actual.SerializeAsString(), expected.SerializeAsString());
+
+    // Узлы продлевают жизнь арены
+    TClause clause;
+    {
+        auto localArena = NCommon::New<TClauseArena>();
+        TClauseArenaScope scope(localArena);
+        clause = Col(simplePath / "name") == Val(std::string("value"));
+    }
+    NOrm::NApi::TQuery single;
+    clause.ToProto(&single);
+    EXPECT_EQ(single.clauses_size(), 3);
+
+    // Разбор запроса из proto использует арену запроса
+    auto parsedArena = NCommon::New<TClauseArena>();
+    auto parsed = CreateQuery(parsedArena);
+    parsed.FromProto(expected);
+    EXPECT_GT(parsedArena->GetAllocatedBytes(), 0u);
+    ASSERT_EQ(parsed.GetClauses().size(), 1u);
+
+    NOrm::NApi::TQuery reparsed;
+    parsed.ToProto(&reparsed);
+    EXPECT_EQ(reparsed.SerializeAsString(), expected.SerializeAsString());
+}
+
 // Тесты для строковых функций
 TEST_F(QueryBuilderTest, StringFunctionsTest) {
     auto str = "Hello World";
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <rpc/admission.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace NRpc;
+
+constexpr size_t Read = 0;
+constexpr size_t Write = 1;
+
+// Записывает, какие запросы запущены и какие отклонены
+struct TJournal {
+    std::vector<std::string> Started;
+    std::vector<std::string> Rejected;
+
+    void Submit(TAdmissionController& controller, size_t route, const std::string& name) {
+        controller.Submit(route, [this, name] { Started.push_back(name); }, [this, name] { Rejected.push_back(name); });
+    }
+};
+
+TEST(AdmissionTest, UnlimitedByDefault) {
+    TAdmissionController controller(0, 0, std::chrono::milliseconds(0));
+    TJournal journal;
+
+    for (int i = 0; i < 100; ++i) {
+        journal.Submit(controller, TAdmissionController::NoRoute, std::to_string(i));
+    }
+    EXPECT_EQ(journal.Started.size(), 100u);
+    EXPECT_EQ(controller.GetStats().InFlight, 100u);
+
+    for (int i = 0; i < 100; ++i) {
+        controller.Release(TAdmissionController::NoRoute);
+    }
+    EXPECT_EQ(controller.GetStats().InFlight, 0u);
+}
+
+TEST(AdmissionTest, GlobalLimitQueuesInOrder) {
+    TAdmissionController controller(2, 0, std::chrono::milliseconds(0));
+    TJournal journal;
+
+    for (auto name : {"a", "b", "c", "d"}) {
+        journal.Submit(controller, Read, name);
+    }
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(controller.GetStats().Queued, 2u);
+
+    controller.Release(Read);
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"a", "b", "c"}));
+    controller.Release(Read);
+    controller.Release(Read);
+    controller.Release(Read);
+    EXPECT_EQ(journal.Started.size(), 4u);
+
+    auto stats = controller.GetStats();
+    EXPECT_EQ(stats.InFlight, 0u);
+    EXPECT_EQ(stats.Queued, 0u);
+    EXPECT_EQ(stats.Admitted, 4u);
+}
+
+TEST(AdmissionTest, RouteLimitDoesNotBlockOtherRoutes) {
+    TAdmissionController controller(0, 0, std::chrono::milliseconds(0));
+    controller.SetPolicy(Write, {.MaxConcurrency = 1});
+    TJournal journal;
+
+    journal.Submit(controller, Write, "w1");
+    journal.Submit(controller, Write, "w2");
+    journal.Submit(controller, Read, "r1");
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"w1", "r1"}));
+
+    controller.Release(Read);
+    EXPECT_EQ(journal.Started.size(), 2u);
+    controller.Release(Write);
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"w1", "r1", "w2"}));
+}
+
+TEST(AdmissionTest, HighPriorityGoesFirst) {
+    TAdmissionController controller(1, 0, std::chrono::milliseconds(0));
+    controller.SetPolicy(Read, {.Priority = EPriority::High});
+    controller.SetPolicy(Write, {.Priority = EPriority::Low});
+    TJournal journal;
+
+    journal.Submit(controller, Write, "w1");
+    journal.Submit(controller, Write, "w2");
+    journal.Submit(controller, TAdmissionController::NoRoute, "n1");
+    journal.Submit(controller, Read, "r1");
+
+    controller.Release(Write);
+    controller.Release(Read);
+    controller.Release(TAdmissionController::NoRoute);
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"w1", "r1", "n1", "w2"}));
+}
+
+TEST(AdmissionTest, QueueOverflowRejects) {
+    TAdmissionController controller(1, 2, std::chrono::milliseconds(0));
+    TJournal journal;
+
+    for (auto name : {"a", "b", "c", "d"}) {
+        journal.Submit(controller, Read, name);
+    }
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"a"}));
+    EXPECT_EQ(journal.Rejected, (std::vector<std::string>{"d"}));
+    EXPECT_EQ(controller.GetStats().Rejected, 1u);
+}
+
+TEST(AdmissionTest, QueueTimeDeadline) {
+    TAdmissionController controller(1, 0, std::chrono::milliseconds(100));
+    controller.SetPolicy(Write, {.MaxQueueTime = std::chrono::milliseconds(10000)});
+    TJournal journal;
+
+    auto start = TAdmissionController::TClock::now();
+    journal.Submit(controller, Read, "r1");
+    journal.Submit(controller, Read, "r2");
+    journal.Submit(controller, Write, "w1");
+
+    auto deadline = controller.GetNextDeadline();
+    ASSERT_TRUE(deadline);
+    EXPECT_LE(*deadline, TAdmissionController::TClock::now() + std::chrono::milliseconds(100));
+
+    controller.ExpireQueued(start + std::chrono::milliseconds(50));
+    EXPECT_TRUE(journal.Rejected.empty());
+
+    controller.ExpireQueued(start + std::chrono::milliseconds(200));
+    EXPECT_EQ(journal.Rejected, (std::vector<std::string>{"r2"}));
+
+    controller.Release(Read);
+    EXPECT_EQ(journal.Started, (std::vector<std::string>{"r1", "w1"}));
+    EXPECT_EQ(controller.GetStats().Queued, 0u);
+}
+
+} // namespace
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <rpc/compression.h>
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+using namespace NRpc;
+
+constexpr size_t Rows = 50000;
+
+// Похоже на выборку из таблицы: повторяющиеся имена полей и значения
+std::string MakeResultSet() {
+    std::string data;
+    for (size_t i = 0; i < Rows; ++i) {
+        data += "{\"id\":" + std::to_string(100000 + i)
+            + ",\"name\":\"user" + std::to_string(i % 1000)
+            + "\",\"email\":\"user" + std::to_string(i % 1000) + "@example.com\""
+            + ",\"status\":\"" + (i % 3 ? "active" : "blocked") + "\"}\n";
+    }
+    return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(CompressionBenchmark, BytesOnWire) {
+    auto data = MakeResultSet();
+
+    std::cout << "identity: " << data.size() << " bytes" << std::endl;
+    for (auto codec : {ECompression::Gzip, ECompression::Zstd}) {
+        if (!IsCompressionSupported(codec)) {
+            continue;
+        }
+        int level = codec == ECompression::Gzip ? 6 : 3;
+
+        auto start = std::chrono::steady_clock::now();
+        auto compressed = Compress(codec, data, level);
+        auto compressTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        auto restored = Decompress(codec, compressed);
+        auto decompressTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_EQ(restored, data);
+        EXPECT_LT(compressed.size(), data.size() / 5);
+        std::cout << GetContentEncoding(codec) << " level " << level << ": " << compressed.size() << " bytes"
+            << " (" << static_cast<double>(data.size()) / compressed.size() << "x)"
+            << "; compress " << compressTime << " ms, decompress " << decompressTime << " ms"
+            << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <rpc/compression.h>
+#include <rpc/http_server.h>
+
+#include <random>
+
+namespace {
+
+using namespace NRpc;
+
+std::string MakeCompressible(size_t size) {
+    std::string data;
+    for (size_t i = 0; data.size() < size; ++i) {
+        data += "row " + std::to_string(i % 97) + ": name=object, status=active;";
+    }
+    data.resize(size);
+    return data;
+}
+
+std::vector<ECompression> SupportedCodecs() {
+    std::vector<ECompression> codecs = {ECompression::Gzip};
+    if (IsCompressionSupported(ECompression::Zstd)) {
+        codecs.push_back(ECompression::Zstd);
+    }
+    return codecs;
+}
+
+TEST(CompressionTest, Negotiation) {
+    bool zstd = IsCompressionSupported(ECompression::Zstd);
+
+    EXPECT_EQ(NegotiateCompression(""), ECompression::None);
+    EXPECT_EQ(NegotiateCompression("identity"), ECompression::None);
+    EXPECT_EQ(NegotiateCompression("gzip"), ECompression::Gzip);
+    EXPECT_EQ(NegotiateCompression("GZIP;q=0.5"), ECompression::Gzip);
+    EXPECT_EQ(NegotiateCompression("gzip, deflate, br"), ECompression::Gzip);
+    EXPECT_EQ(NegotiateCompression("gzip;q=0"), ECompression::None);
+    EXPECT_EQ(NegotiateCompression("*;q=0.1, gzip;q=0"), zstd ? ECompression::Zstd : ECompression::None);
+    EXPECT_EQ(NegotiateCompression("gzip, zstd"), zstd ? ECompression::Zstd : ECompression::Gzip);
+    EXPECT_EQ(NegotiateCompression("gzip;q=1.0, zstd;q=0.5"), ECompression::Gzip);
+    EXPECT_EQ(NegotiateCompression("zstd"), zstd ? ECompression::Zstd : ECompression::None);
+}
+
+TEST(CompressionTest, ParseContentEncoding) {
+    EXPECT_EQ(ParseContentEncoding("identity"), ECompression::None);
+    EXPECT_EQ(ParseContentEncoding(" gzip "), ECompression::Gzip);
+    EXPECT_EQ(ParseContentEncoding("x-gzip"), ECompression::Gzip);
+    EXPECT_EQ(ParseContentEncoding("br"), std::nullopt);
+}
+
+TEST(CompressionTest, RoundTrip) {
+    for (auto codec : SupportedCodecs()) {
+        for (size_t size : {0, 1, 1000, 300000}) {
+            auto data = MakeCompressible(size);
+            auto compressed = Compress(codec, data, 3);
+            if (size >= 1000) {
+                EXPECT_LT(compressed.size(), data.size() / 4) << GetContentEncoding(codec);
+            }
+            EXPECT_EQ(Decompress(codec, compressed), data) << GetContentEncoding(codec);
+        }
+    }
+}
+
+TEST(CompressionTest, StreamCompressorMatchesInput) {
+    std::mt19937 random(1);
+    auto data = MakeCompressible(500000);
+
+    for (auto codec : SupportedCodecs()) {
+        auto compressor = CreateStreamCompressor(codec, 3);
+        std::string compressed;
+        for (size_t offset = 0; offset < data.size();) {
+            size_t part = std::uniform_int_distribution<size_t>(1, 70000)(random);
+            compressor->Write(std::string_view(data).substr(offset, part), &compressed);
+            offset += part;
+        }
+        compressor->Finish(&compressed);
+        EXPECT_EQ(Decompress(codec, compressed), data) << GetContentEncoding(codec);
+    }
+}
+
+TEST(CompressionTest, DecompressionLimits) {
+    for (auto codec : SupportedCodecs()) {
+        auto compressed = Compress(codec, std::string(1024 * 1024, 'z'), 3);
+        EXPECT_THROW(Decompress(codec, compressed, 1000), THttpException);
+
+        // Обрезанные и испорченные данные
+        EXPECT_THROW(Decompress(codec, compressed.substr(0, compressed.size() / 2)), THttpException);
+        EXPECT_THROW(Decompress(codec, "definitely not compressed"), THttpException);
+    }
+}
+
+TEST(CompressionTest, CompressedResponseWriter) {
+    auto data = MakeCompressible(200000);
+
+    for (auto codec : SupportedCodecs()) {
+        std::string body;
+        size_t chunks = 0;
+        TResponseWriter writer([&] (std::vector<std::string> segments) {
+            body += segments[1];
+            ++chunks;
+        }, 4096);
+        writer.SetCompressor(CreateStreamCompressor(codec, 3));
+        writer.Write(data);
+        writer.Finish();
+
+        EXPECT_GT(chunks, 0u);
+        EXPECT_LT(body.size(), data.size() / 4);
+        EXPECT_EQ(writer.ByteCount(), static_cast<int64_t>(data.size()));
+        EXPECT_EQ(Decompress(codec, body), data) << GetContentEncoding(codec);
+    }
+}
+
+} // namespace
@@ -0,0 +1,133 @@
+#include "http_client.h"
+
+#include <common/exception.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+namespace NRpc::NTesting {
+
+////////////////////////////////////////////////////////////////////////////////
+
+THttpTestClient::THttpTestClient(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // Сервер мог еще не начать слушать
+    for (int attempt = 0; attempt < 50; ++attempt) {
+        Socket_ = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT(Socket_ != -1, "Failed to create socket: {}", errno);
+        if (connect(Socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            // Зависший сервер не должен вешать тест
+            timeval timeout{.tv_sec = 5, .tv_usec = 0};
+            setsockopt(Socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            return;
+        }
+        close(Socket_);
+        Socket_ = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    THROW("Failed to connect to port {}", port);
+}
+
+THttpTestClient::~THttpTestClient() {
+    if (Socket_ != -1) {
+        close(Socket_);
+    }
+}
+
+void THttpTestClient::Send(const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        auto result = send(Socket_, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        ASSERT(result > 0, "Failed to send request: {}", errno);
+        offset += result;
+    }
+}
+
+bool THttpTestClient::Fill() {
+    char buffer[16 * 1024];
+    auto result = recv(Socket_, buffer, sizeof(buffer), 0);
+    if (result <= 0) {
+        return false;
+    }
+    Buffer_.append(buffer, result);
+    return true;
+}
+
+THttpReply THttpTestClient::ReadReply() {
+    size_t headersEnd;
+    while ((headersEnd = Buffer_.find("\r\n\r\n")) == std::string::npos) {
+        ASSERT(Fill(), "Connection closed before response headers");
+    }
+
+    THttpReply reply;
+    auto statusEnd = Buffer_.find("\r\n");
+    auto statusLine = Buffer_.substr(0, statusEnd);
+    reply.Status = std::stoi(statusLine.substr(statusLine.find(' ') + 1, 3));
+
+    size_t lineStart = statusEnd + 2;
+    while (lineStart < headersEnd) {
+        auto lineEnd = Buffer_.find("\r\n", lineStart);
+        auto line = Buffer_.substr(lineStart, lineEnd - lineStart);
+        auto colon = line.find(": ");
+        if (colon != std::string::npos) {
+            reply.Headers[line.substr(0, colon)] = line.substr(colon + 2);
+        }
+        lineStart = lineEnd + 2;
+    }
+
+    Buffer_.erase(0, headersEnd + 4);
+
+    if (reply.Headers["Transfer-Encoding"] == "chunked") {
+        while (true) {
+            size_t lineEnd;
+            while ((lineEnd = Buffer_.find("\r\n")) == std::string::npos) {
+                ASSERT(Fill(), "Connection closed before chunk size");
+            }
+            size_t chunkSize = std::stoul(Buffer_.substr(0, lineEnd), nullptr, 16);
+            size_t total = lineEnd + 2 + chunkSize + 2;
+            while (Buffer_.size() < total) {
+                ASSERT(Fill(), "Connection closed inside a chunk");
+            }
+            reply.Body.append(Buffer_, lineEnd + 2, chunkSize);
+            Buffer_.erase(0, total);
+            ++reply.Chunks;
+            if (chunkSize == 0) {
+                return reply;
+            }
+        }
+    }
+
+    size_t bodySize = reply.Headers.contains("Content-Length") ? std::stoul(reply.Headers["Content-Length"]) : 0;
+    while (Buffer_.size() < bodySize) {
+        ASSERT(Fill(), "Connection closed before response body");
+    }
+
+    reply.Body = Buffer_.substr(0, bodySize);
+    Buffer_.erase(0, bodySize);
+    return reply;
+}
+
+bool THttpTestClient::IsClosedByPeer() {
+    return Buffer_.empty() && !Fill();
+}
+
+std::string MakeGetRequest(const std::string& url, const std::string& connection) {
+    std::string request = "GET " + url + " HTTP/1.1\r\nHost: localhost\r\n";
+    if (!connection.empty()) {
+        request += "Connection: " + connection + "\r\n";
+    }
+    return request + "\r\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc::NTesting
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace NRpc::NTesting {
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct THttpReply {
+    int Status = 0;
+    std::unordered_map<std::string, std::string> Headers;
+    std::string Body;
+    // Для chunked ответа: число кусков вместе с завершающим
+    size_t Chunks = 0;
+};
+
+// Простой блокирующий клиент HTTP/1.1 для тестов сервера
+class THttpTestClient {
+public:
+    explicit THttpTestClient(uint16_t port);
+    ~THttpTestClient();
+
+    THttpTestClient(const THttpTestClient&) = delete;
+    THttpTestClient& operator=(const THttpTestClient&) = delete;
+
+    void Send(const std::string& data);
+    // Читает один ответ (Content-Length или chunked); ответы на запросы,
+    // отправленные подряд, читаются по очереди
+    THttpReply ReadReply();
+    // true, если сервер закрыл соединение и непрочитанных данных нет
+    bool IsClosedByPeer();
+
+private:
+    bool Fill();
+
+    int Socket_ = -1;
+    std::string Buffer_;
+};
+
+std::string MakeGetRequest(const std::string& url, const std::string& connection = "");
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NRpc::NTesting
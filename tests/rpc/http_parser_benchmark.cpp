@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <rpc/http_server.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+using namespace NRpc;
+
+constexpr size_t Iterations = 20000;
+
+// Прежний разбор: istringstream, getline и посимвольное копирование тела
+struct TLegacyRequest {
+    std::string Method;
+    std::string Url;
+    std::string Version;
+    std::unordered_map<std::string, std::string> Headers;
+    std::string Body;
+
+    explicit TLegacyRequest(const std::string& data) {
+        std::istringstream recv(data);
+        std::string line;
+        std::getline(recv, line);
+        line.pop_back();
+
+        std::istringstream requestLine(line);
+        requestLine >> Method >> Url >> Version;
+
+        while (std::getline(recv, line) && line != "\r") {
+            auto colon = line.find(": ");
+            if (colon != std::string::npos) {
+                Headers[line.substr(0, colon)] = line.substr(colon + 2, line.size() - colon - 3);
+            }
+        }
+
+        char c;
+        while (recv.get(c)) {
+            Body.push_back(c);
+        }
+    }
+};
+
+std::string MakeRequest(size_t bodySize) {
+    std::string body(bodySize, 'x');
+    return "POST /api/v1/objects/query HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: orm-client/1.0\r\n"
+        "Accept: application/x-protobuf\r\n"
+        "Content-Type: application/x-protobuf\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "\r\n" + body;
+}
+
+template <typename TFunc>
+double MeasureNanos(TFunc&& func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Iterations; ++i) {
+        func();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / Iterations;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(HttpParserBenchmark, StateMachineVersusStringStream) {
+    for (size_t bodySize : {0, 256, 16 * 1024}) {
+        auto data = MakeRequest(bodySize);
+
+        size_t checksum = 0;
+        auto legacy = MeasureNanos([&] {
+            TLegacyRequest request(data);
+            checksum += request.Body.size();
+        });
+
+        // Как в сервере: буфер соединения переходит в запрос без копирования
+        std::string buffer;
+        THttpRequestParser parser;
+        auto stateMachine = MeasureNanos([&] {
+            buffer.assign(data);
+            parser.Reset();
+            ASSERT_TRUE(parser.Parse(buffer));
+            TRequest request(std::move(buffer), parser.ReleaseLayout());
+            checksum += request.GetBody().size();
+        });
+
+        EXPECT_EQ(checksum, 2 * Iterations * bodySize);
+        std::cout << "body " << bodySize << " bytes"
+            << ": istringstream " << legacy << " ns"
+            << "; state machine " << stateMachine << " ns"
+            << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <rpc/http_server.h>
+
+#include <random>
+
+namespace {
+
+using namespace NRpc;
+
+// Разбор буфера, пришедшего кусками заданных размеров
+std::optional<TRequest> ParseByParts(const std::string& data, const std::vector<size_t>& parts) {
+    THttpRequestParser parser;
+    std::string buffer;
+    size_t offset = 0;
+    for (auto part : parts) {
+        buffer.append(data, offset, part);
+        offset += part;
+        if (parser.Parse(buffer)) {
+            auto layout = parser.ReleaseLayout();
+            buffer.resize(layout.Size);
+            return TRequest(std::move(buffer), std::move(layout));
+        }
+    }
+    return std::nullopt;
+}
+
+TEST(HttpParserTest, RequestLineAndHeaders) {
+    TRequest request("GET /objects/1?limit=10 HTTP/1.1\r\nHost: localhost\r\nX-Custom:   padded value  \r\n\r\n");
+
+    EXPECT_EQ(request.GetMethod(), "GET");
+    EXPECT_EQ(request.GetURL(), "/objects/1");
+    EXPECT_EQ(request.GetQuery(), "limit=10");
+    EXPECT_EQ(request.GetVersion(), "HTTP/1.1");
+    EXPECT_EQ(request.GetHeader("Host"), "localhost");
+    EXPECT_EQ(request.GetHeader("x-custom"), "padded value");
+    EXPECT_EQ(request.GetHeader("Missing"), "");
+    EXPECT_EQ(request.GetBody(), "");
+}
+
+TEST(HttpParserTest, ContentLengthBody) {
+    TRequest request("POST /rpc HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello");
+    EXPECT_EQ(request.GetBody(), "hello");
+}
+
+TEST(HttpParserTest, ChunkedBodyIsJoinedInPlace) {
+    TRequest request(
+        "POST /rpc HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n"
+        "1;ext=1\r\n \r\n"
+        "A\r\nworld12345\r\n"
+        "0\r\nTrailer: x\r\n\r\n");
+    EXPECT_EQ(request.GetBody(), "hello world12345");
+}
+
+TEST(HttpParserTest, IncompleteRequest) {
+    THttpRequestParser parser;
+    std::string buffer = "POST /rpc HTTP/1.1\r\nContent-Length: 10\r\n\r\nshort";
+    EXPECT_FALSE(parser.Parse(buffer));
+
+    buffer += "_tail";
+    EXPECT_TRUE(parser.Parse(buffer));
+    EXPECT_EQ(parser.GetLayout().Body.In(buffer), "short_tail");
+    EXPECT_EQ(parser.GetLayout().Size, buffer.size());
+}
+
+TEST(HttpParserTest, PipelinedRequestsInOneBuffer) {
+    std::string buffer =
+        "POST /a HTTP/1.1\r\nContent-Length: 1\r\n\r\nA"
+        "GET /b HTTP/1.1\r\n\r\n";
+
+    THttpRequestParser parser;
+    ASSERT_TRUE(parser.Parse(buffer));
+    auto first = parser.ReleaseLayout();
+    EXPECT_EQ(first.Path.In(buffer), "/a");
+    EXPECT_EQ(first.Body.In(buffer), "A");
+
+    buffer.erase(0, first.Size);
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(buffer));
+    EXPECT_EQ(parser.GetLayout().Path.In(buffer), "/b");
+    EXPECT_EQ(parser.GetLayout().Size, buffer.size());
+}
+
+TEST(HttpParserTest, MalformedRequests) {
+    for (const std::string data : {
+        "GET\r\n\r\n",
+        "GET /\r\n\r\n",
+        "GET  HTTP/1.1\r\n\r\n",
+        "GET / FTP/1.0\r\n\r\n",
+        "GET / HTTP/1.1\r\nNoColon\r\n\r\n",
+        "GET / HTTP/1.1\r\nBad Name: x\r\n\r\n",
+        "GET / HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+        "GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n",
+    }) {
+        EXPECT_THROW(TRequest{data}, THttpException) << data;
+    }
+}
+
+TEST(HttpParserTest, SizeLimit) {
+    THttpRequestParser parser(16);
+    std::string buffer = "GET /very/long/path/without/end";
+    EXPECT_THROW(parser.Parse(buffer), THttpException);
+
+    // Заголовки укладываются в лимит, тело нет
+    THttpRequestParser bodyParser(64);
+    buffer = "GET / HTTP/1.1\r\nContent-Length: 65\r\n\r\n";
+    EXPECT_THROW(bodyParser.Parse(buffer), THttpException);
+}
+
+TEST(HttpParserTest, HeaderLimits) {
+    // Каждая строка короткая и дочитана, но вместе они больше лимита
+    std::string headers;
+    for (int i = 0; i < 20; ++i) {
+        headers += "X-Header-" + std::to_string(i) + ": " + std::string(50, 'v') + "\r\n";
+    }
+    THttpRequestParser sizeParser(1024 * 1024, 1024, 100);
+    std::string buffer = "GET / HTTP/1.1\r\n" + headers + "\r\n";
+    EXPECT_THROW(sizeParser.Parse(buffer), THttpException);
+
+    THttpRequestParser countParser(1024 * 1024, 64 * 1024, 10);
+    EXPECT_THROW(countParser.Parse(buffer), THttpException);
+
+    THttpRequestParser parser(1024 * 1024, 64 * 1024, 20);
+    EXPECT_TRUE(parser.Parse(buffer));
+    EXPECT_EQ(parser.GetLayout().Headers.size(), 20u);
+
+    // Трейлеры ограничены так же, отсчет от их начала
+    THttpRequestParser trailerParser(1024 * 1024, 1024, 100);
+    buffer = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n" + headers + "\r\n";
+    EXPECT_THROW(trailerParser.Parse(buffer), THttpException);
+
+    THttpRequestParser shortTrailerParser(1024 * 1024, 1024, 100);
+    buffer = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\nX-Checksum: 1\r\n\r\n";
+    EXPECT_TRUE(shortTrailerParser.Parse(buffer));
+}
+
+TEST(HttpParserTest, FuzzSplitPoints) {
+    std::mt19937 random(42);
+
+    const std::vector<std::string> requests = {
+        "GET /echo/1?x=1&y=2 HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\n\r\n",
+        "POST /rpc HTTP/1.1\r\nContent-Type: application/x-protobuf\r\nContent-Length: 11\r\n\r\nhello world",
+        "POST /rpc HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n4\r\ndefg\r\n0\r\n\r\n",
+    };
+
+    for (const auto& data : requests) {
+        TRequest expected(data);
+        for (int iteration = 0; iteration < 500; ++iteration) {
+            std::vector<size_t> parts;
+            size_t left = data.size();
+            while (left) {
+                size_t part = std::uniform_int_distribution<size_t>(1, std::min<size_t>(left, 8))(random);
+                parts.push_back(part);
+                left -= part;
+            }
+
+            auto request = ParseByParts(data, parts);
+            ASSERT_TRUE(request);
+            EXPECT_EQ(request->GetMethod(), expected.GetMethod());
+            EXPECT_EQ(request->GetURL(), expected.GetURL());
+            EXPECT_EQ(request->GetQuery(), expected.GetQuery());
+            EXPECT_EQ(request->GetBody(), expected.GetBody());
+        }
+    }
+}
+
+TEST(HttpParserTest, FuzzMutatedInput) {
+    std::mt19937 random(7);
+    const std::string alphabet = "GETPOST /?:;\r\n0123456789abcdefHTP.-chunkedContent-LengthTransfer-Encoding";
+    const std::string seed =
+        "POST /rpc HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 4\r\n\r\n4\r\nbody\r\n0\r\n\r\n";
+
+    for (int iteration = 0; iteration < 20000; ++iteration) {
+        auto data = seed;
+        int mutations = std::uniform_int_distribution<int>(1, 6)(random);
+        for (int i = 0; i < mutations; ++i) {
+            size_t position = std::uniform_int_distribution<size_t>(0, data.size())(random);
+            char symbol = alphabet[std::uniform_int_distribution<size_t>(0, alphabet.size() - 1)(random)];
+            switch (random() % 3) {
+                case 0: data.insert(data.begin() + position, symbol); break;
+                case 1: if (position < data.size()) data.erase(position, 1); break;
+                default: if (position < data.size()) data[position] = symbol; break;
+            }
+        }
+
+        // Разбор завершается, ждет данных или бросает THttpException, и не выходит за буфер
+        THttpRequestParser parser(1024);
+        auto buffer = data;
+        try {
+            if (parser.Parse(buffer)) {
+                const auto& layout = parser.GetLayout();
+                EXPECT_LE(layout.Size, buffer.size());
+                EXPECT_LE(layout.Body.Offset + layout.Body.Size, layout.Size);
+            }
+        } catch (const THttpException&) {
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <rpc/http_router.h>
+
+#include <chrono>
+#include <iostream>
+#include <regex>
+
+namespace {
+
+using namespace NRpc;
+
+constexpr size_t Endpoints = 80;
+constexpr size_t Iterations = 2000;
+
+struct TEndpoint {
+    std::string Method;
+    std::string Pattern;
+    std::string Path;
+};
+
+// Набор, похожий на реальный сервис: ресурсы с литеральными и параметрическими путями
+std::vector<TEndpoint> MakeEndpoints() {
+    std::vector<TEndpoint> endpoints;
+    for (size_t i = 0; endpoints.size() < Endpoints; ++i) {
+        auto resource = "/api/v1/resource" + std::to_string(i);
+        endpoints.push_back({"GET", resource + "/list", resource + "/list"});
+        endpoints.push_back({"POST", resource + "/create", resource + "/create"});
+        endpoints.push_back({"GET", resource + "/[0-9]+", resource + "/12345"});
+        endpoints.push_back({"DELETE", resource + "/[0-9]+", resource + "/12345"});
+    }
+    return endpoints;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(HttpRouterBenchmark, TrieVersusRegexScan) {
+    auto endpoints = MakeEndpoints();
+
+    THttpRouter router;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        auto pattern = endpoints[i].Pattern;
+        if (auto regex = pattern.find("[0-9]+"); regex != std::string::npos) {
+            pattern.replace(regex, 6, "{id:uint}");
+        }
+        router.Add(endpoints[i].Method, pattern, i);
+    }
+
+    // Прежний поиск: regex строится заново для каждого обработчика на каждый запрос
+    size_t legacyChecksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < Iterations / 20; ++iteration) {
+        for (const auto& endpoint : endpoints) {
+            for (size_t i = 0; i < endpoints.size(); ++i) {
+                if (endpoints[i].Method == endpoint.Method && std::regex_match(endpoint.Path, std::regex(endpoints[i].Pattern))) {
+                    legacyChecksum += i;
+                    break;
+                }
+            }
+        }
+    }
+    auto legacy = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+        / (Iterations / 20 * endpoints.size());
+
+    size_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t iteration = 0; iteration < Iterations; ++iteration) {
+        for (const auto& endpoint : endpoints) {
+            auto match = router.Match(endpoint.Method, endpoint.Path);
+            ASSERT_TRUE(match);
+            checksum += match->Route;
+        }
+    }
+    auto trie = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+        / (Iterations * endpoints.size());
+
+    EXPECT_EQ(legacyChecksum * 20, checksum);
+    std::cout << Endpoints << " endpoints: regex scan " << legacy << " ns/request"
+        << "; route trie " << trie << " ns/request"
+        << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <rpc/http_router.h>
+
+namespace {
+
+using namespace NRpc;
+
+std::optional<size_t> Route(const THttpRouter& router, std::string_view method, std::string_view path) {
+    auto match = router.Match(method, path);
+    return match ? std::optional(match->Route) : std::nullopt;
+}
+
+TEST(HttpRouterTest, LiteralRoutes) {
+    THttpRouter router;
+    router.Add("GET", "/", 0);
+    router.Add("GET", "/objects", 1);
+    router.Add("GET", "/objects/list", 2);
+    router.Add("POST", "/objects", 3);
+
+    EXPECT_EQ(Route(router, "GET", "/"), 0u);
+    EXPECT_EQ(Route(router, "GET", "/objects"), 1u);
+    EXPECT_EQ(Route(router, "GET", "/objects/list"), 2u);
+    EXPECT_EQ(Route(router, "POST", "/objects"), 3u);
+
+    EXPECT_EQ(Route(router, "GET", "/objects/"), std::nullopt);
+    EXPECT_EQ(Route(router, "GET", "/objects/list/more"), std::nullopt);
+    EXPECT_EQ(Route(router, "PUT", "/objects"), std::nullopt);
+    EXPECT_EQ(Route(router, "GET", "objects"), std::nullopt);
+}
+
+TEST(HttpRouterTest, TypedParams) {
+    THttpRouter router;
+    router.Add("GET", "/objects/{id:int}", 0);
+    router.Add("GET", "/objects/{name}", 1);
+    router.Add("GET", "/users/{id:uint}/posts/{post}", 2);
+
+    auto match = router.Match("GET", "/objects/-42");
+    ASSERT_TRUE(match);
+    EXPECT_EQ(match->Route, 0u);
+    ASSERT_EQ(match->Params.size(), 1u);
+    EXPECT_EQ(match->Params[0].Name, "id");
+    EXPECT_EQ(match->Params[0].Value, "-42");
+
+    EXPECT_EQ(Route(router, "GET", "/objects/abc"), 1u);
+    EXPECT_EQ(Route(router, "GET", "/objects/"), std::nullopt);
+
+    match = router.Match("GET", "/users/7/posts/hello");
+    ASSERT_TRUE(match);
+    EXPECT_EQ(match->Route, 2u);
+    ASSERT_EQ(match->Params.size(), 2u);
+    EXPECT_EQ(match->Params[0].Value, "7");
+    EXPECT_EQ(match->Params[1].Name, "post");
+    EXPECT_EQ(match->Params[1].Value, "hello");
+
+    EXPECT_EQ(Route(router, "GET", "/users/-7/posts/hello"), std::nullopt);
+}
+
+TEST(HttpRouterTest, CatchAllTail) {
+    THttpRouter router;
+    router.Add("GET", "/static/.*", 0);
+
+    EXPECT_EQ(Route(router, "GET", "/static/"), 0u);
+    EXPECT_EQ(Route(router, "GET", "/static/css/main.css"), 0u);
+    EXPECT_EQ(Route(router, "GET", "/static"), std::nullopt);
+    EXPECT_EQ(Route(router, "GET", "/other/x"), std::nullopt);
+}
+
+TEST(HttpRouterTest, RegexFallback) {
+    THttpRouter router;
+    router.Add("GET", "/files/[a-z]+\\.txt", 0);
+    router.Add("GET", "/files/{name}", 1);
+
+    EXPECT_EQ(Route(router, "GET", "/files/notes.txt"), 0u);
+    EXPECT_EQ(Route(router, "GET", "/files/Notes.txt"), 1u);
+    EXPECT_EQ(Route(router, "GET", "/files/a/b"), std::nullopt);
+}
+
+TEST(HttpRouterTest, FirstRegisteredWins) {
+    THttpRouter router;
+    router.Add("GET", "/a/.*", 0);
+    router.Add("GET", "/a/b", 1);
+    router.Add("GET", "/a/b", 2);
+    router.Add("GET", "/c/b", 3);
+    router.Add("GET", "/c/{x}", 4);
+
+    EXPECT_EQ(Route(router, "GET", "/a/b"), 0u);
+    EXPECT_EQ(Route(router, "GET", "/c/b"), 3u);
+    EXPECT_EQ(Route(router, "GET", "/c/d"), 4u);
+}
+
+TEST(HttpRouterTest, InvalidPatterns) {
+    THttpRouter router;
+    EXPECT_ANY_THROW(router.Add("GET", "/objects/{id:float}", 0));
+    EXPECT_ANY_THROW(router.Add("GET", "/objects/{id}/.+", 0));
+}
+
+} // namespace
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <rpc/service_rpc.h>
+
+#include "http_client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+using namespace NRpc;
+using namespace NRpc::NTesting;
+
+constexpr size_t Requests = 2000;
+constexpr size_t PipelineDepth = 16;
+
+class TPingServer : public TRpcServerBase {
+public:
+    TPingServer(uint16_t port, THttpServerConfigPtr config)
+        : TRpcServerBase("127.0.0.1", port, 4, std::move(config))
+    {
+        RegisterHandler("GET", "/ping", [] (const TRequest&) {
+            return TResponse().SetStatus(EHttpCode::Ok).SetText("pong");
+        });
+    }
+};
+
+// Быстрые чтения и медленные массовые записи, как при тормозящей базе
+class TMixedServer : public TRpcServerBase {
+public:
+    TMixedServer(uint16_t port, TAdmissionPolicy bulkPolicy)
+        : TRpcServerBase("127.0.0.1", port, 4)
+    {
+        RegisterHandler("GET", "/read", [] (const TRequest&) {
+            return TResponse().SetStatus(EHttpCode::Ok).SetText("row");
+        }, false, {.Priority = EPriority::High});
+        RegisterHandler("POST", "/bulk", [] (const TRequest&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return TResponse().SetStatus(EHttpCode::Ok).SetText("done");
+        }, false, bulkPolicy);
+    }
+};
+
+template <typename TFunc>
+double MeasureRps(TFunc&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return Requests / std::chrono::duration<double>(elapsed).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(HttpServerBenchmark, KeepAliveVersusClosePerRequest) {
+    uint16_t port = 30000 + getpid() % 2000;
+    // Все запросы фазы должны пройти по одному соединению
+    auto config = NCommon::New<THttpServerConfig>();
+    config->Load(nlohmann::json::object());
+    config->MaxKeepAliveRequests = Requests + 1;
+
+    auto server = NCommon::New<TPingServer>(port, config);
+    server->Start();
+
+    // Прежнее поведение: новое соединение на каждый запрос
+    auto closePerRequest = MeasureRps([&] {
+        for (size_t i = 0; i < Requests; ++i) {
+            THttpTestClient client(port);
+            client.Send(MakeGetRequest("/ping", "close"));
+            ASSERT_EQ(client.ReadReply().Body, "pong");
+        }
+    });
+
+    auto keepAlive = MeasureRps([&] {
+        THttpTestClient client(port);
+        for (size_t i = 0; i < Requests; ++i) {
+            client.Send(MakeGetRequest("/ping"));
+            ASSERT_EQ(client.ReadReply().Body, "pong");
+        }
+    });
+
+    auto pipelined = MeasureRps([&] {
+        THttpTestClient client(port);
+        std::string batch;
+        for (size_t i = 0; i < PipelineDepth; ++i) {
+            batch += MakeGetRequest("/ping");
+        }
+        for (size_t sent = 0; sent < Requests; sent += PipelineDepth) {
+            client.Send(batch);
+            for (size_t i = 0; i < PipelineDepth; ++i) {
+                ASSERT_EQ(client.ReadReply().Body, "pong");
+            }
+        }
+    });
+
+    std::cout << "requests/sec: close per request " << closePerRequest
+        << "; keep-alive " << keepAlive
+        << "; pipelined (depth " << PipelineDepth << ") " << pipelined
+        << std::endl;
+
+    server->Stop();
+}
+
+TEST(HttpServerBenchmark, ReadLatencyUnderBulkLoad) {
+    constexpr size_t BulkClients = 16;
+    constexpr size_t Reads = 200;
+
+    auto measure = [&] (uint16_t port, TAdmissionPolicy bulkPolicy) {
+        auto server = NCommon::New<TMixedServer>(port, bulkPolicy);
+        server->Start();
+
+        std::atomic<bool> stop = false;
+        std::vector<std::thread> writers;
+        for (size_t i = 0; i < BulkClients; ++i) {
+            writers.emplace_back([&] {
+                THttpTestClient client(port);
+                while (!stop) {
+                    client.Send("POST /bulk HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+                    client.ReadReply();
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::vector<double> latencies;
+        THttpTestClient client(port);
+        for (size_t i = 0; i < Reads; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            client.Send(MakeGetRequest("/read"));
+            EXPECT_EQ(client.ReadReply().Body, "row");
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        stop = true;
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        server->Stop();
+
+        std::sort(latencies.begin(), latencies.end());
+        return std::pair(latencies[Reads / 2], latencies[Reads * 99 / 100]);
+    };
+
+    uint16_t port = 30000 + getpid() % 2000 + 2000;
+    // Прежнее поведение: все запросы в общей очереди пула
+    auto [unlimitedMedian, unlimitedTail] = measure(port, {});
+    auto [limitedMedian, limitedTail] = measure(port + 1, {.MaxConcurrency = 2, .Priority = EPriority::Low});
+
+    EXPECT_LT(limitedTail, unlimitedTail);
+    std::cout << "read latency with " << BulkClients << " bulk writers, ms (p50/p99):"
+        << " unlimited " << unlimitedMedian << "/" << unlimitedTail
+        << "; bulk limited to 2 " << limitedMedian << "/" << limitedTail
+        << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
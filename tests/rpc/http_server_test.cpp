@@ -0,0 +1,516 @@
+#include <gtest/gtest.h>
+#include <rpc/service_rpc.h>
+#include <rpc/socket_handoff.h>
+
+#include "http_client.h"
+
+#include <common/program.h>
+
+#include <atomic>
+#include <csignal>
+#include <thread>
+
+namespace {
+
+using namespace NRpc;
+using namespace NRpc::NTesting;
+
+// Свой порт на каждый сервер, чтобы не зависеть от соединений в TIME_WAIT
+uint16_t NextPort() {
+    // THttpServer принимает порт как short, держимся ниже 32768
+    static std::atomic<uint16_t> port = 20000 + getpid() % 10000;
+    return port++;
+}
+
+class TTestServer : public TRpcServerBase {
+public:
+    TTestServer(uint16_t port, THttpServerConfigPtr config)
+        : TRpcServerBase("127.0.0.1", port, 2, std::move(config))
+    {
+        RegisterHandler("GET", "/echo/.*", [] (const TRequest& request) {
+            return TResponse().SetStatus(EHttpCode::Ok).SetText(std::string(request.GetURL()));
+        });
+        RegisterHandler("GET", "/objects/{id:int}", [] (const TRequest& request) {
+            return TResponse().SetStatus(EHttpCode::Ok).SetText(std::to_string(request.GetPathParam<int64_t>("id") * 2));
+        });
+        RegisterHandler("GET", "/stream/{count:uint}", [] (const TRequest& request) {
+            auto count = request.GetPathParam<size_t>("count");
+            return TResponse().SetStatus(EHttpCode::Ok).SetStream([count] (TResponseWriter& writer) {
+                for (size_t i = 0; i < count; ++i) {
+                    writer.Write(std::to_string(i % 10));
+                }
+            });
+        });
+        RegisterHandler("GET", "/large/{size:uint}", [] (const TRequest& request) {
+            return TResponse().SetStatus(EHttpCode::Ok).SetRaw(std::string(request.GetPathParam<size_t>("size"), 'x'));
+        });
+        RegisterHandler("POST", "/decode", [] (const TRequest& request) {
+            std::string storage;
+            return TResponse().SetStatus(EHttpCode::Ok).SetText(std::string(request.GetDecodedBody(&storage)));
+        });
+        // Имитирует тяжелую запись: не больше одной одновременно, ждать слота недолго
+        RegisterHandler("POST", "/bulk", [] (const TRequest&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(800));
+            return TResponse().SetStatus(EHttpCode::Ok).SetText("done");
+        }, false, TAdmissionPolicy{
+            .MaxConcurrency = 1,
+            .Priority = EPriority::Low,
+            .MaxQueueTime = std::chrono::milliseconds(100),
+        });
+    }
+};
+
+class HttpServerTest : public ::testing::Test {
+protected:
+    void StartServer(uint32_t maxRequests = 1000, std::chrono::milliseconds timeout = std::chrono::seconds(60), const nlohmann::json& overrides = nlohmann::json::object()) {
+        Port = NextPort();
+        Server = CreateServer(Port, maxRequests, timeout, overrides);
+        Server->Start();
+    }
+
+    NCommon::TIntrusivePtr<TTestServer> CreateServer(uint16_t port, uint32_t maxRequests = 1000, std::chrono::milliseconds timeout = std::chrono::seconds(60), const nlohmann::json& overrides = nlohmann::json::object()) {
+        auto config = NCommon::New<THttpServerConfig>();
+        config->Load(overrides);
+        config->MaxKeepAliveRequests = maxRequests;
+        config->KeepAliveTimeout = timeout;
+        // Маленькие куски и очередь, чтобы потоковые ответы упирались в backpressure
+        config->StreamChunkSize = 1024;
+        config->MaxPendingOutput = 4096;
+        return NCommon::New<TTestServer>(port, config);
+    }
+
+    void TearDown() override {
+        if (Server) {
+            Server->Stop();
+        }
+    }
+
+    uint16_t Port = 0;
+    NCommon::TIntrusivePtr<TTestServer> Server;
+};
+
+TEST_F(HttpServerTest, KeepAliveServesSequentialRequests) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    for (int i = 0; i < 3; ++i) {
+        client.Send(MakeGetRequest("/echo/" + std::to_string(i)));
+        auto reply = client.ReadReply();
+        EXPECT_EQ(reply.Status, 200);
+        EXPECT_EQ(reply.Body, "/echo/" + std::to_string(i));
+        EXPECT_EQ(reply.Headers["Connection"], "keep-alive");
+    }
+}
+
+TEST_F(HttpServerTest, PipelinedRequestsInOneWrite) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    std::string batch;
+    for (int i = 0; i < 5; ++i) {
+        batch += MakeGetRequest("/echo/" + std::to_string(i));
+    }
+    client.Send(batch);
+
+    // Ответы приходят в порядке запросов
+    for (int i = 0; i < 5; ++i) {
+        auto reply = client.ReadReply();
+        EXPECT_EQ(reply.Status, 200);
+        EXPECT_EQ(reply.Body, "/echo/" + std::to_string(i));
+    }
+}
+
+TEST_F(HttpServerTest, ConnectionCloseIsHonoured) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    client.Send(MakeGetRequest("/echo/close", "close"));
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Headers["Connection"], "close");
+    EXPECT_TRUE(client.IsClosedByPeer());
+}
+
+TEST_F(HttpServerTest, Http10ClosesByDefault) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    client.Send("GET /echo/old HTTP/1.0\r\n\r\n");
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Body, "/echo/old");
+    EXPECT_EQ(reply.Headers["Connection"], "close");
+    EXPECT_TRUE(client.IsClosedByPeer());
+}
+
+TEST_F(HttpServerTest, MaxRequestsPerConnection) {
+    StartServer(/*maxRequests*/ 2);
+    THttpTestClient client(Port);
+
+    client.Send(MakeGetRequest("/echo/1") + MakeGetRequest("/echo/2") + MakeGetRequest("/echo/3"));
+    EXPECT_EQ(client.ReadReply().Headers["Connection"], "keep-alive");
+    EXPECT_EQ(client.ReadReply().Headers["Connection"], "close");
+    // Третий запрос не обрабатывается, клиент должен переподключиться
+    EXPECT_TRUE(client.IsClosedByPeer());
+}
+
+TEST_F(HttpServerTest, IdleConnectionIsClosed) {
+    StartServer(/*maxRequests*/ 1000, std::chrono::milliseconds(100));
+    THttpTestClient client(Port);
+
+    client.Send(MakeGetRequest("/echo/idle"));
+    EXPECT_EQ(client.ReadReply().Headers["Connection"], "keep-alive");
+    EXPECT_TRUE(client.IsClosedByPeer());
+}
+
+TEST_F(HttpServerTest, TypedPathParams) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    client.Send(MakeGetRequest("/objects/21"));
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Body, "42");
+
+    client.Send(MakeGetRequest("/objects/abc"));
+    EXPECT_EQ(client.ReadReply().Status, 404);
+}
+
+TEST_F(HttpServerTest, StreamedChunkedResponse) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    std::string expected;
+    for (size_t i = 0; i < 100000; ++i) {
+        expected += std::to_string(i % 10);
+    }
+
+    client.Send(MakeGetRequest("/stream/100000"));
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Headers["Transfer-Encoding"], "chunked");
+    EXPECT_FALSE(reply.Headers.contains("Content-Length"));
+    EXPECT_EQ(reply.Body, expected);
+    // 100000 байт кусками по 1024 и завершающий пустой
+    EXPECT_EQ(reply.Chunks, 99u);
+
+    // Соединение переживает потоковый ответ
+    client.Send(MakeGetRequest("/stream/0"));
+    reply = client.ReadReply();
+    EXPECT_EQ(reply.Body, "");
+    EXPECT_EQ(reply.Chunks, 1u);
+}
+
+TEST_F(HttpServerTest, StopWakesBlockedStream) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    // Клиент не читает: обработчик упирается в MaxPendingOutput и ждет места
+    client.Send(MakeGetRequest("/stream/1000000000"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // Деструктор дожидается пула, поток обработчика должен проснуться
+    std::atomic<bool> destroyed = false;
+    std::thread stopping([&] {
+        Server = NCommon::TIntrusivePtr<TTestServer>();
+        destroyed = true;
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!destroyed && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (!destroyed) {
+        stopping.detach();
+        FAIL() << "Server is stuck waiting for the streaming handler";
+    }
+    stopping.join();
+}
+
+TEST_F(HttpServerTest, LargeBodyAfterPipelinedRequest) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    client.Send(MakeGetRequest("/large/4000000") + MakeGetRequest("/echo/after"));
+    EXPECT_EQ(client.ReadReply().Body, std::string(4000000, 'x'));
+    EXPECT_EQ(client.ReadReply().Body, "/echo/after");
+}
+
+TEST_F(HttpServerTest, PipelinedInputIsBounded) {
+    StartServer(1000, std::chrono::seconds(60), {{"max_pipelined_input", 1024}});
+    THttpTestClient client(Port);
+
+    // Клиент не читает, большой ответ застревает в очереди соединения
+    client.Send(MakeGetRequest("/large/4000000"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Пока он не отправлен, сервер читает вперед не больше килобайта,
+    // остальные запросы дочитываются после него
+    std::string batch;
+    for (int i = 0; i < 200; ++i) {
+        batch += MakeGetRequest("/echo/" + std::to_string(i));
+    }
+    client.Send(batch);
+
+    EXPECT_EQ(client.ReadReply().Body, std::string(4000000, 'x'));
+    for (int i = 0; i < 200; ++i) {
+        auto reply = client.ReadReply();
+        EXPECT_EQ(reply.Status, 200);
+        EXPECT_EQ(reply.Body, "/echo/" + std::to_string(i));
+    }
+}
+
+TEST_F(HttpServerTest, CompressedResponses) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    auto acceptGzip = [] (const std::string& url) {
+        return "GET " + url + " HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n";
+    };
+
+    // Меньше порога сжатия
+    client.Send(acceptGzip("/large/100"));
+    auto reply = client.ReadReply();
+    EXPECT_FALSE(reply.Headers.contains("Content-Encoding"));
+    EXPECT_EQ(reply.Body, std::string(100, 'x'));
+
+    client.Send(acceptGzip("/large/100000"));
+    reply = client.ReadReply();
+    EXPECT_EQ(reply.Headers["Content-Encoding"], "gzip");
+    EXPECT_EQ(reply.Headers["Vary"], "Accept-Encoding");
+    EXPECT_LT(reply.Body.size(), 1000u);
+    EXPECT_EQ(Decompress(ECompression::Gzip, reply.Body), std::string(100000, 'x'));
+
+    // Потоковый ответ сжимается независимо от размера
+    client.Send(acceptGzip("/stream/5000"));
+    reply = client.ReadReply();
+    EXPECT_EQ(reply.Headers["Content-Encoding"], "gzip");
+    auto body = Decompress(ECompression::Gzip, reply.Body);
+    ASSERT_EQ(body.size(), 5000u);
+    EXPECT_EQ(body.substr(0, 12), "012345678901");
+}
+
+TEST_F(HttpServerTest, CompressedRequestBody) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    auto compressed = Compress(ECompression::Gzip, "compressed payload", 6);
+    client.Send("POST /decode HTTP/1.1\r\nContent-Encoding: gzip\r\nContent-Length: "
+        + std::to_string(compressed.size()) + "\r\n\r\n" + compressed);
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Body, "compressed payload");
+
+    client.Send("POST /decode HTTP/1.1\r\nContent-Encoding: br\r\nContent-Length: 1\r\n\r\nx");
+    EXPECT_EQ(client.ReadReply().Status, 415);
+}
+
+TEST_F(HttpServerTest, RouteConcurrencyLimit) {
+    StartServer();
+    THttpTestClient first(Port);
+    THttpTestClient second(Port);
+    THttpTestClient reader(Port);
+
+    auto bulk = "POST /bulk HTTP/1.1\r\nContent-Length: 0\r\n\r\n";
+    first.Send(bulk);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Второй тяжелый запрос не дождется слота, легкие проходят без очереди
+    auto start = std::chrono::steady_clock::now();
+    second.Send(bulk);
+    reader.Send(MakeGetRequest("/objects/21"));
+    auto reply = reader.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Body, "42");
+
+    reply = second.ReadReply();
+    EXPECT_EQ(reply.Status, 503);
+    EXPECT_EQ(reply.Headers["Retry-After"], "1");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(600));
+
+    EXPECT_EQ(first.ReadReply().Status, 200);
+
+    // Отказ не закрывает соединение, после освобождения слота запрос проходит
+    second.Send(bulk);
+    EXPECT_EQ(second.ReadReply().Status, 200);
+
+    auto stats = Server->GetAdmissionStats();
+    EXPECT_EQ(stats.InFlight, 0u);
+    EXPECT_EQ(stats.Queued, 0u);
+    EXPECT_EQ(stats.Rejected, 1u);
+}
+
+TEST_F(HttpServerTest, MetricsEndpoint) {
+    StartServer();
+    THttpTestClient client(Port);
+
+    for (int i = 0; i < 3; ++i) {
+        client.Send(MakeGetRequest("/objects/" + std::to_string(i)));
+        EXPECT_EQ(client.ReadReply().Status, 200);
+    }
+    client.Send(MakeGetRequest("/objects/abc"));
+    EXPECT_EQ(client.ReadReply().Status, 404);
+
+    client.Send(MakeGetRequest("/metrics"));
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Headers["Content-Type"], "text/plain; version=0.0.4");
+    EXPECT_NE(reply.Body.find("rpc_requests_total{method=\"GET\",path=\"/objects/{id:int}\",code=\"2xx\"} 3\n"), std::string::npos);
+    EXPECT_NE(reply.Body.find("rpc_handler_duration_seconds_count{method=\"GET\",path=\"/objects/{id:int}\",phase=\"handler\"} 3\n"), std::string::npos);
+    // Сам запрос метрик уже допущен и еще выполняется
+    EXPECT_NE(reply.Body.find("rpc_in_flight_requests 1\n"), std::string::npos);
+}
+
+TEST_F(HttpServerTest, MultipleReactors) {
+    constexpr size_t Reactors = 4;
+    constexpr size_t Clients = 64;
+    StartServer(1000, std::chrono::seconds(60), {{"reactor_count", Reactors}, {"reactor_cpus", {0}}});
+
+    std::vector<std::unique_ptr<THttpTestClient>> clients;
+    for (size_t i = 0; i < Clients; ++i) {
+        clients.push_back(std::make_unique<THttpTestClient>(Port));
+    }
+    for (size_t i = 0; i < Clients; ++i) {
+        clients[i]->Send(MakeGetRequest("/objects/" + std::to_string(i)));
+    }
+    for (size_t i = 0; i < Clients; ++i) {
+        auto reply = clients[i]->ReadReply();
+        EXPECT_EQ(reply.Status, 200);
+        EXPECT_EQ(reply.Body, std::to_string(i * 2));
+    }
+
+    // Ядро раскладывает соединения по сокетам реакторов
+    auto stats = Server->GetReactorStats();
+    ASSERT_EQ(stats.size(), Reactors);
+    uint64_t accepted = 0;
+    size_t busyReactors = 0;
+    for (const auto& reactor : stats) {
+        accepted += reactor.Accepted;
+        busyReactors += reactor.Accepted > 0;
+    }
+    EXPECT_EQ(accepted, Clients);
+    EXPECT_GT(busyReactors, 1u);
+}
+
+TEST_F(HttpServerTest, ManyConcurrentConnections) {
+    StartServer();
+
+    // Соединений намного больше, чем рабочих потоков
+    std::vector<std::unique_ptr<THttpTestClient>> clients;
+    for (int i = 0; i < 200; ++i) {
+        clients.push_back(std::make_unique<THttpTestClient>(Port));
+    }
+    for (size_t i = 0; i < clients.size(); ++i) {
+        clients[i]->Send(MakeGetRequest("/echo/" + std::to_string(i)));
+    }
+    for (size_t i = 0; i < clients.size(); ++i) {
+        EXPECT_EQ(clients[i]->ReadReply().Body, "/echo/" + std::to_string(i));
+    }
+}
+
+TEST_F(HttpServerTest, DrainFinishesAcceptedRequests) {
+    Port = NextPort();
+    Server = CreateServer(Port);
+    std::thread serving([&] {
+        Server->Serve();
+    });
+
+    THttpTestClient bulk(Port);
+    THttpTestClient idle(Port);
+    idle.Send(MakeGetRequest("/objects/1"));
+    EXPECT_EQ(idle.ReadReply().Status, 200);
+    bulk.Send("POST /bulk HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    Server->RequestDrain();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Простаивающее соединение закрыто сразу, новые не принимаются
+    EXPECT_TRUE(idle.IsClosedByPeer());
+    EXPECT_ANY_THROW(THttpTestClient{Port});
+
+    // Принятый запрос выполнен до конца, соединение закрыто после ответа
+    auto reply = bulk.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Body, "done");
+    EXPECT_EQ(reply.Headers["Connection"], "close");
+    EXPECT_TRUE(bulk.IsClosedByPeer());
+
+    serving.join();
+}
+
+TEST_F(HttpServerTest, ListenerHandoff) {
+    Port = NextPort();
+    nlohmann::json config = {{"handoff_socket", "/tmp/rpc_handoff_test_" + std::to_string(getpid()) + ".sock"}};
+    auto previous = CreateServer(Port, 1000, std::chrono::seconds(60), config);
+    std::thread serving([&] {
+        previous->Serve();
+    });
+
+    THttpTestClient old(Port);
+    old.Send(MakeGetRequest("/objects/1"));
+    EXPECT_EQ(old.ReadReply().Status, 200);
+
+    // Новый сервер получает сокеты старого вместо bind и после Start забирает трафик
+    Server = CreateServer(Port, 1000, std::chrono::seconds(60), config);
+    Server->Start();
+    serving.join();
+    EXPECT_TRUE(old.IsClosedByPeer());
+
+    THttpTestClient client(Port);
+    client.Send(MakeGetRequest("/objects/21"));
+    auto reply = client.ReadReply();
+    EXPECT_EQ(reply.Status, 200);
+    EXPECT_EQ(reply.Body, "42");
+    EXPECT_EQ(Server->GetReactorStats().front().Accepted, 1u);
+}
+
+TEST_F(HttpServerTest, HandoffTimeoutFallsBackToBind) {
+    auto path = "/tmp/rpc_handoff_stuck_" + std::to_string(getpid()) + ".sock";
+    // Зависший предыдущий процесс: соединение принято в очередь, сокеты не отдаются
+    THandoffListener stuck(path);
+
+    auto started = std::chrono::steady_clock::now();
+    StartServer(1000, std::chrono::seconds(60), {{"handoff_socket", path}, {"handoff_timeout_ms", 200}});
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(5));
+
+    THttpTestClient client(Port);
+    client.Send(MakeGetRequest("/objects/21"));
+    EXPECT_EQ(client.ReadReply().Body, "42");
+}
+
+TEST_F(HttpServerTest, DrainOnInterrupt) {
+    class TDrainOnInterrupt
+        : public NCommon::TProgramSignalHandlerBase
+    {
+    public:
+        explicit TDrainOnInterrupt(TRpcServerBase* server)
+            : Server_(server)
+        { }
+
+        void OnInterrupt() override {
+            Server_->RequestDrain();
+        }
+
+    private:
+        TRpcServerBase* Server_;
+    };
+
+    Port = NextPort();
+    Server = CreateServer(Port);
+    TDrainOnInterrupt handler(&*Server);
+    NCommon::TProgramSignalHandlerBase::SetupSignalHandlers();
+
+    std::thread serving([&] {
+        Server->Serve();
+    });
+    THttpTestClient client(Port);
+    client.Send(MakeGetRequest("/objects/2"));
+    EXPECT_EQ(client.ReadReply().Body, "4");
+
+    std::raise(SIGTERM);
+    serving.join();
+    EXPECT_TRUE(client.IsClosedByPeer());
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+}
+
+} // namespace
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <rpc/metrics.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace NRpc;
+
+constexpr size_t Iterations = 2000000;
+
+// Цена записи в гистограмму; чтение часов добавляет к ней два вызова now()
+double MeasureRecord(size_t threadCount) {
+    THandlerMetrics metrics("GET", "/objects/{id:int}");
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < Iterations; ++j) {
+                metrics.Record(EHandlerPhase::Handler, std::chrono::nanoseconds(1000 + j % 100000));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(metrics.GetHistogram(EHandlerPhase::Handler).GetCount(), Iterations * threadCount);
+    return elapsed / Iterations;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(MetricsBenchmark, RecordOverhead) {
+    auto single = MeasureRecord(1);
+    auto contended = MeasureRecord(4);
+
+    std::cout << "histogram record: " << single << " ns/record in 1 thread"
+        << "; " << contended << " ns/record per thread in 4 threads"
+        << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
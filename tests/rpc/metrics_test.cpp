@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <rpc/metrics.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace NRpc;
+using namespace std::chrono_literals;
+
+TEST(MetricsTest, BucketBoundaries) {
+    std::mt19937_64 random(7);
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t value = random() >> (random() % 64);
+        auto bucket = TLatencyHistogram::GetBucket(value);
+        ASSERT_LT(bucket, TLatencyHistogram::Buckets);
+
+        auto end = TLatencyHistogram::GetBucketEnd(bucket);
+        auto start = bucket == 0 ? 0 : TLatencyHistogram::GetBucketEnd(bucket - 1);
+        ASSERT_LE(start, value);
+        ASSERT_TRUE(value < end || end == std::numeric_limits<uint64_t>::max());
+        // Относительная ширина интервала не больше 1/SubBuckets
+        ASSERT_LE(end - start, std::max<uint64_t>(1, start / TLatencyHistogram::SubBuckets));
+    }
+
+    EXPECT_EQ(TLatencyHistogram::GetBucket(0), 0u);
+    EXPECT_EQ(TLatencyHistogram::GetBucket(std::numeric_limits<uint64_t>::max()), TLatencyHistogram::Buckets - 1);
+}
+
+TEST(MetricsTest, Quantiles) {
+    TLatencyHistogram histogram;
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.Record(std::chrono::microseconds(i));
+    }
+
+    EXPECT_EQ(histogram.GetCount(), 1000u);
+    EXPECT_EQ(histogram.GetSum(), std::chrono::microseconds(500500));
+
+    auto median = histogram.GetQuantile(0.5);
+    EXPECT_GE(median, 500us);
+    EXPECT_LE(median, 500us * 9 / 8);
+
+    auto tail = histogram.GetQuantile(0.99);
+    EXPECT_GE(tail, 990us);
+    EXPECT_LE(tail, 990us * 9 / 8);
+
+    EXPECT_EQ(histogram.GetCountBelowPowerOfTwo(10), 1u);
+    EXPECT_EQ(histogram.GetCountBelowPowerOfTwo(20), 1000u);
+}
+
+TEST(MetricsTest, ConcurrentRecording) {
+    constexpr int Threads = 4;
+    constexpr int PerThread = 100000;
+
+    THandlerMetrics metrics("GET", "/objects");
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Threads; ++i) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < PerThread; ++j) {
+                metrics.Record(EHandlerPhase::Handler, std::chrono::nanoseconds(j + i));
+                metrics.CountResponse(j % 2 ? 200 : 404);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto& histogram = metrics.GetHistogram(EHandlerPhase::Handler);
+    EXPECT_EQ(histogram.GetCount(), static_cast<uint64_t>(Threads * PerThread));
+    EXPECT_EQ(histogram.GetCountBelowPowerOfTwo(63), static_cast<uint64_t>(Threads * PerThread));
+    EXPECT_EQ(metrics.GetResponseCount(2), static_cast<uint64_t>(Threads * PerThread / 2));
+    EXPECT_EQ(metrics.GetResponseCount(4), static_cast<uint64_t>(Threads * PerThread / 2));
+    EXPECT_EQ(metrics.GetHistogram(EHandlerPhase::Parse).GetCount(), 0u);
+}
+
+TEST(MetricsTest, PrometheusFormat) {
+    TMetricsRegistry registry;
+    auto* objects = registry.Register("GET", "/objects/{id:int}");
+    auto* regex = registry.Register("GET", "/files/\"[a-z]+\\\\.txt");
+    registry.Register("POST", "/unused");
+
+    objects->Record(EHandlerPhase::Handler, 1500ns);
+    objects->Record(EHandlerPhase::Handler, 3ms);
+    objects->CountResponse(200);
+    objects->CountResponse(200);
+    regex->CountResponse(503);
+
+    auto text = registry.Format({.InFlight = 2, .Queued = 1, .Admitted = 10, .Rejected = 3}, {{.Connections = 4, .Accepted = 9}});
+
+    EXPECT_NE(text.find("# TYPE rpc_handler_duration_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_requests_total{method=\"GET\",path=\"/objects/{id:int}\",code=\"2xx\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_requests_total{method=\"GET\",path=\"/files/\\\"[a-z]+\\\\\\\\.txt\",code=\"5xx\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("phase=\"handler\",le=\"1.024e-06\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("phase=\"handler\",le=\"2.048e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("phase=\"handler\",le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_handler_duration_seconds_count{method=\"GET\",path=\"/objects/{id:int}\",phase=\"handler\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_in_flight_requests 2\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_rejected_requests_total 3\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_reactor_connections{reactor=\"0\"} 4\n"), std::string::npos);
+    EXPECT_NE(text.find("rpc_reactor_accepted_total{reactor=\"0\"} 9\n"), std::string::npos);
+
+    // Пустые этапы и обработчики без запросов не выводятся
+    EXPECT_EQ(text.find("phase=\"parse\""), std::string::npos);
+    EXPECT_EQ(text.find("/unused"), std::string::npos);
+}
+
+} // namespace
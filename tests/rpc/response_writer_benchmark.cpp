@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <rpc/http_server.h>
+#include <tests/common/allocation_counter.h>
+
+#include <google/protobuf/wrappers.pb.h>
+
+#include <iostream>
+
+namespace {
+
+using namespace NRpc;
+using NCommon::NTesting::GetLiveBytes;
+using NCommon::NTesting::GetPeakBytes;
+using NCommon::NTesting::ResetPeakBytes;
+
+constexpr size_t MessageSize = 16 * 1024 * 1024;
+constexpr size_t ChunkSize = 64 * 1024;
+
+// Сколько памяти сверх уже занятой понадобилось func в пике, в мегабайтах
+template <typename TFunc>
+double MeasurePeakMb(TFunc&& func) {
+    auto before = GetLiveBytes();
+    ResetPeakBytes();
+    func();
+    return static_cast<double>(GetPeakBytes() - before) / (1024 * 1024);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(ResponseWriterBenchmark, PeakMemoryForLargeProto) {
+    google::protobuf::BytesValue message;
+    message.set_value(std::string(MessageSize, 'r'));
+
+    size_t sent = 0;
+
+    // Прежний путь: временная строка, копия в Body, склейка с заголовками
+    auto legacy = MeasurePeakMb([&] {
+        std::string serialized;
+        ASSERT_TRUE(message.SerializeToString(&serialized));
+        TResponse response;
+        response.SetStatus(EHttpCode::Ok);
+        response.Body = serialized;
+        response.Headers["Content-Length"] = std::to_string(response.Body.size());
+        sent += THandlerBase().FormatResponse(response).size();
+    });
+
+    // Сериализация сразу в Body, заголовки отдельным сегментом
+    auto direct = MeasurePeakMb([&] {
+        TResponse response;
+        response.SetStatus(EHttpCode::Ok);
+        response.Body.resize(message.ByteSizeLong());
+        ASSERT_TRUE(message.SerializeToArray(response.Body.data(), response.Body.size()));
+        response.Headers["Content-Length"] = std::to_string(response.Body.size());
+        sent += THandlerBase().FormatHead(response).size() + response.Body.size();
+    });
+
+    // Потоковый ответ: в памяти только текущий кусок
+    auto streamed = MeasurePeakMb([&] {
+        TResponseWriter writer([&] (std::vector<std::string> segments) {
+            for (const auto& segment : segments) {
+                sent += segment.size();
+            }
+        }, ChunkSize);
+        writer.WriteProto(message);
+        writer.Flush();
+    });
+
+    EXPECT_GT(sent, 3 * MessageSize);
+    std::cout << "peak extra memory for " << MessageSize / (1024 * 1024) << " MB proto"
+        << ": legacy " << legacy << " MB"
+        << "; direct " << direct << " MB"
+        << "; streamed " << streamed << " MB"
+        << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
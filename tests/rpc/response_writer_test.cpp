@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <rpc/response_writer.h>
+
+#include <google/protobuf/wrappers.pb.h>
+
+namespace {
+
+using namespace NRpc;
+
+struct TChunks {
+    std::vector<std::string> Data;
+
+    TResponseWriter::TSink Sink() {
+        return [this] (std::vector<std::string> segments) {
+            ASSERT_EQ(segments.size(), 3u);
+            EXPECT_EQ(std::stoul(segments[0], nullptr, 16), segments[1].size());
+            EXPECT_EQ(segments[0].substr(segments[0].size() - 2), "\r\n");
+            EXPECT_EQ(segments[2], "\r\n");
+            Data.push_back(std::move(segments[1]));
+        };
+    }
+
+    std::string Joined() const {
+        std::string result;
+        for (const auto& chunk : Data) {
+            result += chunk;
+        }
+        return result;
+    }
+};
+
+TEST(ResponseWriterTest, WriteSplitsIntoChunks) {
+    TChunks chunks;
+    TResponseWriter writer(chunks.Sink(), 4);
+
+    writer.Write("abcdefghij");
+    writer.Write("");
+    writer.Flush();
+    writer.Flush();
+
+    EXPECT_EQ(chunks.Data, (std::vector<std::string>{"abcd", "efgh", "ij"}));
+    EXPECT_EQ(writer.ByteCount(), 10);
+}
+
+TEST(ResponseWriterTest, WriteProtoThroughZeroCopyStream) {
+    google::protobuf::BytesValue message;
+    message.set_value(std::string(100000, 'q') + "tail");
+
+    TChunks chunks;
+    TResponseWriter writer(chunks.Sink(), 4096);
+    writer.Write("prefix");
+    writer.WriteProto(message);
+    writer.Flush();
+
+    for (size_t i = 0; i + 1 < chunks.Data.size(); ++i) {
+        EXPECT_EQ(chunks.Data[i].size(), 4096u);
+    }
+
+    auto body = chunks.Joined();
+    ASSERT_EQ(body.substr(0, 6), "prefix");
+    EXPECT_EQ(writer.ByteCount(), static_cast<int64_t>(body.size()));
+
+    google::protobuf::BytesValue parsed;
+    ASSERT_TRUE(parsed.ParseFromString(body.substr(6)));
+    EXPECT_EQ(parsed.value(), message.value());
+}
+
+} // namespace